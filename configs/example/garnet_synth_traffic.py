@@ -29,7 +29,7 @@
 import m5
 from m5.objects import *
 from m5.defines import buildEnv
-from m5.util import addToPath
+from m5.util import addToPath, fatal
 import os, argparse, sys
 
 addToPath("../")
@@ -117,6 +117,47 @@ parser.add_argument(
                         Set to -1 to inject randomly in all vnets.",
 )
 
+parser.add_argument(
+    "--closed-loop",
+    action="store_true",
+    default=False,
+    help="Every request is answered by its destination directory \
+                        (with data to a read, an ack to a write), and \
+                        a core has at most --max-outstanding requests in \
+                        flight. Requires the Garnet_standalone protocol.",
+)
+
+parser.add_argument(
+    "--max-outstanding",
+    type=int,
+    default=4,
+    help="Outstanding requests per core with --closed-loop.",
+)
+
+parser.add_argument(
+    "--think-time",
+    type=int,
+    default=0,
+    help="Cycles before a core reuses a request slot after \
+                        the reply with --closed-loop.",
+)
+
+parser.add_argument(
+    "--response-data-ratio",
+    type=float,
+    default=1.0,
+    help="Fraction of requests answered with data (the rest \
+                        are answered with an ack) with --closed-loop.",
+)
+
+parser.add_argument(
+    "--reply-size",
+    type=int,
+    default=0,
+    help="Payload size in bytes of the data replies with \
+                        --closed-loop (0: the network data message size).",
+)
+
 #
 # Add the ruby specific and protocol specific options
 #
@@ -124,6 +165,13 @@ Ruby.define_options(parser)
 
 args = parser.parse_args()
 
+if args.closed_loop and buildEnv["PROTOCOL"] != "Garnet_standalone":
+    fatal(
+        "--closed-loop needs directories that reply to requests, which "
+        "only the Garnet_standalone protocol has (not %s)"
+        % buildEnv["PROTOCOL"]
+    )
+
 cpus = [
     GarnetSyntheticTraffic(
         num_packets_max=args.num_packets_max,
@@ -135,6 +183,10 @@ cpus = [
         inj_vnet=args.inj_vnet,
         precision=args.precision,
         num_dest=args.num_dirs,
+        closed_loop=args.closed_loop,
+        max_outstanding=args.max_outstanding,
+        think_time=args.think_time,
+        response_data_ratio=args.response_data_ratio,
     )
     for i in range(args.num_cpus)
 ]
@@ -152,6 +204,8 @@ system.clk_domain = SrcClockDomain(
 
 Ruby.create_system(args, False, system)
 
+system.ruby.network.reply_msg_size = args.reply_size
+
 # Create a seperate clock domain for Ruby
 system.ruby.clk_domain = SrcClockDomain(
     clock=args.ruby_clock, voltage_domain=system.voltage_domain
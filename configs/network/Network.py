@@ -47,6 +47,24 @@ def define_options(parser):
         default=0,
         help="the number of rows in the mesh topology",
     )
+    parser.add_argument(
+        "--concentration",
+        type=int,
+        default=1,
+        help="cpus sharing each router of the CMesh topology",
+    )
+    parser.add_argument(
+        "--dragonfly-group-size",
+        type=int,
+        default=4,
+        help="routers per group of the Dragonfly topology",
+    )
+    parser.add_argument(
+        "--dragonfly-global-links",
+        type=int,
+        default=2,
+        help="global links per router of the Dragonfly topology",
+    )
     parser.add_argument(
         "--network",
         default="simple",
@@ -111,6 +129,152 @@ def define_options(parser):
         default=50000,
         help="network-level deadlock threshold.",
     )
+    parser.add_argument(
+        "--garnet-deadlock-detection-interval",
+        action="store",
+        type=int,
+        default=0,
+        help="""cycles between garnet channel dependency graph samples
+            used to detect deadlocks (0 disables detection).""",
+    )
+    parser.add_argument(
+        "--garnet-escape-vc",
+        action="store_true",
+        default=False,
+        help="""reserve an XY-routed escape VC per vnet and use it to
+            recover from detected deadlocks (Mesh only).""",
+    )
+    parser.add_argument(
+        "--garnet-sw-allocator",
+        action="store",
+        type=str,
+        default="RoundRobin",
+        choices=["RoundRobin", "ISlip", "Wavefront", "AgeBased"],
+        help="""switch allocator of the garnet routers.""",
+    )
+    parser.add_argument(
+        "--garnet-vc-allocation",
+        action="store",
+        type=str,
+        default="Fused",
+        choices=["Fused", "Separate", "Speculative"],
+        help="""VC allocation of the garnet routers: fused into SA,
+            a separate stage before SA, or speculative in parallel
+            with SA.""",
+    )
+    parser.add_argument(
+        "--garnet-allocator-iterations",
+        action="store",
+        type=int,
+        default=1,
+        help="""iterations of the iSLIP switch allocator.""",
+    )
+    parser.add_argument(
+        "--garnet-switch-bypass",
+        action="store_true",
+        default=False,
+        help="""let garnet flits that meet no contention skip the router
+            pipeline and traverse the switch in their arrival cycle.""",
+    )
+    parser.add_argument(
+        "--garnet-multicast",
+        action="store_true",
+        default=False,
+        help="""inject garnet messages with several destinations (e.g.
+            invalidations) as one multicast packet forked at the routers
+            instead of one unicast packet per destination.""",
+    )
+    parser.add_argument(
+        "--garnet-power-trace-interval",
+        action="store",
+        type=int,
+        default=0,
+        help="""cycles between samples of the garnet router dynamic
+            power written to garnet_power_trace.csv (0 disables it).""",
+    )
+    parser.add_argument(
+        "--garnet-max-packet-hops",
+        action="store",
+        type=int,
+        default=0,
+        help="""router hops a garnet packet may take before its hop
+            budget is exhausted (0: unlimited).""",
+    )
+    parser.add_argument(
+        "--garnet-max-redirects",
+        action="store",
+        type=int,
+        default=0,
+        help="""times a garnet packet may be redirected before its
+            budget is exhausted (0: unlimited).""",
+    )
+    parser.add_argument(
+        "--garnet-hop-budget-policy",
+        action="store",
+        type=str,
+        default="FORCE_MINIMAL",
+        choices=["DROP_NACK", "FORCE_MINIMAL"],
+        help="""DROP_NACK: drop packets out of budget and re-inject them
+            from the source NI. FORCE_MINIMAL: route them minimally.""",
+    )
+    parser.add_argument(
+        "--garnet-source-routing",
+        action="store_true",
+        default=False,
+        help="""garnet NIs pick the whole trust-weighted path of a packet
+            at injection and the routers follow it (Mesh_XY).""",
+    )
+    parser.add_argument(
+        "--garnet-source-route-epoch",
+        action="store",
+        type=int,
+        default=10000,
+        help="""cycles after which the garnet NIs recompute their cached
+            source routes from the current trust.""",
+    )
+    parser.add_argument(
+        "--garnet-fault-rate-scale",
+        action="store",
+        type=float,
+        default=0.0,
+        help="""with --network-fault-model, scales the fault probability
+            of a garnet router into the probability that a flit it sends
+            is corrupted (0: no corruption).""",
+    )
+    parser.add_argument(
+        "--garnet-fault-schedule",
+        action="append",
+        default=[],
+        help="""inject faults on a garnet link:
+            <router>:<outport direction>:<start cycle>:<end cycle>:<flit
+            corruption probability> (end cycle 0: forever). May be given
+            several times.""",
+    )
+    parser.add_argument(
+        "--garnet-fault-trust-penalty",
+        action="store",
+        type=int,
+        default=1,
+        help="""trust charges on a garnet link per flit corrupted on
+            it.""",
+    )
+    parser.add_argument(
+        "--garnet-ni-compressor",
+        action="store",
+        type=str,
+        default="none",
+        choices=[
+            "none",
+            "BDI",
+            "CPack",
+            "FPC",
+            "FPCD",
+            "RepeatedQwordsCompressor",
+            "ZeroCompressor",
+        ],
+        help="""cache compressor used by the garnet NIs to compress the
+            data of data packets into fewer flits.""",
+    )
     parser.add_argument(
         "--simple-physical-channels",
         action="store_true",
@@ -165,10 +329,42 @@ def init_network(options, network, InterfaceClass):
 
     if options.network == "garnet":
         network.num_rows = options.mesh_rows
+        # Topologies with their own coordinate routing in garnet
+        if options.topology in [
+            "CMesh",
+            "Torus",
+            "FlattenedButterfly",
+            "Dragonfly",
+        ]:
+            network.topology_type = options.topology
+        network.dragonfly_group_size = options.dragonfly_group_size
+        network.dragonfly_global_links = options.dragonfly_global_links
         network.vcs_per_vnet = options.vcs_per_vnet
         network.ni_flit_size = options.link_width_bits / 8
         network.routing_algorithm = options.routing_algorithm
         network.garnet_deadlock_threshold = options.garnet_deadlock_threshold
+        network.deadlock_detection_interval = (
+            options.garnet_deadlock_detection_interval
+        )
+        network.escape_vc_recovery = options.garnet_escape_vc
+        network.sw_allocator = options.garnet_sw_allocator
+        network.vc_allocation = options.garnet_vc_allocation
+        network.allocator_iterations = options.garnet_allocator_iterations
+        network.switch_bypass = options.garnet_switch_bypass
+        network.multicast = options.garnet_multicast
+        network.power_trace_interval = options.garnet_power_trace_interval
+        network.max_packet_hops = options.garnet_max_packet_hops
+        network.max_redirects = options.garnet_max_redirects
+        network.hop_budget_policy = options.garnet_hop_budget_policy
+        network.source_routing = options.garnet_source_routing
+        network.source_route_epoch = options.garnet_source_route_epoch
+        network.fault_rate_scale = options.garnet_fault_rate_scale
+        network.fault_schedule = options.garnet_fault_schedule
+        network.fault_trust_penalty = options.garnet_fault_trust_penalty
+        if options.garnet_ni_compressor != "none":
+            network.ni_compressor = getattr(
+                m5.objects, options.garnet_ni_compressor
+            )()
 
         # Create Bridges and connect them to the corresponding links
         for intLink in network.int_links:
@@ -79,7 +79,10 @@ def create_system(
         # Only one unified L1 cache exists.  Can cache instructions and data.
         #
         l1_cntrl = L1Cache_Controller(
-            version=i, cacheMemory=cache, ruby_system=ruby_system
+            version=i,
+            cacheMemory=cache,
+            closed_loop=getattr(options, "closed_loop", False),
+            ruby_system=ruby_system,
         )
 
         cpu_seq = RubySequencer(
@@ -98,6 +101,7 @@ def create_system(
         l1_cntrl.requestFromCache = MessageBuffer()
         l1_cntrl.responseFromCache = MessageBuffer()
         l1_cntrl.forwardFromCache = MessageBuffer()
+        l1_cntrl.responseToCache = MessageBuffer()
 
     mem_dir_cntrl_nodes, rom_dir_cntrl_node = create_directories(
         options, bootmem, ruby_system, system
@@ -110,6 +114,7 @@ def create_system(
         dir_cntrl.requestToDir = MessageBuffer()
         dir_cntrl.forwardToDir = MessageBuffer()
         dir_cntrl.responseToDir = MessageBuffer()
+        dir_cntrl.responseFromDir = MessageBuffer()
 
     all_cntrls = l1_cntrl_nodes + dir_cntrl_nodes
     ruby_system.network.number_of_virtual_networks = 3
@@ -74,6 +74,15 @@ def define_options(parser):
         help="Should ruby maintain a second copy of memory",
     )
 
+    parser.add_argument(
+        "--ruby-cache-snapshot",
+        action="store",
+        type=str,
+        default="",
+        help="Load the caches and directories from this cache snapshot "
+        "at startup",
+    )
+
     # Options related to cache structure
     parser.add_argument(
         "--ports",
@@ -290,6 +299,9 @@ def create_system(
     ruby._cpu_ports = cpu_sequencers
     ruby.num_of_sequencers = len(cpu_sequencers)
 
+    if options.ruby_cache_snapshot:
+        ruby.cache_snapshot = options.ruby_cache_snapshot
+
     # Create a backing copy of physical memory in case required
     if options.access_backing_store:
         ruby.access_backing_store = True
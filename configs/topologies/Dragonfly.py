@@ -0,0 +1,169 @@
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are
+# met: redistributions of source code must retain the above copyright
+# notice, this list of conditions and the following disclaimer;
+# redistributions in binary form must reproduce the above copyright
+# notice, this list of conditions and the following disclaimer in the
+# documentation and/or other materials provided with the distribution;
+# neither the name of the copyright holders nor the names of its
+# contributors may be used to endorse or promote products derived from
+# this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+# A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+# OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+# DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+# THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+from m5.params import *
+from m5.objects import *
+
+from common import FileSystemConfig
+
+from topologies.BaseTopology import SimpleTopology
+
+# Creates a balanced dragonfly: groups of dragonfly_group_size fully
+# connected routers (outport L<router in group>), each router with
+# dragonfly_global_links links to other groups (outport G<link>), and
+# one global link between every pair of the group_size *
+# global_links + 1 groups. Global link j of a group, at router
+# j // global_links, leads to group (group + j + 1) % num_groups.
+# Garnet routes it on this structure
+# (RoutingUnit::outportComputeDragonfly) with one VC class per global
+# hop: 2 VCs per vnet for minimal routes, 3 to also allow the
+# non-minimal ones through an intermediate group.
+
+
+class Dragonfly(SimpleTopology):
+    description = "Dragonfly"
+
+    def __init__(self, controllers):
+        self.nodes = controllers
+
+    def makeTopology(self, options, network, IntLink, ExtLink, Router):
+        nodes = self.nodes
+
+        group_size = options.dragonfly_group_size
+        global_links = options.dragonfly_global_links
+        assert group_size > 0 and global_links > 0
+        num_groups = group_size * global_links + 1
+        num_routers = group_size * num_groups
+
+        # default values for link latency and router latency.
+        # Can be over-ridden on a per link/router basis
+        link_latency = options.link_latency  # used by simple and garnet
+        router_latency = options.router_latency  # only used by garnet
+
+        # There must be an evenly divisible number of cntrls to routers
+        cntrls_per_router, remainder = divmod(len(nodes), num_routers)
+
+        # Create the routers, group by group
+        routers = [
+            Router(router_id=i, latency=router_latency)
+            for i in range(num_routers)
+        ]
+        network.routers = routers
+
+        # link counter to set unique link ids
+        link_count = 0
+
+        # Add all but the remainder nodes to the list of nodes to be uniformly
+        # distributed across the network.
+        network_nodes = []
+        remainder_nodes = []
+        for node_index in range(len(nodes)):
+            if node_index < (len(nodes) - remainder):
+                network_nodes.append(nodes[node_index])
+            else:
+                remainder_nodes.append(nodes[node_index])
+
+        # Connect each node to the appropriate router
+        ext_links = []
+        for (i, n) in enumerate(network_nodes):
+            cntrl_level, router_id = divmod(i, num_routers)
+            assert cntrl_level < cntrls_per_router
+            ext_links.append(
+                ExtLink(
+                    link_id=link_count,
+                    ext_node=n,
+                    int_node=routers[router_id],
+                    latency=link_latency,
+                )
+            )
+            link_count += 1
+
+        # Connect the remainding nodes to router 0.  These should only be
+        # DMA nodes.
+        for (i, node) in enumerate(remainder_nodes):
+            assert node.type == "DMA_Controller"
+            assert i < remainder
+            ext_links.append(
+                ExtLink(
+                    link_id=link_count,
+                    ext_node=node,
+                    int_node=routers[0],
+                    latency=link_latency,
+                )
+            )
+            link_count += 1
+
+        network.ext_links = ext_links
+
+        int_links = []
+
+        def add_link(src, dst, src_outport, dst_inport):
+            nonlocal link_count
+            int_links.append(
+                IntLink(
+                    link_id=link_count,
+                    src_node=routers[src],
+                    dst_node=routers[dst],
+                    src_outport=src_outport,
+                    dst_inport=dst_inport,
+                    latency=link_latency,
+                    weight=1,
+                )
+            )
+            link_count += 1
+
+        # Local links: all-to-all inside each group
+        for group in range(num_groups):
+            for i in range(group_size):
+                for j in range(group_size):
+                    if i != j:
+                        add_link(
+                            group * group_size + i,
+                            group * group_size + j,
+                            "L%d" % j,
+                            "L%d" % i,
+                        )
+
+        # Global links: link j of a group and link num_groups - j - 2
+        # of the group it leads to are the two directions of a channel
+        for group in range(num_groups):
+            for j in range(group_size * global_links):
+                dst_group = (group + j + 1) % num_groups
+                dst_j = num_groups - j - 2
+                add_link(
+                    group * group_size + j // global_links,
+                    dst_group * group_size + dst_j // global_links,
+                    "G%d" % (j % global_links),
+                    "G%d" % (dst_j % global_links),
+                )
+
+        network.int_links = int_links
+
+    # Register nodes with filesystem
+    def registerTopology(self, options):
+        for i in range(options.num_cpus):
+            FileSystemConfig.register_node(
+                [i], MemorySize(options.mem_size) // options.num_cpus, i
+            )
@@ -34,6 +34,7 @@
 #include <string>
 #include <vector>
 
+#include "base/intmath.hh"
 #include "base/logging.hh"
 #include "base/random.hh"
 #include "base/statistics.hh"
@@ -91,10 +92,24 @@ GarnetSyntheticTraffic::GarnetSyntheticTraffic(const Params &p)
       injVnet(p.inj_vnet),
       precision(p.precision),
       responseLimit(p.response_limit),
+      closedLoop(p.closed_loop),
+      maxOutstanding(p.max_outstanding),
+      thinkTime(p.think_time),
+      responseDataRatio(p.response_data_ratio),
+      numOutstanding(0),
+      destBits(ceilLog2(p.num_dest)),
+      stats(this),
       requestorId(p.system->getRequestorId(this))
 {
     // set up counters
     noResponseCycles = 0;
+    fatal_if(closedLoop && maxOutstanding <= 0,
+             "%s: closed-loop mode needs max_outstanding > 0\n", name());
+    if (closedLoop) {
+        slotBusy.resize(maxOutstanding, false);
+        slotReadyCycle.resize(maxOutstanding, Cycles(0));
+        slotIssueTick.resize(maxOutstanding, 0);
+    }
     schedule(tickEvent, 0);
 
     initTrafficType();
@@ -134,28 +149,67 @@ GarnetSyntheticTraffic::completeRequest(PacketPtr pkt)
 
     assert(pkt->isResponse());
     noResponseCycles = 0;
+
+    if (pkt->isRead())
+        stats.numReads++;
+    else
+        stats.numWrites++;
+
+    if (closedLoop) {
+        // free the request slot encoded in the address
+        int slot = pkt->req->getPaddr() >> (blockSizeBits + destBits);
+        assert(slot < maxOutstanding && slotBusy[slot]);
+        stats.roundTripLatency.sample(
+            ticksToCycles(curTick() - slotIssueTick[slot]));
+        slotBusy[slot] = false;
+        slotReadyCycle[slot] = curCycle() + thinkTime;
+        numOutstanding--;
+    }
+
     delete pkt;
 }
 
+int
+GarnetSyntheticTraffic::freeSlot()
+{
+    for (int slot = 0; slot < maxOutstanding; slot++) {
+        if (!slotBusy[slot] && curCycle() >= slotReadyCycle[slot])
+            return slot;
+    }
+    return -1;
+}
+
 
 void
 GarnetSyntheticTraffic::tick()
 {
+    // in closed-loop mode, no response is expected while idle
+    if (closedLoop && numOutstanding == 0)
+        noResponseCycles = 0;
+
     if (++noResponseCycles >= responseLimit) {
         fatal("%s deadlocked at cycle %d\n", name(), curTick());
     }
 
-    // make new request based on injection rate
-    // (injection rate's range depends on precision)
-    // - generate a random number between 0 and 10^precision
-    // - send pkt if this number is < injRate*(10^precision)
     bool sendAllowedThisCycle;
-    double injRange = pow((double) 10, (double) precision);
-    unsigned trySending = random_mt.random<unsigned>(0, (int) injRange);
-    if (trySending < injRate*injRange)
-        sendAllowedThisCycle = true;
-    else
-        sendAllowedThisCycle = false;
+    int slot = -1;
+    if (closedLoop) {
+        // send a new request if a request slot is free
+        slot = freeSlot();
+        sendAllowedThisCycle = (slot >= 0) && (retryPkt == NULL);
+    } else {
+        // make new request based on injection rate
+        // (injection rate's range depends on precision)
+        // - generate a random number between 0 and 10^precision
+        // - send pkt if this number is < injRate*(10^precision)
+        double injRange = pow((double) 10, (double) precision);
+        unsigned trySending =
+            random_mt.random<unsigned>(0, (int) injRange);
+        if (trySending < injRate*injRange)
+            sendAllowedThisCycle = true;
+        else
+            sendAllowedThisCycle = false;
+    }
 
     // always generatePkt unless fixedPkts or singleSender is enabled
     if (sendAllowedThisCycle) {
@@ -167,7 +221,9 @@ GarnetSyntheticTraffic::tick()
         if (singleSender >= 0 && id != singleSender)
             senderEnable = false;
 
-        if (senderEnable)
+        if (senderEnable && closedLoop)
+            generateClosedLoopPkt(slot);
+        else if (senderEnable)
             generatePkt();
     }
 
@@ -180,8 +236,8 @@ GarnetSyntheticTraffic::tick()
     }
 }
 
-void
-GarnetSyntheticTraffic::generatePkt()
+unsigned
+GarnetSyntheticTraffic::pickDestination()
 {
     int num_destinations = numDestinations;
     int radix = (int) sqrt(num_destinations);
@@ -241,6 +297,14 @@ GarnetSyntheticTraffic::generatePkt()
         fatal("Unknown Traffic Type: %s!\n", traffic);
     }
 
+    return destination;
+}
+
+void
+GarnetSyntheticTraffic::generatePkt()
+{
+    unsigned destination = pickDestination();
+
     // The source of the packets is a cache.
     // The destination of the packets is a directory.
     // The destination bits are embedded in the address after byte-offset.
@@ -323,6 +387,44 @@ GarnetSyntheticTraffic::generatePkt()
     sendPkt(pkt);
 }
 
+void
+GarnetSyntheticTraffic::generateClosedLoopPkt(int slot)
+{
+    unsigned destination = pickDestination();
+
+    // The request slot is embedded in the address above the destination
+    // bits, so the requests in flight never map to the same line.
+    Addr paddr = (Addr(slot) << destBits) | destination;
+    paddr <<= blockSizeBits;
+    unsigned access_size = 1; // Does not affect Ruby simulation
+
+    // Garnet_standalone (closed_loop) sends reads and writes as control
+    // packets in vnet 0. The destination replies in vnet 2 with data
+    // to a read and with an ack (control) to a write.
+    MemCmd::Command requestType =
+        random_mt.random<double>() < responseDataRatio ?
+        MemCmd::ReadReq : MemCmd::WriteReq;
+
+    Request::Flags flags;
+    RequestPtr req = std::make_shared<Request>(paddr, access_size, flags,
+                                               requestorId);
+    req->setContext(id);
+
+    DPRINTF(GarnetSyntheticTraffic,
+            "Generated closed-loop packet with destination %d in slot %d, "
+            "embedded in address %x\n", destination, slot, req->getPaddr());
+
+    PacketPtr pkt = new Packet(req, requestType);
+    pkt->dataDynamic(new uint8_t[req->getSize()]);
+    pkt->senderState = NULL;
+
+    slotBusy[slot] = true;
+    slotIssueTick[slot] = curTick();
+    numOutstanding++;
+
+    sendPkt(pkt);
+}
+
 void
 GarnetSyntheticTraffic::initTrafficType()
 {
@@ -350,4 +452,17 @@ GarnetSyntheticTraffic::printAddr(Addr a)
     cachePort.printAddr(a);
 }
 
+GarnetSyntheticTraffic::GarnetSyntheticTrafficStats::
+GarnetSyntheticTrafficStats(statistics::Group *parent)
+      : statistics::Group(parent),
+      ADD_STAT(numReads, statistics::units::Count::get(),
+               "number of read requests completed"),
+      ADD_STAT(numWrites, statistics::units::Count::get(),
+               "number of write requests completed"),
+      ADD_STAT(roundTripLatency, statistics::units::Cycle::get(),
+               "round-trip latency of closed-loop requests")
+{
+    roundTripLatency.init(10);
+}
+
 } // namespace gem5
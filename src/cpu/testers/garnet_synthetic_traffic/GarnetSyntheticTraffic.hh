@@ -30,6 +30,7 @@
 #define __CPU_GARNET_SYNTHETIC_TRAFFIC_HH__
 
 #include <set>
+#include <vector>
 
 #include "base/statistics.hh"
 #include "mem/port.hh"
@@ -133,11 +134,37 @@ class GarnetSyntheticTraffic : public ClockedObject
 
     const Cycles responseLimit;
 
+    // Closed-loop mode: each core has maxOutstanding request slots. A
+    // slot is busy from the injection of its request until the reply,
+    // and then idle for thinkTime cycles. The slot is encoded in the
+    // address (above the destination) so that the requests in flight
+    // are never coalesced by the sequencer.
+    bool closedLoop;
+    int maxOutstanding;
+    const Cycles thinkTime;
+    double responseDataRatio;
+    int numOutstanding;
+    std::vector<bool> slotBusy;
+    std::vector<Cycles> slotReadyCycle;
+    std::vector<Tick> slotIssueTick;
+    unsigned destBits;
+
+    struct GarnetSyntheticTrafficStats : public statistics::Group
+    {
+        GarnetSyntheticTrafficStats(statistics::Group *parent);
+        statistics::Scalar numReads;
+        statistics::Scalar numWrites;
+        statistics::Histogram roundTripLatency;
+    } stats;
+
     RequestorID requestorId;
 
     void completeRequest(PacketPtr pkt);
 
     void generatePkt();
+    int freeSlot();
+    void generateClosedLoopPkt(int slot);
+    unsigned pickDestination();
     void sendPkt(PacketPtr pkt);
     void initTrafficType();
 
@@ -73,5 +73,25 @@ class GarnetSyntheticTraffic(ClockedObject):
         "Cycles before exiting \
                                             due to lack of progress",
     )
+    closed_loop = Param.Bool(
+        False,
+        "Closed-loop mode: every request is answered "
+        "by its destination, and at most max_outstanding requests are in "
+        "flight (requires closed_loop in the L1 controllers)",
+    )
+    max_outstanding = Param.Int(
+        4, "Outstanding requests per core in closed-loop mode"
+    )
+    think_time = Param.Cycles(
+        0,
+        "Cycles before a core reuses an outstanding "
+        "request slot after the reply in closed-loop mode",
+    )
+    response_data_ratio = Param.Float(
+        1.0,
+        "Fraction of closed-loop requests "
+        "answered with data (reads); the rest are answered with an ack "
+        "(writes)",
+    )
     test = RequestPort("Port to the memory system to test")
     system = Param.System(Parent.any, "System we belong to")
@@ -58,6 +58,8 @@ namespace gem5
 namespace ruby
 {
 
+class MessageBuffer;
+
 class Consumer
 {
   public:
@@ -71,6 +73,8 @@ class Consumer
     virtual void wakeup() = 0;
     virtual void print(std::ostream& out) const = 0;
     virtual void storeEventInfo(int info) {}
+    // Called by a MessageBuffer of this consumer on every enqueue
+    virtual void messageEnqueued(MessageBuffer *buf) {}
 
     bool
     alreadyScheduled(Tick time)
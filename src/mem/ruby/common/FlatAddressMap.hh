@@ -0,0 +1,342 @@
+/*
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __MEM_RUBY_COMMON_FLATADDRESSMAP_HH__
+#define __MEM_RUBY_COMMON_FLATADDRESSMAP_HH__
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "base/intmath.hh"
+#include "mem/ruby/common/Address.hh"
+
+namespace gem5
+{
+
+namespace ruby
+{
+
+/*
+ * Map from addresses to entries for the small, bounded tables that are
+ * probed on every request (TBEs, sequencer request tables). The entries
+ * live in slots preallocated for the expected number of entries and are
+ * found through an open-addressing (Robin Hood) index of (address, slot)
+ * pairs kept at most half full, so lookups touch a few contiguous index
+ * buckets and inserts do not allocate.
+ *
+ * Entries never move: pointers and references to an entry stay valid
+ * until it is erased, as with std::unordered_map. If more entries than
+ * expected are inserted, a new block of slots is added and the index is
+ * rebuilt. Iteration visits the entries in slot order.
+ */
+template<class T>
+class FlatAddressMap
+{
+  public:
+    typedef std::pair<const Addr, T> value_type;
+
+  private:
+    // Storage of an entry, constructed when the slot is taken and
+    // destroyed when it is freed
+    struct Slot
+    {
+        alignas(value_type) unsigned char storage[sizeof(value_type)];
+        bool live = false;
+
+        value_type &
+        get()
+        {
+            return *std::launder(reinterpret_cast<value_type *>(storage));
+        }
+
+        const value_type &
+        get() const
+        {
+            return *std::launder(
+                reinterpret_cast<const value_type *>(storage));
+        }
+    };
+
+    // Index bucket: the address, the slot of its entry and its distance
+    // from its home bucket plus one (0: empty bucket)
+    struct Bucket
+    {
+        Addr key;
+        uint32_t slot;
+        uint32_t dist;
+    };
+
+    template<bool Const>
+    class Iter
+    {
+        typedef typename std::conditional<Const, const FlatAddressMap,
+                                          FlatAddressMap>::type Map;
+        typedef typename std::conditional<Const, const value_type,
+                                          value_type>::type Value;
+
+      public:
+        Iter(Map *map, uint32_t slot) : m_map(map), m_slot(slot) { skip(); }
+
+        Value &operator*() const { return m_map->slotAt(m_slot).get(); }
+        Value *operator->() const { return &m_map->slotAt(m_slot).get(); }
+
+        Iter &
+        operator++()
+        {
+            ++m_slot;
+            skip();
+            return *this;
+        }
+
+        bool operator==(const Iter &o) const { return m_slot == o.m_slot; }
+        bool operator!=(const Iter &o) const { return m_slot != o.m_slot; }
+
+      private:
+        void
+        skip()
+        {
+            while (m_slot < m_map->m_num_slots &&
+                   !m_map->slotAt(m_slot).live) {
+                ++m_slot;
+            }
+        }
+
+        Map *m_map;
+        uint32_t m_slot;
+    };
+
+  public:
+    typedef Iter<false> iterator;
+    typedef Iter<true> const_iterator;
+
+    explicit FlatAddressMap(int expected_entries)
+        : m_block_bits(ceilLog2(std::max(expected_entries, 1))),
+          m_num_slots(0), m_size(0), m_index_bits(0)
+    {
+        addBlock();
+    }
+
+    ~FlatAddressMap() { clear(); }
+
+    FlatAddressMap(const FlatAddressMap &) = delete;
+    FlatAddressMap &operator=(const FlatAddressMap &) = delete;
+
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+
+    iterator begin() { return iterator(this, 0); }
+    iterator end() { return iterator(this, m_num_slots); }
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, m_num_slots); }
+
+    iterator
+    find(Addr key)
+    {
+        int pos = findBucket(key);
+        return pos < 0 ? end() : iterator(this, m_index[pos].slot);
+    }
+
+    const_iterator
+    find(Addr key) const
+    {
+        int pos = findBucket(key);
+        return pos < 0 ? end() : const_iterator(this, m_index[pos].slot);
+    }
+
+    size_t count(Addr key) const { return findBucket(key) < 0 ? 0 : 1; }
+
+    // Constructs the entry of key from args unless key is present
+    template<class... Args>
+    std::pair<iterator, bool>
+    emplace(Addr key, Args&&... args)
+    {
+        int pos = findBucket(key);
+        if (pos >= 0)
+            return {iterator(this, m_index[pos].slot), false};
+
+        if (m_free.empty())
+            addBlock();
+        uint32_t slot = m_free.back();
+        m_free.pop_back();
+
+        Slot &s = slotAt(slot);
+        new (s.storage) value_type(std::piecewise_construct,
+                                   std::forward_as_tuple(key),
+                                   std::forward_as_tuple(
+                                       std::forward<Args>(args)...));
+        s.live = true;
+        m_size++;
+        insertBucket(key, slot);
+        return {iterator(this, slot), true};
+    }
+
+    T &operator[](Addr key) { return emplace(key).first->second; }
+
+    size_t
+    erase(Addr key)
+    {
+        int pos = findBucket(key);
+        if (pos < 0)
+            return 0;
+
+        uint32_t slot = m_index[pos].slot;
+        eraseBucket(pos);
+        freeSlot(slot);
+        return 1;
+    }
+
+    void
+    clear()
+    {
+        for (uint32_t slot = 0; slot < m_num_slots; slot++) {
+            if (slotAt(slot).live)
+                freeSlot(slot);
+        }
+        for (auto &bucket : m_index)
+            bucket.dist = 0;
+    }
+
+  private:
+    Slot &
+    slotAt(uint32_t slot)
+    {
+        return m_blocks[slot >> m_block_bits]
+                       [slot & ((1 << m_block_bits) - 1)];
+    }
+
+    const Slot &
+    slotAt(uint32_t slot) const
+    {
+        return m_blocks[slot >> m_block_bits]
+                       [slot & ((1 << m_block_bits) - 1)];
+    }
+
+    uint32_t
+    home(Addr key) const
+    {
+        // Fibonacci hashing: line addresses differ in their high bits
+        return (key * 0x9e3779b97f4a7c15ULL) >> (64 - m_index_bits);
+    }
+
+    uint32_t
+    next(uint32_t pos) const
+    {
+        return (pos + 1) & (m_index.size() - 1);
+    }
+
+    // Bucket of key in the index, -1 if absent. The search stops at the
+    // first bucket closer to its home than key would be.
+    int
+    findBucket(Addr key) const
+    {
+        uint32_t pos = home(key);
+        for (uint32_t dist = 1; ; dist++, pos = next(pos)) {
+            const Bucket &bucket = m_index[pos];
+            if (bucket.dist < dist)
+                return -1;
+            if (bucket.key == key)
+                return pos;
+        }
+    }
+
+    void
+    insertBucket(Addr key, uint32_t slot)
+    {
+        Bucket cur{key, slot, 1};
+        for (uint32_t pos = home(key); ; pos = next(pos), cur.dist++) {
+            Bucket &bucket = m_index[pos];
+            if (bucket.dist == 0) {
+                bucket = cur;
+                return;
+            }
+            if (bucket.dist < cur.dist)
+                std::swap(bucket, cur);
+        }
+    }
+
+    // Backward-shift deletion: no tombstones
+    void
+    eraseBucket(uint32_t pos)
+    {
+        for (uint32_t n = next(pos); m_index[n].dist > 1; n = next(n)) {
+            m_index[pos] = m_index[n];
+            m_index[pos].dist--;
+            pos = n;
+        }
+        m_index[pos].dist = 0;
+    }
+
+    void
+    freeSlot(uint32_t slot)
+    {
+        Slot &s = slotAt(slot);
+        s.get().~value_type();
+        s.live = false;
+        m_free.push_back(slot);
+        m_size--;
+    }
+
+    // Adds a block of slots and rebuilds the index for the new capacity
+    void
+    addBlock()
+    {
+        uint32_t block_size = 1 << m_block_bits;
+        m_blocks.emplace_back(new Slot[block_size]);
+        for (uint32_t slot = m_num_slots + block_size; slot > m_num_slots; )
+            m_free.push_back(--slot);
+        m_num_slots += block_size;
+
+        m_index_bits = ceilLog2(m_num_slots) + 1;
+        m_index.assign(1 << m_index_bits, Bucket{0, 0, 0});
+        for (uint32_t slot = 0; slot < m_num_slots; slot++) {
+            if (slotAt(slot).live)
+                insertBucket(slotAt(slot).get().first, slot);
+        }
+    }
+
+    const int m_block_bits;
+    std::vector<std::unique_ptr<Slot[]>> m_blocks;
+    uint32_t m_num_slots;
+    size_t m_size;
+    // Free slots, the next one to take at the back
+    std::vector<uint32_t> m_free;
+
+    int m_index_bits;
+    std::vector<Bucket> m_index;
+};
+
+} // namespace ruby
+} // namespace gem5
+
+#endif // __MEM_RUBY_COMMON_FLATADDRESSMAP_HH__
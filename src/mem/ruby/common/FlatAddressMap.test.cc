@@ -0,0 +1,250 @@
+/*
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "mem/ruby/common/FlatAddressMap.hh"
+
+using namespace gem5;
+using namespace gem5::ruby;
+
+namespace
+{
+
+// Line addresses, as the TBE and request tables see them
+Addr
+line(int i)
+{
+    return Addr(i) << 6;
+}
+
+// Checks that map holds exactly the entries of ref
+void
+expectSame(const FlatAddressMap<int> &map, const std::map<Addr, int> &ref)
+{
+    ASSERT_EQ(map.size(), ref.size());
+    ASSERT_EQ(map.empty(), ref.empty());
+    for (const auto &entry : ref) {
+        auto it = map.find(entry.first);
+        ASSERT_NE(it, map.end()) << "address " << entry.first;
+        EXPECT_EQ(it->first, entry.first);
+        EXPECT_EQ(it->second, entry.second);
+    }
+
+    std::map<Addr, int> visited;
+    for (const auto &entry : map)
+        EXPECT_TRUE(visited.emplace(entry.first, entry.second).second);
+    EXPECT_EQ(visited, ref);
+}
+
+} // anonymous namespace
+
+/** Inserted entries are found, and only them. */
+TEST(FlatAddressMapTest, InsertFind)
+{
+    FlatAddressMap<int> map(16);
+    EXPECT_TRUE(map.empty());
+    EXPECT_EQ(map.find(line(0)), map.end());
+
+    for (int i = 0; i < 16; i++) {
+        auto res = map.emplace(line(i), i);
+        EXPECT_TRUE(res.second);
+        EXPECT_EQ(res.first->first, line(i));
+        EXPECT_EQ(res.first->second, i);
+    }
+    EXPECT_EQ(map.size(), 16);
+
+    for (int i = 0; i < 16; i++) {
+        EXPECT_EQ(map.count(line(i)), 1);
+        EXPECT_EQ(map.find(line(i))->second, i);
+    }
+    for (int i = 16; i < 64; i++)
+        EXPECT_EQ(map.count(line(i)), 0);
+}
+
+/** Inserting a present address keeps its entry. */
+TEST(FlatAddressMapTest, InsertPresent)
+{
+    FlatAddressMap<int> map(4);
+    map.emplace(line(3), 1);
+
+    auto res = map.emplace(line(3), 2);
+    EXPECT_FALSE(res.second);
+    EXPECT_EQ(res.first->second, 1);
+    EXPECT_EQ(map.size(), 1);
+
+    map[line(3)] = 5;
+    EXPECT_EQ(map.find(line(3))->second, 5);
+    EXPECT_EQ(map[line(4)], 0);
+    EXPECT_EQ(map.size(), 2);
+}
+
+/**
+ * Erasing shifts the following buckets of a cluster back: the entries
+ * displaced past the erased one are still found, from any position in
+ * the cluster, and erased addresses are not.
+ */
+TEST(FlatAddressMapTest, EraseBackwardShift)
+{
+    // 8 slots, 16 index buckets: 8 entries form clusters
+    std::mt19937 rng(1);
+    for (int round = 0; round < 200; round++) {
+        FlatAddressMap<int> map(8);
+        std::map<Addr, int> ref;
+        std::vector<Addr> keys;
+        for (int i = 0; i < 8; i++) {
+            Addr key = line(rng() % 4096);
+            if (map.emplace(key, i).second) {
+                ref.emplace(key, i);
+                keys.push_back(key);
+            }
+        }
+        expectSame(map, ref);
+
+        std::shuffle(keys.begin(), keys.end(), rng);
+        for (Addr key : keys) {
+            EXPECT_EQ(map.erase(key), 1);
+            EXPECT_EQ(map.erase(key), 0);
+            ref.erase(key);
+            EXPECT_EQ(map.find(key), map.end());
+            expectSame(map, ref);
+        }
+    }
+}
+
+/** A mix of inserts and erases matches std::map. */
+TEST(FlatAddressMapTest, RandomOperations)
+{
+    std::mt19937 rng(2);
+    FlatAddressMap<int> map(32);
+    std::map<Addr, int> ref;
+    for (int i = 0; i < 20000; i++) {
+        Addr key = line(rng() % 64);
+        if (rng() % 2) {
+            EXPECT_EQ(map.emplace(key, i).second, ref.emplace(key, i).second);
+        } else {
+            EXPECT_EQ(map.erase(key), ref.erase(key));
+        }
+        ASSERT_EQ(map.size(), ref.size());
+    }
+    expectSame(map, ref);
+}
+
+/**
+ * Inserting more entries than expected adds slots and rebuilds the
+ * index. The entries are all found afterwards and do not move.
+ */
+TEST(FlatAddressMapTest, Rehash)
+{
+    FlatAddressMap<int> map(2);
+    std::map<Addr, int> ref;
+    std::map<Addr, const int *> where;
+    for (int i = 0; i < 100; i++) {
+        auto res = map.emplace(line(i * 7), i);
+        ASSERT_TRUE(res.second);
+        ref.emplace(line(i * 7), i);
+        where.emplace(line(i * 7), &res.first->second);
+    }
+    expectSame(map, ref);
+
+    for (const auto &entry : where)
+        EXPECT_EQ(&map.find(entry.first)->second, entry.second);
+
+    // The slots of erased entries are reused before new ones are added
+    for (int i = 0; i < 100; i += 2) {
+        map.erase(line(i * 7));
+        ref.erase(line(i * 7));
+    }
+    for (int i = 100; i < 150; i++) {
+        map.emplace(line(i * 7), i);
+        ref.emplace(line(i * 7), i);
+    }
+    expectSame(map, ref);
+    for (int i = 1; i < 100; i += 2)
+        EXPECT_EQ(&map.find(line(i * 7))->second, where[line(i * 7)]);
+}
+
+/** Iteration visits every entry once, and can update the entries. */
+TEST(FlatAddressMapTest, Iteration)
+{
+    FlatAddressMap<int> map(8);
+    EXPECT_EQ(map.begin(), map.end());
+
+    std::map<Addr, int> ref;
+    for (int i = 0; i < 20; i++) {
+        map.emplace(line(i), i);
+        ref.emplace(line(i), i);
+    }
+    for (int i = 0; i < 20; i += 3) {
+        map.erase(line(i));
+        ref.erase(line(i));
+    }
+    expectSame(map, ref);
+
+    for (auto &entry : map)
+        entry.second *= 2;
+    for (auto &entry : ref)
+        entry.second *= 2;
+    expectSame(map, ref);
+}
+
+/** Erased and cleared entries are destroyed; the map is reusable. */
+TEST(FlatAddressMapTest, Clear)
+{
+    auto token = std::make_shared<int>(0);
+    FlatAddressMap<std::shared_ptr<int>> map(4);
+    for (int i = 0; i < 10; i++)
+        map.emplace(line(i), token);
+    EXPECT_EQ(token.use_count(), 11);
+
+    map.erase(line(0));
+    EXPECT_EQ(token.use_count(), 10);
+
+    map.clear();
+    EXPECT_EQ(token.use_count(), 1);
+    EXPECT_TRUE(map.empty());
+    EXPECT_EQ(map.begin(), map.end());
+    for (int i = 0; i < 10; i++)
+        EXPECT_EQ(map.count(line(i)), 0);
+
+    map.emplace(line(3), token);
+    EXPECT_EQ(map.size(), 1);
+    EXPECT_EQ(map.find(line(3))->second, token);
+
+    {
+        FlatAddressMap<std::shared_ptr<int>> scoped(4);
+        scoped.emplace(line(1), token);
+        EXPECT_EQ(token.use_count(), 3);
+    }
+    EXPECT_EQ(token.use_count(), 2);
+}
@@ -36,14 +36,22 @@ namespace gem5
 namespace ruby
 {
 
-NetDest::NetDest()
-{
-  resize();
-}
-
 void
 NetDest::add(MachineID newElement)
 {
+    if (isList()) {
+        assert(bitIndex(newElement.num) <
+               MachineType_base_count(newElement.type));
+        for (int i = 0; i < m_list_size; i++) {
+            if (m_list[i] == newElement)
+                return;
+        }
+        if (m_list_size < ListSize) {
+            m_list[m_list_size++] = newElement;
+            return;
+        }
+        resize();
+    }
     assert(bitIndex(newElement.num) < m_bits[vecIndex(newElement)].getSize());
     m_bits[vecIndex(newElement)].add(bitIndex(newElement.num));
 }
@@ -51,7 +59,13 @@ NetDest::add(MachineID newElement)
 void
 NetDest::addNetDest(const NetDest& netDest)
 {
-    assert(m_bits.size() == netDest.getSize());
+    if (netDest.isList()) {
+        for (int i = 0; i < netDest.m_list_size; i++) {
+            add(netDest.m_list[i]);
+        }
+        return;
+    }
+    resize();
     for (int i = 0; i < m_bits.size(); i++) {
         m_bits[i].addSet(netDest.m_bits[i]);
     }
@@ -63,35 +77,61 @@ NetDest::setNetDest(MachineType machine, const Set& set)
     // assure that there is only one set of destinations for this machine
     assert(MachineType_base_level((MachineType)(machine + 1)) -
            MachineType_base_level(machine) == 1);
+    resize();
     m_bits[MachineType_base_level(machine)] = set;
 }
 
 void
 NetDest::remove(MachineID oldElement)
 {
+    if (isList()) {
+        for (int i = 0; i < m_list_size; i++) {
+            if (m_list[i] == oldElement) {
+                m_list[i] = m_list[--m_list_size];
+                return;
+            }
+        }
+        return;
+    }
     m_bits[vecIndex(oldElement)].remove(bitIndex(oldElement.num));
 }
 
 void
 NetDest::removeNetDest(const NetDest& netDest)
 {
-    assert(m_bits.size() == netDest.getSize());
-    for (int i = 0; i < m_bits.size(); i++) {
-        m_bits[i].removeSet(netDest.m_bits[i]);
+    if (&netDest == this) {
+        clear();
+    } else if (netDest.isList()) {
+        for (int i = 0; i < netDest.m_list_size; i++) {
+            remove(netDest.m_list[i]);
+        }
+    } else if (isList()) {
+        int size = 0;
+        for (int i = 0; i < m_list_size; i++) {
+            if (!netDest.isElement(m_list[i]))
+                m_list[size++] = m_list[i];
+        }
+        m_list_size = size;
+    } else {
+        for (int i = 0; i < m_bits.size(); i++) {
+            m_bits[i].removeSet(netDest.m_bits[i]);
+        }
     }
 }
 
 void
 NetDest::clear()
 {
-    for (int i = 0; i < m_bits.size(); i++) {
-        m_bits[i].clear();
-    }
+    // Back to the list. This frees the bit vectors: a set that grows past
+    // the list again sets them up anew.
+    m_bits.clear();
+    m_list_size = 0;
 }
 
 void
 NetDest::broadcast()
 {
+    resize();
     for (MachineType machine = MachineType_FIRST;
          machine < MachineType_NUM; ++machine) {
         broadcast(machine);
@@ -113,9 +153,10 @@ NetDest::getAllDest()
 {
     std::vector<NodeID> dest;
     dest.clear();
-    for (int i = 0; i < m_bits.size(); i++) {
-        for (int j = 0; j < m_bits[i].getSize(); j++) {
-            if (m_bits[i].isElement(j)) {
+    for (int i = 0; i < MachineType_NUM; i++) {
+        MachineType machine = MachineType_from_base_level(i);
+        for (NodeID j = 0; j < MachineType_base_count(machine); j++) {
+            if (isElement(MachineID(machine, j))) {
                 int id = MachineType_base_number((MachineType)i) + j;
                 dest.push_back((NodeID)id);
             }
@@ -127,6 +168,9 @@ NetDest::getAllDest()
 int
 NetDest::count() const
 {
+    if (isList())
+        return m_list_size;
+
     int counter = 0;
     for (int i = 0; i < m_bits.size(); i++) {
         counter += m_bits[i].count();
@@ -137,13 +181,25 @@ NetDest::count() const
 NodeID
 NetDest::elementAt(MachineID index)
 {
-    return m_bits[vecIndex(index)].elementAt(bitIndex(index.num));
+    return isElement(index);
 }
 
 MachineID
 NetDest::smallestElement() const
 {
     assert(count() > 0);
+    if (isList()) {
+        MachineID smallest = m_list[0];
+        for (int i = 1; i < m_list_size; i++) {
+            int level = MachineType_base_level(m_list[i].type);
+            int smallest_level = MachineType_base_level(smallest.type);
+            if (level < smallest_level ||
+                (level == smallest_level && m_list[i].num < smallest.num)) {
+                smallest = m_list[i];
+            }
+        }
+        return smallest;
+    }
     for (int i = 0; i < m_bits.size(); i++) {
         for (NodeID j = 0; j < m_bits[i].getSize(); j++) {
             if (m_bits[i].isElement(j)) {
@@ -158,6 +214,19 @@ NetDest::smallestElement() const
 MachineID
 NetDest::smallestElement(MachineType machine) const
 {
+    if (isList()) {
+        int smallest = -1;
+        for (int i = 0; i < m_list_size; i++) {
+            if (m_list[i].type == machine &&
+                (smallest < 0 || m_list[i].num < m_list[smallest].num)) {
+                smallest = i;
+            }
+        }
+        if (smallest >= 0)
+            return m_list[smallest];
+        panic("No smallest element of given MachineType.");
+    }
+
     int size = m_bits[MachineType_base_level(machine)].getSize();
     for (NodeID j = 0; j < size; j++) {
         if (m_bits[MachineType_base_level(machine)].isElement(j)) {
@@ -173,6 +242,15 @@ NetDest::smallestElement(MachineType machine) const
 bool
 NetDest::isBroadcast() const
 {
+    if (isList()) {
+        int num_machines = 0;
+        for (MachineType machine = MachineType_FIRST;
+             machine < MachineType_NUM; ++machine) {
+            num_machines += MachineType_base_count(machine);
+        }
+        return m_list_size == num_machines;
+    }
+
     for (int i = 0; i < m_bits.size(); i++) {
         if (!m_bits[i].isBroadcast()) {
             return false;
@@ -185,6 +263,9 @@ NetDest::isBroadcast() const
 bool
 NetDest::isEmpty() const
 {
+    if (isList())
+        return m_list_size == 0;
+
     for (int i = 0; i < m_bits.size(); i++) {
         if (!m_bits[i].isEmpty()) {
             return false;
@@ -197,11 +278,8 @@ NetDest::isEmpty() const
 NetDest
 NetDest::OR(const NetDest& orNetDest) const
 {
-    assert(m_bits.size() == orNetDest.getSize());
-    NetDest result;
-    for (int i = 0; i < m_bits.size(); i++) {
-        result.m_bits[i] = m_bits[i].OR(orNetDest.m_bits[i]);
-    }
+    NetDest result(*this);
+    result.addNetDest(orNetDest);
     return result;
 }
 
@@ -209,8 +287,18 @@ NetDest::OR(const NetDest& orNetDest) const
 NetDest
 NetDest::AND(const NetDest& andNetDest) const
 {
-    assert(m_bits.size() == andNetDest.getSize());
     NetDest result;
+    if (isList() || andNetDest.isList()) {
+        const NetDest &list = isList() ? *this : andNetDest;
+        const NetDest &other = isList() ? andNetDest : *this;
+        for (int i = 0; i < list.m_list_size; i++) {
+            if (other.isElement(list.m_list[i]))
+                result.add(list.m_list[i]);
+        }
+        return result;
+    }
+
+    result.resize();
     for (int i = 0; i < m_bits.size(); i++) {
         result.m_bits[i] = m_bits[i].AND(andNetDest.m_bits[i]);
     }
@@ -221,7 +309,16 @@ NetDest::AND(const NetDest& andNetDest) const
 bool
 NetDest::intersectionIsNotEmpty(const NetDest& other_netDest) const
 {
-    assert(m_bits.size() == other_netDest.getSize());
+    if (isList() || other_netDest.isList()) {
+        const NetDest &list = isList() ? *this : other_netDest;
+        const NetDest &other = isList() ? other_netDest : *this;
+        for (int i = 0; i < list.m_list_size; i++) {
+            if (other.isElement(list.m_list[i]))
+                return true;
+        }
+        return false;
+    }
+
     for (int i = 0; i < m_bits.size(); i++) {
         if (!m_bits[i].intersectionIsEmpty(other_netDest.m_bits[i])) {
             return true;
@@ -233,7 +330,13 @@ NetDest::intersectionIsNotEmpty(const NetDest& other_netDest) const
 bool
 NetDest::isSuperset(const NetDest& test) const
 {
-    assert(m_bits.size() == test.getSize());
+    if (isList() || test.isList()) {
+        bool superset = true;
+        test.forEachElement([&](MachineID machine) {
+            superset = superset && isElement(machine);
+        });
+        return superset;
+    }
 
     for (int i = 0; i < m_bits.size(); i++) {
         if (!m_bits[i].isSuperset(test.m_bits[i])) {
@@ -246,28 +349,46 @@ NetDest::isSuperset(const NetDest& test) const
 bool
 NetDest::isElement(MachineID element) const
 {
+    if (isList()) {
+        for (int i = 0; i < m_list_size; i++) {
+            if (m_list[i] == element)
+                return true;
+        }
+        return false;
+    }
     return ((m_bits[vecIndex(element)])).isElement(bitIndex(element.num));
 }
 
+// Switches to the bit vectors, which hold all the sets larger than
+// ListSize
 void
 NetDest::resize()
 {
+    if (!isList())
+        return;
+
     m_bits.resize(MachineType_base_level(MachineType_NUM));
     assert(m_bits.size() == MachineType_NUM);
 
     for (int i = 0; i < m_bits.size(); i++) {
         m_bits[i].setSize(MachineType_base_count((MachineType)i));
     }
+
+    for (int i = 0; i < m_list_size; i++) {
+        m_bits[vecIndex(m_list[i])].add(bitIndex(m_list[i].num));
+    }
+    m_list_size = 0;
 }
 
 void
 NetDest::print(std::ostream& out) const
 {
-    out << "[NetDest (" << m_bits.size() << ") ";
+    out << "[NetDest (" << getSize() << ") ";
 
-    for (int i = 0; i < m_bits.size(); i++) {
-        for (int j = 0; j < m_bits[i].getSize(); j++) {
-            out << (bool) m_bits[i].isElement(j) << " ";
+    for (int i = 0; i < getSize(); i++) {
+        MachineType machine = MachineType_from_base_level(i);
+        for (NodeID j = 0; j < MachineType_base_count(machine); j++) {
+            out << (bool) isElement(MachineID(machine, j)) << " ";
         }
         out << " - ";
     }
@@ -277,6 +398,9 @@ NetDest::print(std::ostream& out) const
 bool
 NetDest::isEqual(const NetDest& n) const
 {
+    if (isList() || n.isList())
+        return count() == n.count() && isSuperset(n);
+
     assert(m_bits.size() == n.m_bits.size());
     for (unsigned int i = 0; i < m_bits.size(); ++i) {
         if (!m_bits[i].isEqual(n.m_bits[i]))
@@ -42,12 +42,17 @@ namespace ruby
 {
 
 // NetDest specifies the network destination of a Message
+//
+// Up to ListSize machines are kept in a list inside the NetDest. Only
+// larger sets switch to a bit vector per machine type, so the common
+// single-destination messages and small sharer sets of cache and
+// directory entries neither allocate nor scale with the system size.
 class NetDest
 {
   public:
     // Constructors
     // creates and empty set
-    NetDest();
+    NetDest() : m_list_size(0) { }
     explicit NetDest(int bit_size);
 
     NetDest& operator=(const Set& obj);
@@ -91,7 +96,7 @@ class NetDest
     MachineID smallestElement(MachineType machine) const;
 
     void resize();
-    int getSize() const { return m_bits.size(); }
+    int getSize() const { return MachineType_NUM; }
 
     // get element for a index
     NodeID elementAt(MachineID index);
@@ -111,7 +116,33 @@ class NetDest
 
     NodeID bitIndex(NodeID index) const { return index; }
 
+    // The machines are in m_list until there are more than ListSize of
+    // them, then in m_bits
+    bool isList() const { return m_bits.empty(); }
+
+    // Calls f(machine) for every machine in the set
+    template <typename F>
+    void
+    forEachElement(F f) const
+    {
+        if (isList()) {
+            for (int i = 0; i < m_list_size; i++)
+                f(m_list[i]);
+            return;
+        }
+        for (int i = 0; i < m_bits.size(); i++) {
+            for (NodeID j = 0; j < m_bits[i].getSize(); j++) {
+                if (m_bits[i].isElement(j))
+                    f(MachineID(MachineType_from_base_level(i), j));
+            }
+        }
+    }
+
+    static constexpr int ListSize = 4;
+
     std::vector<Set> m_bits;  // a vector of bit vectors - i.e. Sets
+    MachineID m_list[ListSize];
+    int m_list_size;
 };
 
 inline std::ostream&
@@ -0,0 +1,281 @@
+/*
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "mem/ruby/common/NetDest.hh"
+
+using namespace gem5;
+using namespace gem5::ruby;
+
+/*
+ * The machine counts come from the protocol's controllers, which the
+ * test does not build: the first NumTypes machine types have
+ * NumPerType machines each, and the others none.
+ */
+namespace
+{
+
+constexpr int NumTypes = 3;
+constexpr int NumPerType = 6;
+
+int
+machineCount(MachineType type)
+{
+    return type < NumTypes ? NumPerType : 0;
+}
+
+} // anonymous namespace
+
+namespace gem5
+{
+namespace ruby
+{
+
+MachineType &
+operator++(MachineType &e)
+{
+    assert(e < MachineType_NUM);
+    return e = MachineType(e + 1);
+}
+
+int MachineType_base_level(const MachineType &obj) { return obj; }
+
+MachineType
+MachineType_from_base_level(int level)
+{
+    return MachineType(level);
+}
+
+int
+MachineType_base_number(const MachineType &obj)
+{
+    return std::min<int>(obj, NumTypes) * NumPerType;
+}
+
+int
+MachineType_base_count(const MachineType &obj)
+{
+    return machineCount(obj);
+}
+
+} // namespace ruby
+} // namespace gem5
+
+namespace
+{
+
+// The set of machines a NetDest should hold, as (type, num) pairs
+typedef std::set<std::pair<int, NodeID>> Ref;
+
+MachineID
+machine(int index)
+{
+    return MachineID(MachineType(index / NumPerType), index % NumPerType);
+}
+
+std::pair<int, NodeID>
+key(MachineID m)
+{
+    return {m.type, m.num};
+}
+
+// Checks that dest holds exactly the machines of ref
+void
+expectSame(const NetDest &dest, const Ref &ref)
+{
+    EXPECT_EQ(dest.count(), ref.size());
+    EXPECT_EQ(dest.isEmpty(), ref.empty());
+    for (int i = 0; i < NumTypes * NumPerType; i++)
+        EXPECT_EQ(dest.isElement(machine(i)), ref.count(key(machine(i))));
+
+    if (!ref.empty()) {
+        MachineID smallest = dest.smallestElement();
+        EXPECT_EQ(key(smallest), *ref.begin());
+        for (int type = 0; type < NumTypes; type++) {
+            auto first = ref.lower_bound({type, 0});
+            if (first == ref.end() || first->first != type)
+                continue;
+            EXPECT_EQ(key(dest.smallestElement(MachineType(type))), *first);
+        }
+    }
+}
+
+// A random set of machines, as a list or as bit vectors
+std::pair<NetDest, Ref>
+randomDest(std::mt19937 &rng)
+{
+    NetDest dest;
+    Ref ref;
+    int size = rng() % 9;
+    for (int i = 0; i < size; i++) {
+        MachineID m = machine(rng() % (NumTypes * NumPerType));
+        dest.add(m);
+        ref.insert(key(m));
+    }
+    // small sets in bit vectors too
+    if (rng() % 4 == 0)
+        dest.resize();
+    return {dest, ref};
+}
+
+} // anonymous namespace
+
+/**
+ * Adding machines past the list size moves them to the bit vectors;
+ * removing them and clearing keep the contents.
+ */
+TEST(NetDestTest, AddRemove)
+{
+    NetDest dest;
+    Ref ref;
+    expectSame(dest, ref);
+
+    for (int i = 0; i < NumTypes * NumPerType; i += 2) {
+        dest.add(machine(i));
+        dest.add(machine(i));
+        ref.insert(key(machine(i)));
+        expectSame(dest, ref);
+    }
+    for (int i = 0; i < NumTypes * NumPerType; i += 4) {
+        dest.remove(machine(i));
+        dest.remove(machine(i + 1));
+        ref.erase(key(machine(i)));
+        expectSame(dest, ref);
+    }
+
+    dest.clear();
+    ref.clear();
+    expectSame(dest, ref);
+
+    // back to a list after clear, and to the bit vectors again
+    for (int i = NumTypes * NumPerType - 1; i >= 0; i -= 3) {
+        dest.add(machine(i));
+        ref.insert(key(machine(i)));
+        expectSame(dest, ref);
+    }
+}
+
+/** resize switches a list to bit vectors with the same machines. */
+TEST(NetDestTest, Resize)
+{
+    NetDest dest;
+    Ref ref;
+    for (int i : {7, 2, 13}) {
+        dest.add(machine(i));
+        ref.insert(key(machine(i)));
+    }
+    dest.resize();
+    expectSame(dest, ref);
+    dest.resize();
+    expectSame(dest, ref);
+
+    dest.add(machine(0));
+    ref.insert(key(machine(0)));
+    dest.remove(machine(13));
+    ref.erase(key(machine(13)));
+    expectSame(dest, ref);
+}
+
+/** Broadcasts hold every machine. */
+TEST(NetDestTest, Broadcast)
+{
+    NetDest dest;
+    dest.broadcast();
+    EXPECT_TRUE(dest.isBroadcast());
+    EXPECT_EQ(dest.count(), NumTypes * NumPerType);
+
+    NetDest one_type;
+    one_type.broadcast(MachineType(1));
+    Ref ref;
+    for (NodeID num = 0; num < NumPerType; num++)
+        ref.insert({1, num});
+    expectSame(one_type, ref);
+    EXPECT_FALSE(one_type.isBroadcast());
+}
+
+/**
+ * The set operations on any combination of lists and bit vectors agree
+ * with std::set.
+ */
+TEST(NetDestTest, SetOperations)
+{
+    std::mt19937 rng(1);
+    for (int round = 0; round < 2000; round++) {
+        auto a = randomDest(rng);
+        auto b = randomDest(rng);
+        expectSame(a.first, a.second);
+        expectSame(b.first, b.second);
+
+        Ref both, either, a_only;
+        std::set_intersection(a.second.begin(), a.second.end(),
+                              b.second.begin(), b.second.end(),
+                              std::inserter(both, both.end()));
+        std::set_union(a.second.begin(), a.second.end(),
+                       b.second.begin(), b.second.end(),
+                       std::inserter(either, either.end()));
+        std::set_difference(a.second.begin(), a.second.end(),
+                            b.second.begin(), b.second.end(),
+                            std::inserter(a_only, a_only.end()));
+
+        expectSame(a.first.AND(b.first), both);
+        expectSame(a.first.OR(b.first), either);
+        EXPECT_EQ(a.first.intersectionIsNotEmpty(b.first), !both.empty());
+        EXPECT_EQ(a.first.isEqual(b.first), a.second == b.second);
+        EXPECT_EQ(a.first.isSuperset(b.first),
+                  std::includes(a.second.begin(), a.second.end(),
+                                b.second.begin(), b.second.end()));
+        EXPECT_EQ(a.first.isSubset(b.first),
+                  std::includes(b.second.begin(), b.second.end(),
+                                a.second.begin(), a.second.end()));
+
+        NetDest removed = a.first;
+        removed.removeNetDest(b.first);
+        expectSame(removed, a_only);
+
+        NetDest added = a.first;
+        added.addNetDest(b.first);
+        expectSame(added, either);
+
+        // a NetDest equals itself whatever its representation
+        NetDest copy = a.first;
+        copy.resize();
+        EXPECT_TRUE(copy.isEqual(a.first));
+        EXPECT_TRUE(a.first.isEqual(copy));
+        EXPECT_TRUE(copy.isSuperset(a.first));
+
+        removed = a.first;
+        removed.removeNetDest(removed);
+        expectSame(removed, Ref());
+    }
+}
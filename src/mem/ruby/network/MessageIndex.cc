@@ -0,0 +1,148 @@
+/*
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "mem/ruby/network/MessageIndex.hh"
+
+#include "base/logging.hh"
+
+namespace gem5
+{
+
+namespace ruby
+{
+
+MessageIndex::MessageIndex(int expected_lines)
+    : m_lines(expected_lines)
+{
+}
+
+void
+MessageIndex::insertIn(EntryList &entries, const MsgPtr &msg)
+{
+    for (auto &entry : entries) {
+        if (entry.msg == msg) {
+            entry.count++;
+            return;
+        }
+    }
+    entries.push_back({msg, 1});
+}
+
+bool
+MessageIndex::eraseFrom(EntryList &entries, const MsgPtr &msg)
+{
+    for (auto it = entries.begin(); it != entries.end(); ++it) {
+        if (it->msg == msg) {
+            if (--it->count == 0)
+                entries.erase(it);
+            return true;
+        }
+    }
+    return false;
+}
+
+void
+MessageIndex::insert(const MsgPtr &msg)
+{
+    Addr line;
+    if (msg->getFunctionalLine(line))
+        insertIn(m_lines[line], msg);
+    else
+        insertIn(m_unindexed, msg);
+}
+
+void
+MessageIndex::erase(const MsgPtr &msg)
+{
+    Addr line;
+    if (msg->getFunctionalLine(line)) {
+        auto it = m_lines.find(line);
+        panic_if(it == m_lines.end() || !eraseFrom(it->second, msg),
+                 "Message %s is not in the index of line %#x", *msg, line);
+        if (it->second.empty())
+            m_lines.erase(line);
+    } else {
+        panic_if(!eraseFrom(m_unindexed, msg),
+                 "Message %s is not in the index", *msg);
+    }
+}
+
+bool
+MessageIndex::functionalRead(Packet *pkt)
+{
+    auto it = m_lines.find(makeLineAddress(pkt->getAddr()));
+    if (it != m_lines.end()) {
+        for (auto &entry : it->second) {
+            if (entry.msg->functionalRead(pkt))
+                return true;
+        }
+    }
+    for (auto &entry : m_unindexed) {
+        if (entry.msg->functionalRead(pkt))
+            return true;
+    }
+    return false;
+}
+
+bool
+MessageIndex::functionalRead(Packet *pkt, WriteMask &mask)
+{
+    bool read = false;
+    auto it = m_lines.find(makeLineAddress(pkt->getAddr()));
+    if (it != m_lines.end()) {
+        for (auto &entry : it->second) {
+            if (entry.msg->functionalRead(pkt, mask))
+                read = true;
+        }
+    }
+    for (auto &entry : m_unindexed) {
+        if (entry.msg->functionalRead(pkt, mask))
+            read = true;
+    }
+    return read;
+}
+
+uint32_t
+MessageIndex::functionalWrite(Packet *pkt)
+{
+    uint32_t num_functional_writes = 0;
+    auto it = m_lines.find(makeLineAddress(pkt->getAddr()));
+    if (it != m_lines.end()) {
+        for (auto &entry : it->second) {
+            if (entry.msg->functionalWrite(pkt))
+                num_functional_writes++;
+        }
+    }
+    for (auto &entry : m_unindexed) {
+        if (entry.msg->functionalWrite(pkt))
+            num_functional_writes++;
+    }
+    return num_functional_writes;
+}
+
+} // namespace ruby
+} // namespace gem5
@@ -0,0 +1,90 @@
+/*
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __MEM_RUBY_NETWORK_MESSAGEINDEX_HH__
+#define __MEM_RUBY_NETWORK_MESSAGEINDEX_HH__
+
+#include <cstdint>
+#include <vector>
+
+#include "mem/packet.hh"
+#include "mem/ruby/common/FlatAddressMap.hh"
+#include "mem/ruby/common/WriteMask.hh"
+#include "mem/ruby/slicc_interface/Message.hh"
+
+namespace gem5
+{
+
+namespace ruby
+{
+
+/*
+ * The messages held by a set of buffers (those of a controller, or the
+ * flits in a network), indexed by the line they hold data of, so that a
+ * functional access only looks at the messages of its line instead of
+ * every message in every buffer. A message can be inserted several times
+ * (e.g. once per flit) and stays in the index until it has been erased as
+ * many times. Messages that do not name a line (see
+ * Message::getFunctionalLine) are looked at by every access.
+ */
+class MessageIndex
+{
+  public:
+    MessageIndex(int expected_lines = 64);
+
+    void insert(const MsgPtr &msg);
+    void erase(const MsgPtr &msg);
+
+    // The same as the functional accesses of MessageBuffer: a read
+    // returns true if a message had valid data for the packet, a masked
+    // read if any message had some and a write returns the number of
+    // messages written
+    bool functionalRead(Packet *pkt);
+    bool functionalRead(Packet *pkt, WriteMask &mask);
+    uint32_t functionalWrite(Packet *pkt);
+
+  private:
+    struct Entry
+    {
+        MsgPtr msg;
+        int count;
+    };
+    typedef std::vector<Entry> EntryList;
+
+    static void insertIn(EntryList &entries, const MsgPtr &msg);
+    // Returns false if the message is not in the list
+    static bool eraseFrom(EntryList &entries, const MsgPtr &msg);
+
+    // The messages of each line, in the order they were inserted
+    FlatAddressMap<EntryList> m_lines;
+    EntryList m_unindexed;
+};
+
+} // namespace ruby
+} // namespace gem5
+
+#endif // __MEM_RUBY_NETWORK_MESSAGEINDEX_HH__
@@ -0,0 +1,167 @@
+/*
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "mem/ruby/network/MessageQueue.hh"
+
+#include <algorithm>
+#include <functional>
+
+namespace gem5
+{
+
+namespace ruby
+{
+
+void
+MessageQueue::Run::push_back(Entry &&entry)
+{
+    if (m_count == m_ring.size()) {
+        // Unroll the ring into a buffer twice as large
+        std::vector<Entry> ring(std::max<size_t>(2 * m_ring.size(), 8));
+        for (size_t i = 0; i < m_count; i++)
+            ring[i] = std::move(m_ring[(m_first + i) & (m_ring.size() - 1)]);
+        m_ring.swap(ring);
+        m_first = 0;
+    }
+    m_ring[(m_first + m_count) & (m_ring.size() - 1)] = std::move(entry);
+    m_count++;
+}
+
+void
+MessageQueue::Run::pop_front()
+{
+    assert(!empty());
+    // Release the message now rather than when the slot is reused
+    m_ring[m_first].msg = nullptr;
+    m_first = (m_first + 1) & (m_ring.size() - 1);
+    m_count--;
+}
+
+void
+MessageQueue::Run::clear()
+{
+    while (!empty())
+        pop_front();
+    m_first = 0;
+}
+
+MessageQueue::MessageQueue()
+    : m_head(HeapHead), m_size(0)
+{
+}
+
+void
+MessageQueue::push(const MsgPtr &msg)
+{
+    Entry entry{msg->getLastEnqueueTime(), msg->getMsgCounter(), msg};
+
+    // Append to the run with the latest back not after the message, or
+    // else to an empty run
+    int target = -1;
+    for (int i = 0; i < NumRuns; i++) {
+        const Run &run = m_runs[i];
+        if (run.empty()) {
+            if (target < 0)
+                target = i;
+        } else if (!(run.back() > entry) &&
+                   (target < 0 || m_runs[target].empty() ||
+                    run.back() > m_runs[target].back())) {
+            target = i;
+        }
+    }
+
+    bool is_head = empty() || headEntry() > entry;
+    if (target >= 0) {
+        m_runs[target].push_back(std::move(entry));
+    } else {
+        target = HeapHead;
+        m_heap.push_back(std::move(entry));
+        std::push_heap(m_heap.begin(), m_heap.end(), std::greater<Entry>());
+    }
+    if (is_head)
+        m_head = target;
+    m_size++;
+}
+
+void
+MessageQueue::pop()
+{
+    assert(!empty());
+    if (m_head < NumRuns) {
+        m_runs[m_head].pop_front();
+    } else {
+        std::pop_heap(m_heap.begin(), m_heap.end(), std::greater<Entry>());
+        m_heap.pop_back();
+    }
+    m_size--;
+    findHead();
+}
+
+void
+MessageQueue::findHead()
+{
+    m_head = HeapHead;
+    const Entry *head = m_heap.empty() ? nullptr : &m_heap.front();
+    for (int i = 0; i < NumRuns; i++) {
+        if (!m_runs[i].empty() && (!head || *head > m_runs[i].front())) {
+            head = &m_runs[i].front();
+            m_head = i;
+        }
+    }
+}
+
+void
+MessageQueue::clear()
+{
+    for (Run &run : m_runs)
+        run.clear();
+    m_heap.clear();
+    m_head = HeapHead;
+    m_size = 0;
+}
+
+std::vector<MsgPtr>
+MessageQueue::sorted() const
+{
+    std::vector<const Entry *> entries;
+    for (const Run &run : m_runs) {
+        for (size_t i = 0; i < run.size(); i++)
+            entries.push_back(&run.at(i));
+    }
+    for (const Entry &entry : m_heap)
+        entries.push_back(&entry);
+    std::sort(entries.begin(), entries.end(),
+              [](const Entry *a, const Entry *b) { return *b > *a; });
+
+    std::vector<MsgPtr> msgs;
+    for (const Entry *entry : entries)
+        msgs.push_back(entry->msg);
+    return msgs;
+}
+
+} // namespace ruby
+} // namespace gem5
@@ -0,0 +1,165 @@
+/*
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __MEM_RUBY_NETWORK_MESSAGEQUEUE_HH__
+#define __MEM_RUBY_NETWORK_MESSAGEQUEUE_HH__
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "base/types.hh"
+#include "mem/ruby/slicc_interface/Message.hh"
+
+namespace gem5
+{
+
+namespace ruby
+{
+
+/*
+ * The messages of a MessageBuffer, ordered by ready time (the last
+ * enqueue time) and then by the enqueue counter of the buffer, the order
+ * of the priority heap it replaces.
+ *
+ * Most messages are enqueued with one of a few fixed delays, so their
+ * ready times rarely go backwards. A message is appended to the FIFO run
+ * whose last message is the latest one that is not after it, and only
+ * goes to a heap when it is earlier than the back of every run (e.g. a
+ * recycled, reanalyzed or shorter-delay message). The head is the
+ * earliest of the run fronts and the heap top. Enqueues and dequeues of
+ * in-order messages are O(1) and allocation free once the runs have
+ * grown. Since the runs are sorted and the keys unique, the dequeue order
+ * is exactly that of the heap.
+ */
+class MessageQueue
+{
+  public:
+    MessageQueue();
+
+    bool empty() const { return m_size == 0; }
+    size_t size() const { return m_size; }
+
+    const MsgPtr &
+    front() const
+    {
+        assert(!empty());
+        return m_head < NumRuns ? m_runs[m_head].front().msg
+                                : m_heap.front().msg;
+    }
+
+    void push(const MsgPtr &msg);
+    void pop();
+    void clear();
+
+    // Calls f on each message, in no particular order, until f returns
+    // true
+    template<class F>
+    void
+    forEach(F f) const
+    {
+        for (const Run &run : m_runs) {
+            for (size_t i = 0; i < run.size(); i++) {
+                if (f(run.at(i).msg.get()))
+                    return;
+            }
+        }
+        for (const Entry &entry : m_heap) {
+            if (f(entry.msg.get()))
+                return;
+        }
+    }
+
+    // The messages in dequeue order
+    std::vector<MsgPtr> sorted() const;
+
+  private:
+    // A message and its ordering key, kept inline so that comparisons do
+    // not dereference the message
+    struct Entry
+    {
+        Tick time;
+        uint64_t counter;
+        MsgPtr msg;
+
+        bool
+        operator>(const Entry &o) const
+        {
+            return time != o.time ? time > o.time : counter > o.counter;
+        }
+    };
+
+    // A FIFO of entries in increasing order, in a ring buffer that only
+    // grows
+    class Run
+    {
+      public:
+        bool empty() const { return m_count == 0; }
+        size_t size() const { return m_count; }
+        const Entry &front() const { return m_ring[m_first]; }
+        const Entry &back() const { return at(m_count - 1); }
+
+        const Entry &
+        at(size_t i) const
+        {
+            return m_ring[(m_first + i) & (m_ring.size() - 1)];
+        }
+
+        void push_back(Entry &&entry);
+        void pop_front();
+        void clear();
+
+      private:
+        std::vector<Entry> m_ring;
+        size_t m_first = 0;
+        size_t m_count = 0;
+    };
+
+    static constexpr int NumRuns = 4;
+    // Source of the front message: a run, NumRuns for the heap
+    static constexpr int HeapHead = NumRuns;
+
+    const Entry &
+    headEntry() const
+    {
+        return m_head < NumRuns ? m_runs[m_head].front() : m_heap.front();
+    }
+
+    // Recomputes m_head after the front message was removed
+    void findHead();
+
+    Run m_runs[NumRuns];
+    std::vector<Entry> m_heap;
+    int m_head;
+    size_t m_size;
+};
+
+} // namespace ruby
+} // namespace gem5
+
+#endif // __MEM_RUBY_NETWORK_MESSAGEQUEUE_HH__
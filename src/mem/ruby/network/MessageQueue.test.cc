@@ -0,0 +1,224 @@
+/*
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "mem/ruby/network/MessageQueue.hh"
+
+using namespace gem5;
+using namespace gem5::ruby;
+
+namespace
+{
+
+// A message that counts the live instances
+class TestMessage : public Message
+{
+  public:
+    TestMessage(Tick time, uint64_t counter, int *live = nullptr)
+        : Message(time), m_live(live)
+    {
+        setMsgCounter(counter);
+        if (m_live)
+            ++*m_live;
+    }
+
+    ~TestMessage()
+    {
+        if (m_live)
+            --*m_live;
+    }
+
+    MsgPtr
+    clone() const override
+    {
+        return new TestMessage(getLastEnqueueTime(), getMsgCounter(),
+                               m_live);
+    }
+
+    void print(std::ostream &out) const override { out << "[TestMessage]"; }
+
+  private:
+    int *m_live;
+};
+
+// Pops all the messages of queue, as (ready time, counter) pairs
+std::vector<std::pair<Tick, uint64_t>>
+drain(MessageQueue &queue)
+{
+    std::vector<std::pair<Tick, uint64_t>> order;
+    while (!queue.empty()) {
+        const MsgPtr &msg = queue.front();
+        order.emplace_back(msg->getLastEnqueueTime(), msg->getMsgCounter());
+        queue.pop();
+    }
+    return order;
+}
+
+} // anonymous namespace
+
+/** Messages ready at the same time leave in enqueue counter order. */
+TEST(MessageQueueTest, EqualReadyTimes)
+{
+    MessageQueue queue;
+    for (uint64_t counter = 0; counter < 100; counter++)
+        queue.push(new TestMessage(1000, counter));
+    EXPECT_EQ(queue.size(), 100);
+
+    auto order = drain(queue);
+    ASSERT_EQ(order.size(), 100);
+    for (uint64_t counter = 0; counter < 100; counter++) {
+        EXPECT_EQ(order[counter].first, 1000);
+        EXPECT_EQ(order[counter].second, counter);
+    }
+}
+
+/**
+ * A message pushed after later messages of the same ready time (e.g. a
+ * recycled one, with an earlier counter) still leaves by its counter.
+ */
+TEST(MessageQueueTest, EqualReadyTimesOutOfOrder)
+{
+    MessageQueue queue;
+    std::vector<uint64_t> counters = {5, 6, 7, 1, 8, 2, 9, 0, 3, 4};
+    for (uint64_t counter : counters)
+        queue.push(new TestMessage(500, counter));
+    queue.push(new TestMessage(400, 10));
+
+    auto order = drain(queue);
+    ASSERT_EQ(order.size(), 11);
+    EXPECT_EQ(order[0], std::make_pair(Tick(400), uint64_t(10)));
+    for (uint64_t counter = 0; counter < 10; counter++)
+        EXPECT_EQ(order[counter + 1], std::make_pair(Tick(500), counter));
+}
+
+/**
+ * Pushes and pops in any order of ready times dequeue in (ready time,
+ * counter) order, as the priority heap the queue replaces.
+ */
+TEST(MessageQueueTest, DequeueOrder)
+{
+    std::mt19937 rng(1);
+    MessageQueue queue;
+    std::vector<std::pair<Tick, uint64_t>> ref;
+    uint64_t counter = 0;
+    Tick now = 0;
+    for (int i = 0; i < 5000; i++) {
+        if (rng() % 3) {
+            // mostly fixed delays, some shorter ones
+            Tick delay = (rng() % 4 == 0) ? rng() % 10 : 10 * (1 + rng() % 3);
+            queue.push(new TestMessage(now + delay, counter));
+            ref.emplace_back(now + delay, counter);
+            counter++;
+        } else if (!queue.empty()) {
+            auto head = std::min_element(ref.begin(), ref.end());
+            ASSERT_EQ(queue.front()->getLastEnqueueTime(), head->first);
+            ASSERT_EQ(queue.front()->getMsgCounter(), head->second);
+            ref.erase(head);
+            queue.pop();
+        }
+        now += rng() % 3;
+        ASSERT_EQ(queue.size(), ref.size());
+    }
+
+    std::sort(ref.begin(), ref.end());
+    std::vector<std::pair<Tick, uint64_t>> sorted;
+    for (const MsgPtr &msg : queue.sorted())
+        sorted.emplace_back(msg->getLastEnqueueTime(), msg->getMsgCounter());
+    EXPECT_EQ(sorted, ref);
+    EXPECT_EQ(drain(queue), ref);
+}
+
+/** forEach visits every message, and stops when the callback says so. */
+TEST(MessageQueueTest, ForEach)
+{
+    MessageQueue queue;
+    for (uint64_t counter = 0; counter < 20; counter++)
+        queue.push(new TestMessage(100 - counter, counter));
+
+    std::vector<uint64_t> visited;
+    queue.forEach([&](const Message *msg) {
+        visited.push_back(msg->getMsgCounter());
+        return false;
+    });
+    std::sort(visited.begin(), visited.end());
+    ASSERT_EQ(visited.size(), 20);
+    for (uint64_t counter = 0; counter < 20; counter++)
+        EXPECT_EQ(visited[counter], counter);
+
+    int calls = 0;
+    queue.forEach([&](const Message *msg) {
+        calls++;
+        return msg->getMsgCounter() == 7;
+    });
+    EXPECT_GE(calls, 1);
+    EXPECT_LE(calls, 20);
+
+    int calls_after = 0;
+    bool found = false;
+    queue.forEach([&](const Message *msg) {
+        EXPECT_FALSE(found);
+        calls_after++;
+        found = msg->getMsgCounter() == 7;
+        return found;
+    });
+    EXPECT_TRUE(found);
+    EXPECT_EQ(calls_after, calls);
+    EXPECT_EQ(queue.size(), 20);
+}
+
+/** clear releases the messages and leaves a usable, empty queue. */
+TEST(MessageQueueTest, Clear)
+{
+    int live = 0;
+    MessageQueue queue;
+    for (uint64_t counter = 0; counter < 50; counter++)
+        queue.push(new TestMessage((counter * 37) % 50, counter, &live));
+    EXPECT_EQ(live, 50);
+
+    queue.clear();
+    EXPECT_TRUE(queue.empty());
+    EXPECT_EQ(queue.size(), 0);
+    EXPECT_EQ(live, 0);
+
+    int calls = 0;
+    queue.forEach([&](const Message *) { return ++calls, false; });
+    EXPECT_EQ(calls, 0);
+
+    queue.push(new TestMessage(20, 51, &live));
+    queue.push(new TestMessage(10, 52, &live));
+    EXPECT_EQ(queue.size(), 2);
+    EXPECT_EQ(queue.front()->getMsgCounter(), 52);
+    queue.pop();
+    EXPECT_EQ(live, 1);
+    EXPECT_EQ(queue.front()->getMsgCounter(), 51);
+}
@@ -43,6 +43,7 @@
 #include "base/logging.hh"
 #include "mem/ruby/common/MachineID.hh"
 #include "mem/ruby/network/BasicLink.hh"
+#include "mem/ruby/profiler/Profiler.hh"
 #include "mem/ruby/system/RubySystem.hh"
 
 namespace gem5
@@ -54,6 +55,7 @@ namespace ruby
 uint32_t Network::m_virtual_networks;
 uint32_t Network::m_control_msg_size;
 uint32_t Network::m_data_msg_size;
+uint32_t Network::m_reply_msg_size;
 
 Network::Network(const Params &p)
     : ClockedObject(p)
@@ -64,6 +66,10 @@ Network::Network(const Params &p)
     fatal_if(p.data_msg_size > p.ruby_system->getBlockSizeBytes(),
              "%s: data message size > cache line size", name());
     m_data_msg_size = p.data_msg_size + m_control_msg_size;
+    fatal_if(p.reply_msg_size > p.ruby_system->getBlockSizeBytes(),
+             "%s: reply message size > cache line size", name());
+    m_reply_msg_size = p.reply_msg_size ?
+        p.reply_msg_size + m_control_msg_size : m_data_msg_size;
 
     params().ruby_system->registerNetwork(this);
 
@@ -160,6 +166,13 @@ Network::~Network()
     delete m_topology_ptr;
 }
 
+void
+Network::profileLineTraffic(const Message *msg, int vnet, int flits)
+{
+    params().ruby_system->getProfiler()->profileLineTraffic(*msg, vnet,
+                                                            flits);
+}
+
 uint32_t
 Network::MessageSizeType_to_int(MessageSizeType size_type)
 {
@@ -183,6 +196,8 @@ Network::MessageSizeType_to_int(MessageSizeType size_type)
       case MessageSizeType_ResponseL2hit_Data:
       case MessageSizeType_Writeback_Data:
         return m_data_msg_size;
+      case MessageSizeType_Reply_Data:
+        return m_reply_msg_size;
       default:
         panic("Invalid range for type MessageSizeType");
         break;
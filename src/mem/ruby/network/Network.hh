@@ -77,6 +77,7 @@ namespace ruby
 {
 
 class NetDest;
+class Message;
 class MessageBuffer;
 
 class Network : public ClockedObject
@@ -92,6 +93,10 @@ class Network : public ClockedObject
 
     static uint32_t MessageSizeType_to_int(MessageSizeType size_type);
 
+    // Counts a message of flits injected into vnet in the network traffic
+    // of the hot lines (see the hot_lines parameters of RubySystem)
+    void profileLineTraffic(const Message *msg, int vnet, int flits);
+
     // returns the queue requested for the given component
     void setToNetQueue(NodeID global_id, bool ordered, int netNumber,
                                std::string vnet_type, MessageBuffer *b);
@@ -158,6 +163,7 @@ class Network : public ClockedObject
     Topology* m_topology_ptr;
     static uint32_t m_control_msg_size;
     static uint32_t m_data_msg_size;
+    static uint32_t m_reply_msg_size;
 
     // vector of queues from the components
     std::vector<std::vector<MessageBuffer*> > m_toNetQueues;
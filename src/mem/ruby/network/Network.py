@@ -65,3 +65,9 @@ class RubyNetwork(ClockedObject):
         "Size of data messages. Defaults to the parent "
         "RubySystem cache line size.",
     )
+    reply_msg_size = Param.Int(
+        0,
+        "Size of the payload of synthetic data replies "
+        "(Reply_Data messages, e.g. closed-loop garnet synthetic "
+        "traffic). 0: same as data_msg_size.",
+    )
@@ -0,0 +1,343 @@
+/*
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "mem/ruby/network/garnet/Allocator.hh"
+
+#include <algorithm>
+
+#include "base/logging.hh"
+
+namespace gem5
+{
+
+namespace ruby
+{
+
+namespace garnet
+{
+
+namespace
+{
+
+bool
+has_request(const std::vector<SwitchRequest> &requests, int outport)
+{
+    for (auto &req : requests) {
+        if (req.outport == outport)
+            return true;
+    }
+    return false;
+}
+
+} // anonymous namespace
+
+Allocator::Allocator(int num_inports, int num_outports, int num_vcs)
+  : m_num_inports(num_inports), m_num_outports(num_outports),
+    m_num_vcs(num_vcs), m_round_robin_invc(num_inports, 0),
+    m_input_arbiter_activity(0), m_output_arbiter_activity(0)
+{
+}
+
+Allocator *
+Allocator::create(GarnetSwitchAllocator type, int num_inports,
+                  int num_outports, int num_vcs, int iterations)
+{
+    switch (type) {
+      case GarnetSwitchAllocator::RoundRobin:
+        return new RoundRobinAllocator(num_inports, num_outports, num_vcs);
+      case GarnetSwitchAllocator::AgeBased:
+        return new AgeBasedAllocator(num_inports, num_outports, num_vcs);
+      case GarnetSwitchAllocator::ISlip:
+        return new ISlipAllocator(num_inports, num_outports, num_vcs,
+                                  iterations);
+      case GarnetSwitchAllocator::Wavefront:
+        return new WavefrontAllocator(num_inports, num_outports, num_vcs);
+      default:
+        panic("Unknown switch allocator type\n");
+    }
+}
+
+int
+Allocator::pick_vc(const std::vector<SwitchRequest> &requests, int inport,
+                   int outport)
+{
+    int best = -1;
+    int best_dist = m_num_vcs;
+    for (int i = 0; i < requests.size(); i++) {
+        if (requests[i].outport != outport)
+            continue;
+        int dist = (requests[i].invc - m_round_robin_invc[inport] +
+                    m_num_vcs) % m_num_vcs;
+        if (dist < best_dist) {
+            best = i;
+            best_dist = dist;
+        }
+    }
+    assert(best != -1);
+    return best;
+}
+
+void
+Allocator::update_vc_pointer(int inport, int invc)
+{
+    m_round_robin_invc[inport] = (invc + 1) % m_num_vcs;
+}
+
+RoundRobinAllocator::RoundRobinAllocator(int num_inports, int num_outports,
+                                         int num_vcs)
+  : Allocator(num_inports, num_outports, num_vcs),
+    m_round_robin_inport(num_outports, 0)
+{
+}
+
+/*
+ * SA-I selects one request at each input port, starting from the VC
+ * after the last one granted there. SA-II grants each output port to
+ * one of the inputs that selected it, starting from the input after
+ * the last one granted. Pointers only move on a grant, to keep it fair.
+ */
+
+void
+RoundRobinAllocator::allocate(
+    const std::vector<std::vector<SwitchRequest>> &requests,
+    std::vector<int> &grants)
+{
+    grants.assign(m_num_inports, -1);
+    std::vector<int> winner(m_num_inports, -1);
+
+    for (int inport = 0; inport < m_num_inports; inport++) {
+        int best_dist = m_num_vcs;
+        for (int i = 0; i < requests[inport].size(); i++) {
+            int dist = (requests[inport][i].invc -
+                        m_round_robin_invc[inport] + m_num_vcs) % m_num_vcs;
+            if (dist < best_dist) {
+                winner[inport] = i;
+                best_dist = dist;
+            }
+        }
+        if (winner[inport] != -1)
+            m_input_arbiter_activity++;
+    }
+
+    for (int outport = 0; outport < m_num_outports; outport++) {
+        int inport = m_round_robin_inport[outport];
+        for (int iter = 0; iter < m_num_inports; iter++) {
+            int w = winner[inport];
+            if (w != -1 && requests[inport][w].outport == outport) {
+                grants[inport] = w;
+                m_output_arbiter_activity++;
+                m_round_robin_inport[outport] = (inport + 1) % m_num_inports;
+                update_vc_pointer(inport, requests[inport][w].invc);
+                break;
+            }
+            inport = (inport + 1) % m_num_inports;
+        }
+    }
+}
+
+AgeBasedAllocator::AgeBasedAllocator(int num_inports, int num_outports,
+                                     int num_vcs)
+  : RoundRobinAllocator(num_inports, num_outports, num_vcs)
+{
+}
+
+void
+AgeBasedAllocator::allocate(
+    const std::vector<std::vector<SwitchRequest>> &requests,
+    std::vector<int> &grants)
+{
+    grants.assign(m_num_inports, -1);
+    std::vector<int> winner(m_num_inports, -1);
+
+    // SA-I: oldest request at each input port
+    for (int inport = 0; inport < m_num_inports; inport++) {
+        int best_dist = m_num_vcs;
+        for (int i = 0; i < requests[inport].size(); i++) {
+            int dist = (requests[inport][i].invc -
+                        m_round_robin_invc[inport] + m_num_vcs) % m_num_vcs;
+            int w = winner[inport];
+            if (w == -1 || requests[inport][i].age < requests[inport][w].age ||
+                (requests[inport][i].age == requests[inport][w].age &&
+                 dist < best_dist)) {
+                winner[inport] = i;
+                best_dist = dist;
+            }
+        }
+        if (winner[inport] != -1)
+            m_input_arbiter_activity++;
+    }
+
+    // SA-II: oldest of the input winners at each output port
+    for (int outport = 0; outport < m_num_outports; outport++) {
+        int granted = -1;
+        int inport = m_round_robin_inport[outport];
+        for (int iter = 0; iter < m_num_inports; iter++) {
+            int w = winner[inport];
+            if (w != -1 && requests[inport][w].outport == outport &&
+                (granted == -1 || requests[inport][w].age <
+                 requests[granted][winner[granted]].age)) {
+                granted = inport;
+            }
+            inport = (inport + 1) % m_num_inports;
+        }
+
+        if (granted != -1) {
+            int w = winner[granted];
+            grants[granted] = w;
+            m_output_arbiter_activity++;
+            m_round_robin_inport[outport] = (granted + 1) % m_num_inports;
+            update_vc_pointer(granted, requests[granted][w].invc);
+        }
+    }
+}
+
+ISlipAllocator::ISlipAllocator(int num_inports, int num_outports,
+                               int num_vcs, int iterations)
+  : Allocator(num_inports, num_outports, num_vcs),
+    m_iterations(std::max(iterations, 1)),
+    m_grant_pointer(num_outports, 0), m_accept_pointer(num_inports, 0)
+{
+}
+
+void
+ISlipAllocator::allocate(
+    const std::vector<std::vector<SwitchRequest>> &requests,
+    std::vector<int> &grants)
+{
+    grants.assign(m_num_inports, -1);
+    std::vector<int> matched_outport(m_num_inports, -1);
+    std::vector<int> matched_inport(m_num_outports, -1);
+    std::vector<int> grant(m_num_outports);
+
+    for (int iteration = 0; iteration < m_iterations; iteration++) {
+        // Grant: each free output port grants one requesting free input
+        for (int outport = 0; outport < m_num_outports; outport++) {
+            grant[outport] = -1;
+            if (matched_inport[outport] != -1)
+                continue;
+            for (int iter = 0; iter < m_num_inports; iter++) {
+                int inport = (m_grant_pointer[outport] + iter) %
+                             m_num_inports;
+                if (matched_outport[inport] == -1 &&
+                    has_request(requests[inport], outport)) {
+                    grant[outport] = inport;
+                    m_output_arbiter_activity++;
+                    break;
+                }
+            }
+        }
+
+        // Accept: each free input port accepts one of its grants
+        bool matched = false;
+        for (int inport = 0; inport < m_num_inports; inport++) {
+            if (matched_outport[inport] != -1)
+                continue;
+            for (int iter = 0; iter < m_num_outports; iter++) {
+                int outport = (m_accept_pointer[inport] + iter) %
+                              m_num_outports;
+                if (grant[outport] != inport)
+                    continue;
+
+                matched_outport[inport] = outport;
+                matched_inport[outport] = inport;
+                m_input_arbiter_activity++;
+                matched = true;
+                if (iteration == 0) {
+                    m_grant_pointer[outport] = (inport + 1) % m_num_inports;
+                    m_accept_pointer[inport] =
+                        (outport + 1) % m_num_outports;
+                }
+                break;
+            }
+        }
+
+        if (!matched)
+            break;
+    }
+
+    for (int inport = 0; inport < m_num_inports; inport++) {
+        int outport = matched_outport[inport];
+        if (outport == -1)
+            continue;
+        grants[inport] = pick_vc(requests[inport], inport, outport);
+        update_vc_pointer(inport, requests[inport][grants[inport]].invc);
+    }
+}
+
+WavefrontAllocator::WavefrontAllocator(int num_inports, int num_outports,
+                                       int num_vcs)
+  : Allocator(num_inports, num_outports, num_vcs),
+    m_size(std::max(num_inports, num_outports)), m_priority_diagonal(0)
+{
+}
+
+void
+WavefrontAllocator::allocate(
+    const std::vector<std::vector<SwitchRequest>> &requests,
+    std::vector<int> &grants)
+{
+    grants.assign(m_num_inports, -1);
+    std::vector<int> matched_outport(m_num_inports, -1);
+    std::vector<bool> outport_busy(m_num_outports, false);
+
+    for (int inport = 0; inport < m_num_inports; inport++) {
+        if (!requests[inport].empty())
+            m_input_arbiter_activity++;
+    }
+
+    // Cells on one diagonal never share a row or a column, so they are
+    // granted independently
+    for (int d = 0; d < m_size; d++) {
+        int diagonal = (m_priority_diagonal + d) % m_size;
+        for (int inport = 0; inport < m_num_inports; inport++) {
+            int outport = (inport + diagonal) % m_size;
+            if (outport >= m_num_outports ||
+                matched_outport[inport] != -1 || outport_busy[outport] ||
+                !has_request(requests[inport], outport)) {
+                continue;
+            }
+            matched_outport[inport] = outport;
+            outport_busy[outport] = true;
+            m_output_arbiter_activity++;
+        }
+    }
+
+    m_priority_diagonal = (m_priority_diagonal + 1) % m_size;
+
+    for (int inport = 0; inport < m_num_inports; inport++) {
+        int outport = matched_outport[inport];
+        if (outport == -1)
+            continue;
+        grants[inport] = pick_vc(requests[inport], inport, outport);
+        update_vc_pointer(inport, requests[inport][grants[inport]].invc);
+    }
+}
+
+} // namespace garnet
+} // namespace ruby
+} // namespace gem5
@@ -0,0 +1,162 @@
+/*
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef __MEM_RUBY_NETWORK_GARNET_0_ALLOCATOR_HH__
+#define __MEM_RUBY_NETWORK_GARNET_0_ALLOCATOR_HH__
+
+#include <vector>
+
+#include "base/types.hh"
+#include "enums/GarnetSwitchAllocator.hh"
+
+namespace gem5
+{
+
+namespace ruby
+{
+
+namespace garnet
+{
+
+// A request from an input VC for an output port during switch allocation
+struct SwitchRequest
+{
+    int invc;
+    int outport;
+    // enqueue time of the packet at its source NI (for age-based
+    // arbitration)
+    Tick age;
+};
+
+/*
+ * Switch allocation policy: matches input ports to output ports once per
+ * cycle. requests[inport] holds the requests of the input VCs at inport
+ * in increasing VC order. On return, grants[inport] is the index into
+ * requests[inport] of the request that was granted its output port, or
+ * -1. At most one request is granted per input and per output port.
+ *
+ * Arbiter activity is counted per stage for the power model: one input
+ * arbitration per input port that selects a request and one output
+ * arbitration per grant (per iteration for the iterative allocators).
+ */
+class Allocator
+{
+  public:
+    Allocator(int num_inports, int num_outports, int num_vcs);
+    virtual ~Allocator() = default;
+
+    static Allocator *create(GarnetSwitchAllocator type, int num_inports,
+                             int num_outports, int num_vcs, int iterations);
+
+    virtual void
+    allocate(const std::vector<std::vector<SwitchRequest>> &requests,
+             std::vector<int> &grants) = 0;
+
+    double get_input_arbiter_activity() { return m_input_arbiter_activity; }
+    double get_output_arbiter_activity() { return m_output_arbiter_activity; }
+
+    void
+    resetStats()
+    {
+        m_input_arbiter_activity = 0;
+        m_output_arbiter_activity = 0;
+    }
+
+  protected:
+    // Round-robin selection of the request for outport at inport,
+    // starting from the VC after the last one that was granted there
+    int pick_vc(const std::vector<SwitchRequest> &requests, int inport,
+                int outport);
+    void update_vc_pointer(int inport, int invc);
+
+    int m_num_inports, m_num_outports, m_num_vcs;
+    std::vector<int> m_round_robin_invc;
+
+    double m_input_arbiter_activity, m_output_arbiter_activity;
+};
+
+// Separable input-first allocator with round-robin arbiters
+// (the Garnet 3.0 default)
+class RoundRobinAllocator : public Allocator
+{
+  public:
+    RoundRobinAllocator(int num_inports, int num_outports, int num_vcs);
+    void allocate(const std::vector<std::vector<SwitchRequest>> &requests,
+                  std::vector<int> &grants) override;
+
+  protected:
+    std::vector<int> m_round_robin_inport;
+};
+
+// Separable input-first allocator whose arbiters pick the oldest packet,
+// ties broken round-robin
+class AgeBasedAllocator : public RoundRobinAllocator
+{
+  public:
+    AgeBasedAllocator(int num_inports, int num_outports, int num_vcs);
+    void allocate(const std::vector<std::vector<SwitchRequest>> &requests,
+                  std::vector<int> &grants) override;
+};
+
+// iSLIP: iterative request-grant-accept matching of input ports to
+// output ports. Grant and accept pointers only move on a first-iteration
+// accept. The VC is chosen round-robin at the matched input.
+class ISlipAllocator : public Allocator
+{
+  public:
+    ISlipAllocator(int num_inports, int num_outports, int num_vcs,
+                   int iterations);
+    void allocate(const std::vector<std::vector<SwitchRequest>> &requests,
+                  std::vector<int> &grants) override;
+
+  private:
+    int m_iterations;
+    std::vector<int> m_grant_pointer; // per outport
+    std::vector<int> m_accept_pointer; // per inport
+};
+
+// Wavefront allocator: sweeps the diagonals of the (square) request
+// matrix starting from a rotating priority diagonal. The VC is chosen
+// round-robin at the matched input.
+class WavefrontAllocator : public Allocator
+{
+  public:
+    WavefrontAllocator(int num_inports, int num_outports, int num_vcs);
+    void allocate(const std::vector<std::vector<SwitchRequest>> &requests,
+                  std::vector<int> &grants) override;
+
+  private:
+    int m_size;
+    int m_priority_diagonal;
+};
+
+} // namespace garnet
+} // namespace ruby
+} // namespace gem5
+
+#endif // __MEM_RUBY_NETWORK_GARNET_0_ALLOCATOR_HH__
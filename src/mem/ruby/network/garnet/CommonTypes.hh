@@ -31,6 +31,8 @@
 #ifndef __MEM_RUBY_NETWORK_GARNET_0_COMMONTYPES_HH__
 #define __MEM_RUBY_NETWORK_GARNET_0_COMMONTYPES_HH__
 
+#include <cstdint>
+
 #include "mem/ruby/common/NetDest.hh"
 
 namespace gem5
@@ -57,7 +59,10 @@ struct RouteInfo
 {
     RouteInfo()
         : vnet(0), src_ni(0), src_router(0), dest_ni(0), dest_router(0),
-          hops_traversed(0)
+          hops_traversed(0), redirects(0), minimal(false), escape(false),
+          vc_class(0), phase_hops(0), waypoint(-1), multicast(false),
+          source_route(0),
+          source_hops(0), decompression_latency(0), corrupted(false)
     {}
 
     // destination format for table-based routing
@@ -70,6 +75,53 @@ struct RouteInfo
     int dest_ni;
     int dest_router;
     int hops_traversed;
+
+    // hop/redirect budget (livelock guard)
+    int redirects;
+    // budget exhausted: no more redirects, dimension-ordered routing
+    bool minimal;
+
+    // packet has been diverted onto the escape VC (deadlock recovery)
+    // and is routed dimension-ordered from here on
+    bool escape;
+
+    // VC class the packet allocates at the next hop (torus dateline,
+    // hop index in a flattened butterfly, global hops in a dragonfly)
+    int vc_class;
+    // network hops taken since injection or the last redirect, which
+    // start a new phase of VC classes (see GarnetNetwork::canRedirect)
+    int phase_hops;
+    // intermediate dragonfly group of a non-minimal route (-1: none)
+    int waypoint;
+
+    // packet is delivered to every destination in net_dest; it is
+    // forked at the routers where the destinations split
+    bool multicast;
+
+    // source routing: the directions of the remaining hops, two bits
+    // per hop with the next hop in the low bits (see
+    // RoutingUnit::outportComputeSource), and their number (0: the
+    // packet is routed hop by hop)
+    uint64_t source_route;
+    int source_hops;
+
+    // cycles to decompress the data of the packet at the destination NI
+    // (0: not compressed)
+    int decompression_latency;
+
+    // this flit was corrupted on a faulty link. Kept per flit, not on
+    // the message, which the branches of a multicast packet share.
+    bool corrupted;
+};
+
+// One branch of a multicast packet at a router: the outport, the
+// output VC held by the packet at that outport (-1: none yet) and the
+// destinations reached through it
+struct MulticastBranch
+{
+    int outport;
+    int outvc;
+    NetDest dest;
 };
 
 #define INFINITE_ 10000
@@ -82,6 +82,9 @@ CrossbarSwitch::wakeup()
             t_flit->advance_stage(LT_, m_router->clockEdge(Cycles(1)));
             t_flit->set_time(m_router->clockEdge(Cycles(1)));
 
+            // flit may be corrupted on a faulty link
+            m_router->inject_link_fault(outport, t_flit);
+
             // This will take care of waking up the Network Link
             // in the next cycle
             m_router->getOutputUnit(outport)->insert_flit(t_flit);
@@ -114,6 +117,16 @@ CrossbarSwitch::functionalWrite(Packet *pkt)
    return num_functional_writes;
 }
 
+bool
+CrossbarSwitch::isEmpty()
+{
+    for (auto &switch_buffer : switchBuffers) {
+        if (!switch_buffer.isEmpty())
+            return false;
+    }
+    return true;
+}
+
 void
 CrossbarSwitch::resetStats()
 {
@@ -66,6 +66,8 @@ class CrossbarSwitch : public Consumer
     }
 
     inline double get_crossbar_activity() { return m_crossbar_activity; }
+    // No flit won the switch and waits to traverse it
+    bool isEmpty();
 
     bool functionalRead(Packet *pkt, WriteMask &mask);
     uint32_t functionalWrite(Packet *pkt);
@@ -0,0 +1,203 @@
+/*
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "mem/ruby/network/garnet/DeadlockDetector.hh"
+
+#include <utility>
+
+#include "debug/RubyNetwork.hh"
+#include "mem/ruby/network/garnet/GarnetNetwork.hh"
+#include "mem/ruby/network/garnet/InputUnit.hh"
+#include "mem/ruby/network/garnet/OutputUnit.hh"
+#include "mem/ruby/network/garnet/Router.hh"
+#include "sim/cur_tick.hh"
+
+namespace gem5
+{
+
+namespace ruby
+{
+
+namespace garnet
+{
+
+DeadlockDetector::DeadlockDetector(GarnetNetwork *net_ptr)
+    : m_net_ptr(net_ptr)
+{
+}
+
+int
+DeadlockDetector::sample(Tick stall_threshold)
+{
+    m_nodes.clear();
+    m_node_index.clear();
+    m_edges.clear();
+    m_cycles.clear();
+
+    // Nothing can have been stalled for a full interval yet
+    if (curTick() < stall_threshold)
+        return 0;
+
+    collectBlockedChannels(stall_threshold);
+    if (m_nodes.empty())
+        return 0;
+
+    buildEdges();
+    findCycles();
+
+    return m_cycles.size();
+}
+
+int
+DeadlockDetector::lookup(int router, int inport, int vc) const
+{
+    auto it = m_node_index.find(key(router, inport, vc));
+    if (it == m_node_index.end())
+        return -1;
+    return it->second;
+}
+
+// A channel is blocked if the flit at the head of the input VC became
+// eligible for switch allocation at least stall_threshold ticks ago
+// and is still sitting in the VC.
+void
+DeadlockDetector::collectBlockedChannels(Tick stall_threshold)
+{
+    Tick stalled_since = curTick() - stall_threshold;
+
+    for (int r = 0; r < m_net_ptr->getNumRouters(); r++) {
+        Router *router = m_net_ptr->getRouter(r);
+        for (int inport = 0; inport < router->get_num_inports(); inport++) {
+            InputUnit *input_unit = router->getInputUnit(inport);
+            for (int vc = 0; vc < router->get_num_vcs(); vc++) {
+                if (!input_unit->need_stage(vc, SA_, stalled_since))
+                    continue;
+
+                m_node_index[key(r, inport, vc)] = m_nodes.size();
+                m_nodes.push_back({r, inport, vc});
+            }
+        }
+    }
+
+    m_edges.resize(m_nodes.size());
+}
+
+void
+DeadlockDetector::buildEdges()
+{
+    for (int n = 0; n < m_nodes.size(); n++) {
+        const ChannelId &ch = m_nodes[n];
+        Router *router = m_net_ptr->getRouter(ch.router);
+        InputUnit *input_unit = router->getInputUnit(ch.inport);
+        OutputUnit *output_unit =
+            router->getOutputUnit(input_unit->get_outport(ch.vc));
+
+        // Ejection ports are sinks of the dependency graph
+        int down_router = output_unit->get_downstream_router();
+        if (down_router < 0)
+            continue;
+        int down_inport = output_unit->get_downstream_inport();
+
+        int outvc = input_unit->get_outvc(ch.vc);
+        if (outvc != -1) {
+            // Waiting for a credit of an already allocated VC
+            int target = lookup(down_router, down_inport, outvc);
+            if (target != -1)
+                m_edges[n].push_back(target);
+            continue;
+        }
+
+        // Waiting for any free VC of the vnet. This is only a
+        // dependency if all candidate VCs are themselves blocked.
+        int vnet = ch.vc / router->get_vc_per_vnet();
+        RouteInfo route = input_unit->peekTopFlit(ch.vc)->get_route();
+        int first_vc, last_vc;
+        output_unit->get_vc_range(vnet, route, first_vc, last_vc);
+
+        std::vector<int> targets;
+        for (int vc = first_vc; vc < last_vc; vc++) {
+            int target = lookup(down_router, down_inport, vc);
+            if (target == -1) {
+                targets.clear();
+                break;
+            }
+            targets.push_back(target);
+        }
+        m_edges[n] = std::move(targets);
+    }
+}
+
+// Iterative DFS over the wait-for graph. Every back edge closes a cycle,
+// which is recovered from the DFS stack.
+void
+DeadlockDetector::findCycles()
+{
+    enum { WHITE, GREY, BLACK };
+    std::vector<int> color(m_nodes.size(), WHITE);
+    std::vector<int> stack_pos(m_nodes.size(), -1);
+
+    // (node, index of the next edge to follow)
+    std::vector<std::pair<int, int>> stack;
+
+    for (int root = 0; root < m_nodes.size(); root++) {
+        if (color[root] != WHITE)
+            continue;
+
+        stack.push_back({root, 0});
+        color[root] = GREY;
+        stack_pos[root] = 0;
+
+        while (!stack.empty()) {
+            int node = stack.back().first;
+            int &next_edge = stack.back().second;
+
+            if (next_edge == m_edges[node].size()) {
+                color[node] = BLACK;
+                stack_pos[node] = -1;
+                stack.pop_back();
+                continue;
+            }
+
+            int succ = m_edges[node][next_edge++];
+            if (color[succ] == WHITE) {
+                color[succ] = GREY;
+                stack_pos[succ] = stack.size();
+                stack.push_back({succ, 0});
+            } else if (color[succ] == GREY) {
+                std::vector<ChannelId> cycle;
+                for (int i = stack_pos[succ]; i < stack.size(); i++)
+                    cycle.push_back(m_nodes[stack[i].first]);
+                m_cycles.push_back(std::move(cycle));
+            }
+        }
+    }
+}
+
+} // namespace garnet
+} // namespace ruby
+} // namespace gem5
@@ -0,0 +1,112 @@
+/*
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef __MEM_RUBY_NETWORK_GARNET_0_DEADLOCKDETECTOR_HH__
+#define __MEM_RUBY_NETWORK_GARNET_0_DEADLOCKDETECTOR_HH__
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "base/types.hh"
+#include "mem/ruby/network/garnet/CommonTypes.hh"
+
+namespace gem5
+{
+
+namespace ruby
+{
+
+namespace garnet
+{
+
+class GarnetNetwork;
+
+/*
+ * Online channel-dependency-graph (CDG) tracker.
+ *
+ * The detector is sampled periodically by the GarnetNetwork. At each sample
+ * it builds a wait-for graph whose nodes are router input VCs that have
+ * been stalled in SA for at least one sampling interval, and whose edges
+ * point to the downstream input VC(s) the stalled flit is waiting on:
+ *    - a flit that already owns an output VC waits for a credit of that VC.
+ *    - a head flit still looking for an output VC waits for *any* VC of its
+ *      vnet at the downstream input port; the edges are only added if every
+ *      one of those VCs is itself stalled (otherwise one of them will drain).
+ * A cycle in this graph is a deadlock. Cycles are reported with the routers,
+ * ports and VCs involved and, if escape VC recovery is enabled, the head
+ * flits on the cycle are diverted onto the reserved escape VC.
+ */
+class DeadlockDetector
+{
+  public:
+    struct ChannelId
+    {
+        int router;
+        int inport;
+        int vc;
+    };
+
+    DeadlockDetector(GarnetNetwork *net_ptr);
+
+    // Samples the network once. Returns the number of cycles found.
+    int sample(Tick stall_threshold);
+
+    // Channels on the cycles found by the last sample
+    const std::vector<std::vector<ChannelId>> &
+    getCycles() const
+    {
+        return m_cycles;
+    }
+
+  private:
+    GarnetNetwork *m_net_ptr;
+
+    std::vector<ChannelId> m_nodes;
+    std::unordered_map<uint64_t, int> m_node_index;
+    std::vector<std::vector<int>> m_edges;
+    std::vector<std::vector<ChannelId>> m_cycles;
+
+    static uint64_t
+    key(int router, int inport, int vc)
+    {
+        return (uint64_t(router) << 40) | (uint64_t(inport) << 20) |
+               uint64_t(vc);
+    }
+
+    int lookup(int router, int inport, int vc) const;
+    void collectBlockedChannels(Tick stall_threshold);
+    void buildEdges();
+    void findCycles();
+};
+
+} // namespace garnet
+} // namespace ruby
+} // namespace gem5
+
+#endif // __MEM_RUBY_NETWORK_GARNET_0_DEADLOCKDETECTOR_HH__
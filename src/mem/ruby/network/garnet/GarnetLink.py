@@ -52,6 +52,9 @@ class NetworkLink(ClockedObject):
         Parent.supported_vnets, "Vnets supported"
     )
     width = Param.UInt32(Parent.width, "bit-width of the link")
+    energy_per_bit = Param.Float(
+        0.0, "dynamic energy (J) per bit traversing the link"
+    )
 
 
 class CreditLink(NetworkLink):
@@ -31,11 +31,17 @@
 
 #include "mem/ruby/network/garnet/GarnetNetwork.hh"
 
+#include <algorithm>
 #include <cassert>
+#include <limits>
+#include <sstream>
 
 #include "base/cast.hh"
 #include "base/compiler.hh"
+#include "base/str.hh"
+#include "debug/Drain.hh"
 #include "debug/RubyNetwork.hh"
+#include "mem/cache/compressors/base.hh"
 #include "mem/ruby/common/NetDest.hh"
 #include "mem/ruby/network/MessageBuffer.hh"
 #include "mem/ruby/network/garnet/CommonTypes.hh"
@@ -43,8 +49,11 @@
 #include "mem/ruby/network/garnet/GarnetLink.hh"
 #include "mem/ruby/network/garnet/NetworkInterface.hh"
 #include "mem/ruby/network/garnet/NetworkLink.hh"
+#include "mem/ruby/network/garnet/OutputUnit.hh"
 #include "mem/ruby/network/garnet/Router.hh"
+#include "mem/ruby/network/garnet/flit.hh"
 #include "mem/ruby/system/RubySystem.hh"
+#include "params/BaseCacheCompressor.hh"
 
 namespace gem5
 {
@@ -62,19 +71,46 @@ namespace garnet
  */
 
 GarnetNetwork::GarnetNetwork(const Params &p)
-    : Network(p)
+    : Network(p), m_in_flight(256), m_deadlock_detector(this),
+      m_deadlock_detection_event([this]{ sampleChannelDependencies(); },
+                                 "Garnet deadlock detection"),
+      m_power_trace(nullptr),
+      m_power_trace_event([this]{ tracePower(); }, "Garnet power trace"),
+      m_drain_event([this]{ testDrainComplete(); }, "Garnet drain check")
 {
     m_num_rows = p.num_rows;
+    m_topology_type = p.topology_type;
+    m_dragonfly_group_size = p.dragonfly_group_size;
+    m_dragonfly_global_links = p.dragonfly_global_links;
+    m_dragonfly_num_groups = 0;
+    m_num_vc_classes = 1;
+    m_vc_class_phases = 1;
     m_ni_flit_size = p.ni_flit_size;
     m_max_vcs_per_vnet = 0;
     m_buffers_per_data_vc = p.buffers_per_data_vc;
     m_buffers_per_ctrl_vc = p.buffers_per_ctrl_vc;
     m_routing_algorithm = p.routing_algorithm;
     m_next_packet_id = 0;
+    m_deadlock_detection_interval = p.deadlock_detection_interval;
+    m_escape_vc_recovery = p.escape_vc_recovery;
+    m_max_packet_hops = p.max_packet_hops;
+    m_max_redirects = p.max_redirects;
+    m_hop_budget_policy = p.hop_budget_policy;
+    m_switch_bypass = p.switch_bypass;
+    m_multicast = p.multicast;
+    m_compressor = p.ni_compressor;
+    m_source_routing = p.source_routing;
+    m_source_route_epoch = p.source_route_epoch;
+    m_power_trace_interval = p.power_trace_interval;
+    m_power_trace_file = p.power_trace_file;
 
     m_enable_fault_model = p.enable_fault_model;
     if (m_enable_fault_model)
         fault_model = p.fault_model;
+    m_fault_temperature = p.fault_temperature;
+    m_fault_rate_scale = p.fault_rate_scale;
+    m_fault_schedule = p.fault_schedule;
+    m_fault_trust_penalty = p.fault_trust_penalty;
 
     m_vnet_type.resize(m_virtual_networks);
 
@@ -112,6 +148,20 @@ GarnetNetwork::init()
 {
     Network::init();
 
+    // The NIs compress the data blocks of the packets, which are Ruby
+    // cache lines
+    if (m_compressor) {
+        const auto &compressor_params =
+            dynamic_cast<const BaseCacheCompressorParams &>(
+                m_compressor->params());
+        fatal_if(compressor_params.block_size !=
+                 RubySystem::getBlockSizeBytes(),
+                 "%s: ni_compressor block size (%d B) differs from the "
+                 "Ruby block size (%d B)", name(),
+                 compressor_params.block_size,
+                 RubySystem::getBlockSizeBytes());
+    }
+
     for (int i=0; i < m_nodes; i++) {
         m_nis[i]->addNode(m_toNetQueues[i], m_fromNetQueues[i]);
     }
@@ -134,6 +184,83 @@ GarnetNetwork::init()
         m_num_cols = -1;
     }
 
+    bool is_mesh = m_topology_type == GarnetTopology::Mesh ||
+                   m_topology_type == GarnetTopology::CMesh;
+    const char *topology =
+        GarnetTopologyStrings[static_cast<int>(m_topology_type)];
+
+    // Torus and flattened butterfly routing uses router coordinates,
+    // dragonfly routing the group structure. Their routes avoid cyclic
+    // channel dependencies by VC classes: dateline classes on the
+    // dimension-ordered torus rings, one class per hop in the flattened
+    // butterfly and one per global hop in the dragonfly (a third one
+    // enables the non-minimal routes through an intermediate group).
+    switch (m_topology_type) {
+      case GarnetTopology::Torus:
+      case GarnetTopology::FlattenedButterfly:
+        fatal_if(m_num_rows <= 0, "%s topology requires num_rows > 0.\n",
+                 topology);
+        m_num_vc_classes = 2;
+        break;
+      case GarnetTopology::Dragonfly:
+        fatal_if(m_dragonfly_group_size <= 0 ||
+                 m_dragonfly_global_links <= 0, "Dragonfly topology "
+                 "requires dragonfly_group_size and "
+                 "dragonfly_global_links.\n");
+        m_dragonfly_num_groups =
+            m_dragonfly_group_size * m_dragonfly_global_links + 1;
+        fatal_if((int)m_routers.size() !=
+                 m_dragonfly_group_size * m_dragonfly_num_groups,
+                 "Dragonfly with %d routers per group and %d global "
+                 "links per router needs %d routers, got %d.\n",
+                 m_dragonfly_group_size, m_dragonfly_global_links,
+                 m_dragonfly_group_size * m_dragonfly_num_groups,
+                 m_routers.size());
+        m_num_vc_classes = 3;
+        for (auto router : m_routers) {
+            if (router->get_vc_per_vnet() < 3)
+                m_num_vc_classes = 2;
+        }
+        break;
+      default:
+        break;
+    }
+
+    // The VCs left over make phases of classes for redirected routes
+    if (m_num_vc_classes > 1)
+        m_vc_class_phases = std::numeric_limits<int>::max();
+    for (auto router : m_routers) {
+        fatal_if(router->get_vc_per_vnet() < m_num_vc_classes, "%s "
+                 "topology requires at least %d VCs per vnet at Router "
+                 "%d.\n", topology, m_num_vc_classes, router->get_id());
+        m_vc_class_phases = std::min(m_vc_class_phases,
+            (int)router->get_vc_per_vnet() / m_num_vc_classes);
+        router->init_coordinate_routing();
+    }
+
+    // The escape network is dimension-ordered, so it needs mesh
+    // coordinates and one VC per vnet to spare.
+    if (m_escape_vc_recovery) {
+        fatal_if(m_num_rows <= 0 || !is_mesh, "Escape VC recovery "
+                 "requires a Mesh topology (num_rows > 0).\n");
+        for (auto router : m_routers) {
+            fatal_if(router->get_vc_per_vnet() < 2, "Escape VC recovery "
+                     "requires at least 2 VCs per vnet at Router %d.\n",
+                     router->get_id());
+        }
+    }
+
+    // Forced-minimal packets are routed in dimension order as well
+    // (the other topologies route them on their own coordinates)
+    fatal_if((m_max_packet_hops > 0 || m_max_redirects > 0) &&
+             m_hop_budget_policy == enums::FORCE_MINIMAL &&
+             is_mesh && m_num_rows <= 0, "Forced-minimal hop budget "
+             "policy requires a Mesh topology (num_rows > 0).\n");
+
+    // Source routes are built on mesh coordinates
+    fatal_if(m_source_routing && (m_num_rows <= 0 || !is_mesh),
+             "Source routing requires a Mesh topology (num_rows > 0).\n");
+
     // FaultModel: declare each router to the fault model
     if (isFaultModelEnabled()) {
         for (std::vector<Router*>::const_iterator i= m_routers.begin();
@@ -148,8 +275,135 @@ GarnetNetwork::init()
             assert(router_id == router->get_id());
             router->printAggregateFaultProbability(std::cout);
             router->printFaultVector(std::cout);
+
+            // The links of a faulty router corrupt flits
+            if (m_fault_rate_scale > 0) {
+                float fault_prob;
+                router->get_aggregate_fault_probability(m_fault_temperature,
+                                                        &fault_prob);
+                router->set_link_fault_prob(
+                    std::min(1.0, fault_prob * m_fault_rate_scale));
+            }
+        }
+    }
+
+    // Scheduled link faults
+    for (auto &entry : m_fault_schedule) {
+        std::vector<std::string> fields;
+        tokenize(fields, entry, ':');
+        int router_id;
+        uint64_t start, end;
+        double prob;
+        fatal_if(fields.size() != 5 || !to_number(fields[0], router_id) ||
+                 !to_number(fields[2], start) ||
+                 !to_number(fields[3], end) ||
+                 !to_number(fields[4], prob),
+                 "Malformed fault_schedule entry '%s'\n", entry);
+        fatal_if(router_id < 0 || router_id >= m_routers.size(),
+                 "fault_schedule entry '%s': no router %d\n", entry,
+                 router_id);
+        m_routers[router_id]->add_link_fault(fields[1], Cycles(start),
+                                             Cycles(end), prob);
+    }
+}
+
+void
+GarnetNetwork::startup()
+{
+    Network::startup();
+
+    if (m_deadlock_detection_interval > 0) {
+        schedule(m_deadlock_detection_event,
+                 clockEdge(m_deadlock_detection_interval));
+    }
+
+    if (m_power_trace_interval > 0) {
+        m_power_trace = simout.create(m_power_trace_file);
+        std::ostream &os = *m_power_trace->stream();
+        os << "tick";
+        for (auto router : m_routers)
+            os << "," << router->name();
+        os << std::endl;
+        schedule(m_power_trace_event, clockEdge(m_power_trace_interval));
+    }
+}
+
+/*
+ * Periodically sample the channel dependency graph. A VC counts as
+ * blocked once it has been waiting in SA for a whole sampling interval.
+ * Every dependency cycle found is reported and, with escape VC recovery
+ * enabled, its head flits are moved onto the escape network so the
+ * simulation keeps making progress.
+ */
+void
+GarnetNetwork::sampleChannelDependencies()
+{
+    m_cdg_samples++;
+
+    int num_cycles = m_deadlock_detector.sample(
+        cyclesToTicks(m_deadlock_detection_interval));
+    m_deadlocks_detected += num_cycles;
+
+    for (auto &cycle : m_deadlock_detector.getCycles()) {
+        std::ostringstream oss;
+        for (auto &channel : cycle) {
+            Router *router = m_routers[channel.router];
+            oss << csprintf(" Router%d[%s].vc%d", channel.router,
+                router->getPortDirectionName(
+                    router->getInportDirection(channel.inport)),
+                channel.vc);
+        }
+        warn("%s: deadlock at cycle %lld among %d channels:%s\n", name(),
+             curCycle(), cycle.size(), oss.str());
+
+        if (!m_escape_vc_recovery)
+            continue;
+
+        for (auto &channel : cycle) {
+            Router *router = m_routers[channel.router];
+            if (router->divert_to_escape_vc(channel.inport, channel.vc)) {
+                m_escape_vc_diversions++;
+                router->schedule_wakeup(Cycles(1));
+            }
         }
     }
+
+    schedule(m_deadlock_detection_event,
+             clockEdge(m_deadlock_detection_interval));
+}
+
+/*
+ * Periodically write the dynamic power (W) of every router over the
+ * last interval, e.g. as input to an external thermal model. The same
+ * interval power is reported by RouterPowerModel to gem5's thermal
+ * model.
+ */
+void
+GarnetNetwork::tracePower()
+{
+    std::ostream &os = *m_power_trace->stream();
+    os << curTick();
+    for (auto router : m_routers) {
+        router->sample_power();
+        os << "," << router->get_dynamic_power();
+    }
+    os << std::endl;
+
+    schedule(m_power_trace_event, clockEdge(m_power_trace_interval));
+}
+
+// Routers (with the links they drive) and the NI-to-router links
+double
+GarnetNetwork::getDynamicEnergy()
+{
+    double energy = 0;
+    for (auto router : m_routers)
+        energy += router->get_dynamic_energy();
+    for (auto link : m_networklinks) {
+        if (link->getType() == EXT_IN_)
+            energy += link->getDynamicEnergy();
+    }
+    return energy;
 }
 
 /*
@@ -193,8 +447,14 @@ GarnetNetwork::makeExtInLink(NodeID global_src, SwitchID dest, BasicLink* link,
      * bridge before connecting the link. Example, if an external
      * bridge is enabled, we would connect:
      * NI--->NetworkBridge--->GarnetExtLink---->Router
+     *
+     * A bridge that would convert nothing (SerDes between equal
+     * widths, CDC between equal clocks) is left out of the link.
      */
-    if (garnet_link->extBridgeEn) {
+    if (garnet_link->extBridgeEn &&
+        !garnet_link->extNetBridge[LinkDirection_In]->isPassThrough(
+            garnet_link->extCdcEn, garnet_link->extSerdesEn,
+            m_nis[local_src])) {
         DPRINTF(RubyNetwork, "Enable external bridge for %s\n",
             garnet_link->name());
         NetworkBridge *n_bridge = garnet_link->extNetBridge[LinkDirection_In];
@@ -208,7 +468,10 @@ GarnetNetwork::makeExtInLink(NodeID global_src, SwitchID dest, BasicLink* link,
             m_routers[dest]->get_vc_per_vnet());
     }
 
-    if (garnet_link->intBridgeEn) {
+    if (garnet_link->intBridgeEn &&
+        !garnet_link->intNetBridge[LinkDirection_In]->isPassThrough(
+            garnet_link->intCdcEn, garnet_link->intSerdesEn,
+            m_routers[dest])) {
         DPRINTF(RubyNetwork, "Enable internal bridge for %s\n",
             garnet_link->name());
         NetworkBridge *n_bridge = garnet_link->intNetBridge[LinkDirection_In];
@@ -267,7 +530,10 @@ GarnetNetwork::makeExtOutLink(SwitchID src, NodeID global_dest,
      * bridge is enabled, we would connect:
      * NI<---NetworkBridge<---GarnetExtLink<----Router
      */
-    if (garnet_link->extBridgeEn) {
+    if (garnet_link->extBridgeEn &&
+        !garnet_link->extNetBridge[LinkDirection_Out]->isPassThrough(
+            garnet_link->extCdcEn, garnet_link->extSerdesEn,
+            m_nis[local_dest])) {
         DPRINTF(RubyNetwork, "Enable external bridge for %s\n",
             garnet_link->name());
         NetworkBridge *n_bridge = garnet_link->extNetBridge[LinkDirection_Out];
@@ -278,7 +544,10 @@ GarnetNetwork::makeExtOutLink(SwitchID src, NodeID global_dest,
         m_nis[local_dest]->addInPort(net_link, credit_link);
     }
 
-    if (garnet_link->intBridgeEn) {
+    if (garnet_link->intBridgeEn &&
+        !garnet_link->intNetBridge[LinkDirection_Out]->isPassThrough(
+            garnet_link->intCdcEn, garnet_link->intSerdesEn,
+            m_routers[src])) {
         DPRINTF(RubyNetwork, "Enable internal bridge for %s\n",
             garnet_link->name());
         NetworkBridge *n_bridge = garnet_link->intNetBridge[LinkDirection_Out];
@@ -323,6 +592,11 @@ GarnetNetwork::makeInternalLink(SwitchID src, SwitchID dest, BasicLink* link,
                              std::max(m_routers[dest]->get_vc_per_vnet(),
                              m_routers[src]->get_vc_per_vnet()));
 
+    // Port indices the link is about to occupy at either end.
+    // Used to walk the channel dependency graph.
+    int src_outport = m_routers[src]->get_num_outports();
+    int dst_inport = m_routers[dest]->get_num_inports();
+
     /*
      * We check if a bridge was enabled at any end of the link.
      * The bridge is enabled if either of clock domain
@@ -336,7 +610,9 @@ GarnetNetwork::makeInternalLink(SwitchID src, SwitchID dest, BasicLink* link,
      * bridge is enabled, we would connect:
      * Router--->NetworkBridge--->GarnetIntLink---->Router
      */
-    if (garnet_link->dstBridgeEn) {
+    if (garnet_link->dstBridgeEn &&
+        !garnet_link->dstNetBridge->isPassThrough(garnet_link->dstCdcEn,
+            garnet_link->dstSerdesEn, m_routers[dest])) {
         DPRINTF(RubyNetwork, "Enable destination bridge for %s\n",
             garnet_link->name());
         NetworkBridge *n_bridge = garnet_link->dstNetBridge;
@@ -347,7 +623,9 @@ GarnetNetwork::makeInternalLink(SwitchID src, SwitchID dest, BasicLink* link,
         m_routers[dest]->addInPort(dst_inport_dirn, net_link, credit_link);
     }
 
-    if (garnet_link->srcBridgeEn) {
+    if (garnet_link->srcBridgeEn &&
+        !garnet_link->srcNetBridge->isPassThrough(garnet_link->srcCdcEn,
+            garnet_link->srcSerdesEn, m_routers[src])) {
         DPRINTF(RubyNetwork, "Enable source bridge for %s\n",
             garnet_link->name());
         NetworkBridge *n_bridge = garnet_link->srcNetBridge;
@@ -363,6 +641,9 @@ GarnetNetwork::makeInternalLink(SwitchID src, SwitchID dest, BasicLink* link,
                         link->m_weight, credit_link,
                         m_routers[dest]->get_vc_per_vnet());
     }
+
+    m_routers[src]->getOutputUnit(src_outport)->
+        set_downstream(dest, dst_inport);
 }
 
 // Total routers in the network
@@ -588,6 +869,102 @@ GarnetNetwork::regStats()
     m_packets_rerouted
         .name(name()+".s4_packets_rerouted");
 
+    // Deadlock detection
+    m_cdg_samples
+        .name(name() + ".cdg_samples")
+        .flags(statistics::nozero);
+    m_deadlocks_detected
+        .name(name() + ".deadlocks_detected");
+    m_escape_vc_diversions
+        .name(name() + ".escape_vc_diversions")
+        .flags(statistics::nozero);
+
+    // Hop/redirect budget
+    m_hop_budget_exhausted
+        .name(name() + ".hop_budget_exhausted");
+    m_redirect_budget_exhausted
+        .name(name() + ".redirect_budget_exhausted");
+    m_budget_drops
+        .name(name() + ".budget_drops")
+        .flags(statistics::nozero);
+    m_budget_forced_minimal
+        .name(name() + ".budget_forced_minimal")
+        .flags(statistics::nozero);
+
+    // Switch bypass
+    m_bypass_attempts
+        .name(name() + ".bypass_attempts")
+        .flags(statistics::nozero);
+    m_bypass_hits
+        .name(name() + ".bypass_hits")
+        .flags(statistics::nozero);
+    m_bypass_hit_rate
+        .name(name() + ".bypass_hit_rate")
+        .flags(statistics::nozero);
+    m_bypass_hit_rate = m_bypass_hits / m_bypass_attempts;
+
+    // Multicast
+    m_multicast_packets
+        .name(name() + ".multicast_packets")
+        .desc("packets injected with more than one destination")
+        .flags(statistics::nozero);
+    m_multicast_flits_saved
+        .name(name() + ".multicast_flits_saved")
+        .desc("flits not injected compared to one packet per destination")
+        .flags(statistics::nozero);
+    m_multicast_forks
+        .name(name() + ".multicast_forks")
+        .desc("flit copies made by the routers for multicast branches")
+        .flags(statistics::nozero);
+
+    // Compression
+    m_compressed_packets
+        .name(name() + ".compressed_packets")
+        .desc("data packets compressed at the source NI")
+        .flags(statistics::nozero);
+    m_compression_original_bytes
+        .name(name() + ".compression_original_bytes")
+        .desc("size of the compressed packets before compression")
+        .flags(statistics::nozero);
+    m_compression_compressed_bytes
+        .name(name() + ".compression_compressed_bytes")
+        .desc("size of the compressed packets after compression")
+        .flags(statistics::nozero);
+    m_compression_flits_saved
+        .name(name() + ".compression_flits_saved")
+        .desc("flits not injected thanks to compression")
+        .flags(statistics::nozero);
+    m_compression_ratio
+        .name(name() + ".compression_ratio")
+        .desc("original bytes per compressed byte of the compressed packets")
+        .flags(statistics::nozero);
+    m_compression_ratio =
+        m_compression_original_bytes / m_compression_compressed_bytes;
+
+    // Link faults
+    m_flits_corrupted
+        .name(name() + ".flits_corrupted")
+        .desc("flits corrupted on faulty links")
+        .flags(statistics::nozero);
+    m_packets_corrupted
+        .name(name() + ".packets_corrupted")
+        .desc("packets NACKed by their destination NI after corruption")
+        .flags(statistics::nozero);
+    m_goodput_flits
+        .name(name() + ".goodput_flits")
+        .desc("flits of the packets delivered intact to the protocol");
+    m_goodput_ratio
+        .name(name() + ".goodput_ratio")
+        .desc("goodput flits per flit received (raw throughput)");
+    m_goodput_ratio = m_goodput_flits / sum(m_flits_received);
+
+    // Energy model
+    m_dynamic_energy
+        .functor([this]() { return getDynamicEnergy(); })
+        .name(name() + ".dynamic_energy")
+        .desc("dynamic energy of the network (J)")
+        .flags(statistics::nozero);
+
     // Traffic distribution
     for (int source = 0; source < m_routers.size(); ++source) {
         m_data_traffic_distribution.push_back(
@@ -639,6 +1016,8 @@ GarnetNetwork::collateStats()
     // Ask the routers to collate their statistics
     for (int i = 0; i < m_routers.size(); i++) {
         m_routers[i]->collateStats();
+        m_bypass_attempts += m_routers[i]->get_bypass_attempts();
+        m_bypass_hits += m_routers[i]->get_bypass_hits();
     }
 }
 
@@ -656,6 +1035,139 @@ GarnetNetwork::resetStats()
     }
 }
 
+/*
+ * Trust-weighted minimal path between two mesh routers, encoded for
+ * RoutingUnit::outportComputeSource (two bits per hop: 0 North, 1 East,
+ * 2 South, 3 West). As in hop by hop (DXY) routing, each router on the
+ * path takes the more trusted of its minimal directions, the X one on a
+ * tie. A path longer than the 32 hops the header holds is left to hop
+ * by hop routing (no hops).
+ */
+std::pair<uint64_t, int>
+GarnetNetwork::computeSourceRoute(int src_router, int dest_router)
+{
+    static const PortDirection dirns[] = {"North", "East", "South", "West"};
+    const int steps[] = {m_num_cols, 1, -m_num_cols, -1};
+    const int max_hops = 32;
+
+    uint64_t path = 0;
+    int hops = 0;
+    for (int id = src_router; id != dest_router; hops++) {
+        if (hops == max_hops)
+            return {0, 0};
+
+        int x_hops = dest_router % m_num_cols - id % m_num_cols;
+        int y_hops = dest_router / m_num_cols - id / m_num_cols;
+        int x_dirn = x_hops > 0 ? 1 : 3;
+        int y_dirn = y_hops > 0 ? 0 : 2;
+
+        int dirn;
+        if (x_hops == 0) {
+            dirn = y_dirn;
+        } else if (y_hops == 0) {
+            dirn = x_dirn;
+        } else {
+            Router *router = m_routers[id];
+            dirn = router->get_trust(dirns[y_dirn]) >
+                router->get_trust(dirns[x_dirn]) ? y_dirn : x_dirn;
+        }
+
+        path |= (uint64_t)dirn << (2 * hops);
+        id += steps[dirn];
+    }
+    return {path, hops};
+}
+
+const std::vector<GarnetNetwork::CheckpointedCounter> &
+GarnetNetwork::checkpointedCounters()
+{
+    static const std::vector<CheckpointedCounter> counters = {
+        {"total_L1_requests", &GarnetNetwork::m_total_L1_requests},
+        {"total_requests_through_trojan",
+         &GarnetNetwork::m_total_requests_through_trojan},
+        {"packets_rerouted", &GarnetNetwork::m_packets_rerouted},
+        {"hop_budget_exhausted", &GarnetNetwork::m_hop_budget_exhausted},
+        {"redirect_budget_exhausted",
+         &GarnetNetwork::m_redirect_budget_exhausted},
+        {"budget_drops", &GarnetNetwork::m_budget_drops},
+        {"budget_forced_minimal", &GarnetNetwork::m_budget_forced_minimal},
+        {"flits_corrupted", &GarnetNetwork::m_flits_corrupted},
+        {"packets_corrupted", &GarnetNetwork::m_packets_corrupted},
+        {"goodput_flits", &GarnetNetwork::m_goodput_flits},
+    };
+    return counters;
+}
+
+bool
+GarnetNetwork::linksDrained()
+{
+    for (auto link : m_networklinks) {
+        if (!link->getBuffer()->isEmpty())
+            return false;
+    }
+    for (auto link : m_creditlinks) {
+        if (!link->getBuffer()->isEmpty())
+            return false;
+    }
+    for (auto bridge : m_networkbridges) {
+        if (!bridge->getBuffer()->isEmpty())
+            return false;
+    }
+    return true;
+}
+
+// The links are not objects the flits wake up once consumed, so the
+// network checks them every cycle until they are empty
+void
+GarnetNetwork::testDrainComplete()
+{
+    if (drainState() != DrainState::Draining)
+        return;
+
+    if (linksDrained()) {
+        DPRINTF(Drain, "Garnet links done draining\n");
+        signalDrainDone();
+    } else {
+        schedule(m_drain_event, clockEdge(Cycles(1)));
+    }
+}
+
+DrainState
+GarnetNetwork::drain()
+{
+    if (!linksDrained()) {
+        DPRINTF(Drain, "Garnet links not drained\n");
+        if (!m_drain_event.scheduled())
+            schedule(m_drain_event, clockEdge(Cycles(1)));
+        return DrainState::Draining;
+    }
+    return DrainState::Drained;
+}
+
+void
+GarnetNetwork::serialize(CheckpointOut &cp) const
+{
+    // packet ids stay unique across a checkpoint
+    SERIALIZE_SCALAR(m_next_packet_id);
+
+    for (auto &counter : checkpointedCounters())
+        paramOut(cp, counter.first, (this->*counter.second).value());
+}
+
+void
+GarnetNetwork::unserialize(CheckpointIn &cp)
+{
+    UNSERIALIZE_SCALAR(m_next_packet_id);
+
+    // Checkpoints taken before the counters were added restore without
+    // them
+    for (auto &counter : checkpointedCounters()) {
+        statistics::Counter value;
+        if (optParamIn(cp, counter.first, value))
+            this->*counter.second = value;
+    }
+}
+
 void
 GarnetNetwork::print(std::ostream& out) const
 {
@@ -675,51 +1187,24 @@ GarnetNetwork::update_traffic_distribution(RouteInfo route)
         (*m_ctrl_traffic_distribution[src_node][dest_node])++;
 }
 
+// The messages in the network are those of its live flits, which are
+// indexed by line (see FlitMsgPtr)
 bool
-GarnetNetwork::functionalRead(Packet *pkt, WriteMask &mask)
+GarnetNetwork::functionalRead(Packet *pkt)
 {
-    bool read = false;
-    for (unsigned int i = 0; i < m_routers.size(); i++) {
-        if (m_routers[i]->functionalRead(pkt, mask))
-            read = true;
-    }
-
-    for (unsigned int i = 0; i < m_nis.size(); ++i) {
-        if (m_nis[i]->functionalRead(pkt, mask))
-            read = true;
-    }
-
-    for (unsigned int i = 0; i < m_networklinks.size(); ++i) {
-        if (m_networklinks[i]->functionalRead(pkt, mask))
-            read = true;
-    }
-
-    for (unsigned int i = 0; i < m_networkbridges.size(); ++i) {
-        if (m_networkbridges[i]->functionalRead(pkt, mask))
-            read = true;
-    }
+    return m_in_flight.functionalRead(pkt);
+}
 
-    return read;
+bool
+GarnetNetwork::functionalRead(Packet *pkt, WriteMask &mask)
+{
+    return m_in_flight.functionalRead(pkt, mask);
 }
 
 uint32_t
 GarnetNetwork::functionalWrite(Packet *pkt)
 {
-    uint32_t num_functional_writes = 0;
-
-    for (unsigned int i = 0; i < m_routers.size(); i++) {
-        num_functional_writes += m_routers[i]->functionalWrite(pkt);
-    }
-
-    for (unsigned int i = 0; i < m_nis.size(); ++i) {
-        num_functional_writes += m_nis[i]->functionalWrite(pkt);
-    }
-
-    for (unsigned int i = 0; i < m_networklinks.size(); ++i) {
-        num_functional_writes += m_networklinks[i]->functionalWrite(pkt);
-    }
-
-    return num_functional_writes;
+    return m_in_flight.functionalWrite(pkt);
 }
 
 } // namespace garnet
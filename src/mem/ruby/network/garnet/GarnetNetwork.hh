@@ -33,16 +33,25 @@
 #define __MEM_RUBY_NETWORK_GARNET_0_GARNETNETWORK_HH__
 
 #include <iostream>
+#include <string>
 #include <vector>
 
+#include "base/output.hh"
+#include "mem/ruby/network/MessageIndex.hh"
 #include "mem/ruby/network/Network.hh"
 #include "mem/ruby/network/fault_model/FaultModel.hh"
 #include "mem/ruby/network/garnet/CommonTypes.hh"
+#include "mem/ruby/network/garnet/DeadlockDetector.hh"
 #include "params/GarnetNetwork.hh"
 
 namespace gem5
 {
 
+namespace compression
+{
+class Base;
+}
+
 namespace ruby
 {
 
@@ -66,6 +75,7 @@ class GarnetNetwork : public Network
     ~GarnetNetwork() = default;
 
     void init();
+    void startup() override;
 
     const char *garnetVersion = "3.0";
 
@@ -75,6 +85,26 @@ class GarnetNetwork : public Network
     int getNumRows() const { return m_num_rows; }
     int getNumCols() { return m_num_cols; }
 
+    // Coordinate-routed topologies (see RoutingUnit)
+    GarnetTopology getTopologyType() const { return m_topology_type; }
+    int getDragonflyGroupSize() const { return m_dragonfly_group_size; }
+    int getDragonflyGlobalLinks() const { return m_dragonfly_global_links; }
+    int getDragonflyNumGroups() const { return m_dragonfly_num_groups; }
+    // VC classes of a route phase (1: no classes). The VCs of each vnet
+    // are split into getVcClassPhases() phases of that many classes.
+    int getNumVcClasses() const { return m_num_vc_classes; }
+    int getVcClassPhases() const { return m_vc_class_phases; }
+    // A redirect makes the route start over from the redirecting router,
+    // in the next phase of VC classes so that the channel dependencies of
+    // the new route do not close a cycle with those of the old one. There
+    // must be a phase left for it.
+    bool
+    canRedirect(const RouteInfo &route) const
+    {
+        return m_num_vc_classes <= 1 ||
+               route.redirects + 1 < m_vc_class_phases;
+    }
+
     // for network
     uint32_t getNiFlitSize() const { return m_ni_flit_size; }
     uint32_t getBuffersPerDataVC() { return m_buffers_per_data_vc; }
@@ -84,6 +114,33 @@ class GarnetNetwork : public Network
     bool isFaultModelEnabled() const { return m_enable_fault_model; }
     FaultModel* fault_model;
 
+    // Link fault injection
+    uint32_t getFaultTrustPenalty() const { return m_fault_trust_penalty; }
+
+    // Deadlock detection and recovery
+    bool isEscapeVcEnabled() const { return m_escape_vc_recovery; }
+
+    bool isSwitchBypassEnabled() const { return m_switch_bypass; }
+    bool isMulticastEnabled() const { return m_multicast; }
+
+    // Data compression at the NIs (nullptr: disabled)
+    compression::Base* getCompressor() const { return m_compressor; }
+
+    // Source routing
+    bool isSourceRoutingEnabled() const { return m_source_routing; }
+    Cycles getSourceRouteEpoch() const { return m_source_route_epoch; }
+    std::pair<uint64_t, int> computeSourceRoute(int src_router,
+                                                int dest_router);
+
+    // Hop/redirect budget of a packet (0: unlimited)
+    uint32_t getMaxPacketHops() const { return m_max_packet_hops; }
+    uint32_t getMaxRedirects() const { return m_max_redirects; }
+    enums::HopBudgetPolicy
+    getHopBudgetPolicy() const
+    {
+        return m_hop_budget_policy;
+    }
+
 
     // Internal configuration
     bool isVNetOrdered(int vnet) const { return m_ordered[vnet]; }
@@ -106,10 +163,13 @@ class GarnetNetwork : public Network
                           PortDirection src_outport_dirn,
                           PortDirection dest_inport_dirn);
 
+    bool functionalRead(Packet *pkt);
     bool functionalRead(Packet *pkt, WriteMask &mask);
     //! Function for performing a functional write. The return value
     //! indicates the number of messages that were written.
     uint32_t functionalWrite(Packet *pkt);
+    // The messages of the live flits of this network (see FlitMsgPtr)
+    MessageIndex &inFlight() { return m_in_flight; }
 
     // Stats
     void collateStats();
@@ -117,6 +177,18 @@ class GarnetNetwork : public Network
     void resetStats();
     void print(std::ostream& out) const;
 
+    // Checkpointing (trust lives in the routers). The routers and NIs
+    // drain their own buffers; the network is drained once no flit or
+    // credit is left on a link.
+    DrainState drain() override;
+    void serialize(CheckpointOut &cp) const override;
+    void unserialize(CheckpointIn &cp) override;
+    // The counters of the trust-based routing, checkpointed along with
+    // the trust they were measured with (name in the checkpoint, counter)
+    typedef std::pair<const char *, statistics::Scalar GarnetNetwork::*>
+        CheckpointedCounter;
+    static const std::vector<CheckpointedCounter> &checkpointedCounters();
+
     // increment counters
     void increment_injected_packets(int vnet) { m_packets_injected[vnet]++; }
     // void increment_retransmitted_packets(int vnet) { m_packets_retransmitted[vnet]++; }
@@ -185,16 +257,82 @@ class GarnetNetwork : public Network
         return m_routers[id];
     }
 
+    NetworkInterface *
+    getNetworkInterface(int ni)
+    {
+        return m_nis[ni];
+    }
+
+    // hop/redirect budget
+    void increment_hop_budget_exhausted() { m_hop_budget_exhausted++; }
+    void
+    increment_redirect_budget_exhausted()
+    {
+        m_redirect_budget_exhausted++;
+    }
+    void increment_budget_drops() { m_budget_drops++; }
+    void increment_budget_forced_minimal() { m_budget_forced_minimal++; }
+
+    // multicast
+    void
+    increment_multicast_packets(int num_dests, int num_flits)
+    {
+        m_multicast_packets++;
+        m_multicast_flits_saved += (num_dests - 1) * num_flits;
+    }
+    void increment_multicast_forks() { m_multicast_forks++; }
+
+    // compression
+    void
+    increment_compressed_packets(int orig_bytes, int comp_bytes,
+                                 int flits_saved)
+    {
+        m_compressed_packets++;
+        m_compression_original_bytes += orig_bytes;
+        m_compression_compressed_bytes += comp_bytes;
+        m_compression_flits_saved += flits_saved;
+    }
+
+    // link faults
+    void increment_flits_corrupted() { m_flits_corrupted++; }
+    void increment_packets_corrupted() { m_packets_corrupted++; }
+    void increment_goodput_flits(int num_flits)
+    {
+        m_goodput_flits += num_flits;
+    }
+
   protected:
     // Configuration
     int m_num_rows;
     int m_num_cols;
+    GarnetTopology m_topology_type;
+    int m_dragonfly_group_size;
+    int m_dragonfly_global_links;
+    int m_dragonfly_num_groups;
+    int m_num_vc_classes;
+    int m_vc_class_phases;
     uint32_t m_ni_flit_size;
     uint32_t m_max_vcs_per_vnet;
     uint32_t m_buffers_per_ctrl_vc;
     uint32_t m_buffers_per_data_vc;
     int m_routing_algorithm;
     bool m_enable_fault_model;
+    int m_fault_temperature;
+    double m_fault_rate_scale;
+    std::vector<std::string> m_fault_schedule;
+    uint32_t m_fault_trust_penalty;
+    Cycles m_deadlock_detection_interval;
+    bool m_escape_vc_recovery;
+    uint32_t m_max_packet_hops;
+    uint32_t m_max_redirects;
+    enums::HopBudgetPolicy m_hop_budget_policy;
+    bool m_switch_bypass;
+    bool m_multicast;
+    compression::Base* m_compressor;
+    bool m_source_routing;
+    Cycles m_source_route_epoch;
+    Cycles m_power_trace_interval;
+    std::string m_power_trace_file;
 
     // Statistical variables
     statistics::Vector m_packets_received;
@@ -244,6 +382,42 @@ class GarnetNetwork : public Network
     statistics::Scalar m_total_requests_through_trojan;
     statistics::Scalar m_packets_rerouted;
 
+    // Deadlock detection
+    statistics::Scalar m_cdg_samples;
+    statistics::Scalar m_deadlocks_detected;
+    statistics::Scalar m_escape_vc_diversions;
+
+    // Hop/redirect budget
+    statistics::Scalar m_hop_budget_exhausted;
+    statistics::Scalar m_redirect_budget_exhausted;
+    statistics::Scalar m_budget_drops;
+    statistics::Scalar m_budget_forced_minimal;
+
+    // Switch bypass
+    statistics::Scalar m_bypass_attempts;
+    statistics::Scalar m_bypass_hits;
+    statistics::Formula m_bypass_hit_rate;
+
+    // Multicast
+    statistics::Scalar m_multicast_packets;
+    statistics::Scalar m_multicast_flits_saved;
+    statistics::Scalar m_multicast_forks;
+
+    // Compression
+    statistics::Scalar m_compressed_packets;
+    statistics::Scalar m_compression_original_bytes;
+    statistics::Scalar m_compression_compressed_bytes;
+    statistics::Scalar m_compression_flits_saved;
+    statistics::Formula m_compression_ratio;
+
+    // Link faults
+    statistics::Scalar m_flits_corrupted;
+    statistics::Scalar m_packets_corrupted;
+    statistics::Scalar m_goodput_flits;
+    statistics::Formula m_goodput_ratio;
+
+    // Energy model
+    statistics::Value m_dynamic_energy;
 
   private:
     GarnetNetwork(const GarnetNetwork& obj);
@@ -256,6 +430,20 @@ class GarnetNetwork : public Network
     std::vector<CreditLink *> m_creditlinks; // All credit links in the network
     std::vector<NetworkInterface *> m_nis;   // All NI's in Network
     int m_next_packet_id; // static vairable for packet id allocation
+    MessageIndex m_in_flight;
+
+    DeadlockDetector m_deadlock_detector;
+    EventFunctionWrapper m_deadlock_detection_event;
+    void sampleChannelDependencies();
+
+    double getDynamicEnergy();
+    OutputStream *m_power_trace;
+    EventFunctionWrapper m_power_trace_event;
+    void tracePower();
+
+    bool linksDrained();
+    EventFunctionWrapper m_drain_event;
+    void testDrainComplete();
 };
 
 inline std::ostream&
@@ -33,6 +33,23 @@ from m5.proxy import *
 from m5.objects.Network import RubyNetwork
 from m5.objects.BasicRouter import BasicRouter
 from m5.objects.ClockedObject import ClockedObject
+from m5.objects.PowerModelState import PowerModelState
+
+
+class HopBudgetPolicy(Enum):
+    vals = ["DROP_NACK", "FORCE_MINIMAL"]
+
+
+class GarnetSwitchAllocator(ScopedEnum):
+    vals = ["RoundRobin", "ISlip", "Wavefront", "AgeBased"]
+
+
+class GarnetVcAllocation(ScopedEnum):
+    vals = ["Fused", "Separate", "Speculative"]
+
+
+class GarnetTopology(ScopedEnum):
+    vals = ["Mesh", "CMesh", "Torus", "FlattenedButterfly", "Dragonfly"]
 
 
 class GarnetNetwork(RubyNetwork):
@@ -41,6 +58,15 @@ class GarnetNetwork(RubyNetwork):
     cxx_class = "gem5::ruby::garnet::GarnetNetwork"
 
     num_rows = Param.Int(0, "number of rows if 2D (mesh/torus/..) topology")
+    topology_type = Param.GarnetTopology(
+        "Mesh",
+        "topology the coordinate-based routing in RoutingUnit assumes "
+        "(see configs/topologies)",
+    )
+    dragonfly_group_size = Param.UInt32(0, "routers per dragonfly group")
+    dragonfly_global_links = Param.UInt32(
+        0, "global links per dragonfly router"
+    )
     ni_flit_size = Param.UInt32(16, "network interface flit size in bytes")
     vcs_per_vnet = Param.UInt32(5, "virtual channels per virtual network")
     buffers_per_data_vc = Param.UInt32(5, "buffers per data virtual channel")
@@ -48,9 +74,100 @@ class GarnetNetwork(RubyNetwork):
     routing_algorithm = Param.Int(0, "0: Weight-based Table, 1: XY, 2: Custom")
     enable_fault_model = Param.Bool(False, "enable network fault model")
     fault_model = Param.FaultModel(NULL, "network fault model")
+    source_routing = Param.Bool(
+        False,
+        "the source NI picks the whole (trust-weighted, minimal) path of "
+        "a packet and the routers follow it without route computation "
+        "(Mesh topology)",
+    )
+    source_route_epoch = Param.Cycles(
+        10000,
+        "cycles after which the NIs recompute their cached source "
+        "routes from the current trust",
+    )
+    fault_temperature = Param.Int(
+        71, "temperature (C) at which the fault model is evaluated"
+    )
+    fault_rate_scale = Param.Float(
+        0.0,
+        "scales the aggregate fault probability of a router into the "
+        "probability that a flit it sends over a link is corrupted "
+        "(0: the fault model does not corrupt flits)",
+    )
+    fault_schedule = VectorParam.String(
+        [],
+        "link fault injection schedule, one "
+        "'<router>:<outport direction>:<start cycle>:<end cycle>:"
+        "<flit corruption probability>' entry per fault "
+        "(end cycle 0: until the end of the simulation)",
+    )
+    fault_trust_penalty = Param.UInt32(
+        1, "trust charges on a link per flit corrupted on it"
+    )
     garnet_deadlock_threshold = Param.UInt32(
         500000000, "network-level deadlock threshold"
     )
+    deadlock_detection_interval = Param.Cycles(
+        0,
+        "cycles between channel dependency graph samples used to detect "
+        "deadlocks (0: disabled)",
+    )
+    escape_vc_recovery = Param.Bool(
+        False,
+        "reserve the first VC of each vnet as an XY-routed escape channel "
+        "and divert deadlocked packets onto it (Mesh only)",
+    )
+    max_packet_hops = Param.UInt32(
+        0, "router hops a packet may take before its budget is exhausted "
+        "(0: unlimited)"
+    )
+    max_redirects = Param.UInt32(
+        0, "times a packet may be redirected at trojans before its budget "
+        "is exhausted (0: unlimited)"
+    )
+    switch_bypass = Param.Bool(
+        False,
+        "let flits that meet no contention skip the router pipeline "
+        "and traverse the switch in their arrival cycle",
+    )
+    multicast = Param.Bool(
+        False,
+        "inject messages with several destinations as one multicast "
+        "packet, forked at the routers, instead of one unicast packet "
+        "per destination",
+    )
+    ni_compressor = Param.BaseCacheCompressor(
+        NULL,
+        "compress the data block of data packets at the source NI "
+        "with this cache compressor (its block size must be the Ruby "
+        "block size); the packets take fewer flits, and the compressor's "
+        "compression and decompression latencies are added at the source "
+        "and destination NIs",
+    )
+    sw_allocator = Param.GarnetSwitchAllocator(
+        "RoundRobin", "default switch allocator of the routers"
+    )
+    vc_allocation = Param.GarnetVcAllocation(
+        "Fused",
+        "default VC allocation of the routers: fused into SA (Garnet 3.0), "
+        "a separate VA stage, or speculative VA in parallel with SA",
+    )
+    allocator_iterations = Param.UInt32(
+        1, "default iterations of the iterative (iSLIP) switch allocator"
+    )
+    power_trace_interval = Param.Cycles(
+        0,
+        "cycles between samples of the router dynamic power written to "
+        "power_trace_file (0 disables the trace)",
+    )
+    power_trace_file = Param.String(
+        "garnet_power_trace.csv", "router power trace, in the output dir"
+    )
+    hop_budget_policy = Param.HopBudgetPolicy(
+        "FORCE_MINIMAL",
+        "what to do with a packet that exhausted its hop/redirect budget: "
+        "drop it and NACK the source NI, or route it minimally from there",
+    )
 
 
 class GarnetNetworkInterface(ClockedObject):
@@ -83,3 +200,32 @@ class GarnetRouter(BasicRouter):
     width = Param.UInt32(
         Parent.ni_flit_size, "bit width supported by the router"
     )
+    sw_allocator = Param.GarnetSwitchAllocator(
+        Parent.sw_allocator, "switch allocator"
+    )
+    vc_allocation = Param.GarnetVcAllocation(
+        Parent.vc_allocation, "VC allocation: fused, separate or speculative"
+    )
+    allocator_iterations = Param.UInt32(
+        Parent.allocator_iterations, "iterations of the iSLIP allocator"
+    )
+
+    # Dynamic energy (J) per event, for the in-simulator power model
+    buffer_read_energy = Param.Float(0.0, "energy per buffer read")
+    buffer_write_energy = Param.Float(0.0, "energy per buffer write")
+    sw_input_arbiter_energy = Param.Float(
+        0.0, "energy per SA input arbitration"
+    )
+    sw_output_arbiter_energy = Param.Float(
+        0.0, "energy per SA output arbitration"
+    )
+    vc_arbiter_energy = Param.Float(0.0, "energy per VA arbitration")
+    crossbar_energy = Param.Float(0.0, "energy per crossbar traversal")
+
+
+class GarnetRouterPowerModel(PowerModelState):
+    type = "GarnetRouterPowerModel"
+    cxx_header = "mem/ruby/network/garnet/RouterPowerModel.hh"
+    cxx_class = "gem5::ruby::garnet::RouterPowerModel"
+
+    static_power = Param.Float(0.0, "static (leakage) power of the router")
@@ -36,6 +36,7 @@ static bool redirection = false;
 
 #include "debug/RubyNetwork.hh"
 #include "mem/ruby/network/garnet/Credit.hh"
+#include "mem/ruby/network/garnet/NetworkInterface.hh"
 #include "mem/ruby/network/garnet/Router.hh"
 
 int NI_boundary0;
@@ -134,6 +135,18 @@ InputUnit::wakeup()
                 m_router->get_net_ptr()->increment_total_L1_requests();
             }
 
+            // Livelock guard: a packet that has taken too many hops is
+            // dropped or routed minimally from here on
+            GarnetNetwork *net_ptr = m_router->get_net_ptr();
+            bool drop = false;
+            // Multicast packets follow the routing table tree and are
+            // neither budgeted nor redirected
+            if (net_ptr->getMaxPacketHops() > 0 && !t_route.minimal &&
+                !t_route.multicast &&
+                t_route.hops_traversed >= (int)net_ptr->getMaxPacketHops()) {
+                net_ptr->increment_hop_budget_exhausted();
+                drop = exhaustBudget(t_flit);
+            }
 
 
 
@@ -146,13 +159,24 @@ InputUnit::wakeup()
 
                 m_router->get_net_ptr()->increment_total_requests_through_trojan();
 
-                if (shouldReroute())
+                if (!drop && !t_route.multicast &&
+                    !t_flit->get_route().minimal &&
+                    net_ptr->canRedirect(t_flit->get_route()) &&
+                    shouldReroute())
                 {
                     int new_dest_router = GetRedirectionDestionation(m_router->get_id(), mesh_cols, t_flit->get_route().dest_router, m_direction);
                     // cout << "above redirected flag value : " << temp->getRedirectedFlagValue() << "\n\n";
                     // Total L1 requests through Trojan
                     
-                    if (new_dest_router != t_flit->get_route().dest_router)
+                    if (new_dest_router != t_flit->get_route().dest_router &&
+                        net_ptr->getMaxRedirects() > 0 &&
+                        t_flit->get_route().redirects >=
+                            (int)net_ptr->getMaxRedirects())
+                    {
+                        net_ptr->increment_redirect_budget_exhausted();
+                        drop = exhaustBudget(t_flit);
+                    }
+                    else if (new_dest_router != t_flit->get_route().dest_router)
                     {
 
                         m_router->get_net_ptr()->increment_packets_rerouted();
@@ -163,6 +187,14 @@ InputUnit::wakeup()
                         MsgPtr h = t_flit->get_msg_ptr();
                         cout << "redirected flag value : " <<  h->setRedirected() << "\n\n";
                         temp.dest_router = new_dest_router;
+                        temp.redirects++;
+                        // the route starts over in the next phase of VC
+                        // classes
+                        temp.vc_class = 0;
+                        temp.phase_hops = 0;
+                        temp.waypoint = -1;
+                        // the source route leads to the old destination
+                        temp.source_hops = 0;
                         t_flit->set_route(temp);
                     }
                 }
@@ -174,12 +206,30 @@ InputUnit::wakeup()
 
             set_vc_active(vc, curTick());
 
+            if (drop) {
+                virtualChannels[vc].set_dropping();
+                net_ptr->increment_budget_drops();
+                // NACK: the source NI re-injects the original message
+                net_ptr->getNetworkInterface(t_route.src_ni)->retransmit(
+                    t_flit->get_msg_ptr(), t_flit->get_vnet());
+                discardFlit(vc, t_flit);
+                return;
+            }
+
             // Route computation for this vc
                         // std::cout << "Flit id here : " << t_flit -> get_flit_id() << "\n";
             int outport;
                         // int original_router_id;
                         GarnetNetwork *p = m_router->get_net_ptr();
-                        if (t_flit->isModified() && m_router->get_id() == t_flit->modifiedLocation())
+                        if (t_route.multicast)
+                        {
+                            // Fork the packet where its destinations split:
+                            // one branch (outport) per subset
+                            grant_branches(vc,
+                                m_router->route_compute_multicast(t_route));
+                            outport = get_outport(vc);
+                        }
+                        else if (t_flit->isModified() && m_router->get_id() == t_flit->modifiedLocation())
                         {
                             int original_router_id = t_flit->getOriginalLocation();
                             int packet_id = t_flit->getPacketID();
@@ -188,6 +238,14 @@ InputUnit::wakeup()
                             
                             outport = 1;
                         }
+                        else if (t_flit->get_route().source_hops > 0 &&
+                                 !t_flit->get_route().escape &&
+                                 !t_flit->get_route().minimal)
+                        {
+                            // Source routed: pop the next hop (a redirected packet is
+                            // ejected at its redirect target first)
+                            outport = m_router->route_source(t_flit);
+                        }
                         else
                         {
 
@@ -204,6 +262,10 @@ InputUnit::wakeup()
 
         } else {
             assert(virtualChannels[vc].get_state() == ACTIVE_);
+            if (virtualChannels[vc].is_dropping()) {
+                discardFlit(vc, t_flit);
+                return;
+            }
         }
 
 
@@ -221,6 +283,11 @@ InputUnit::wakeup()
             // 1-cycle router
             // Flit goes for SA directly
             t_flit->advance_stage(SA_, curTick());
+        } else if (m_router->get_net_ptr()->isSwitchBypassEnabled() &&
+                   m_router->try_bypass(m_id, vc, t_flit)) {
+            // Switch bypass: the route is computed on arrival (above),
+            // so the flit goes through SA and ST in this cycle
+            t_flit->advance_stage(SA_, curTick());
         } else {
             assert(pipe_stages > 1);
             // Router delay is modeled by making flit wait in buffer for
@@ -394,6 +461,43 @@ int InputUnit::GetRedirectionDestionation(int torjan_id, int mesh_cols, int orig
 }
 
 
+// Apply the configured policy to a head flit whose hop or redirect
+// budget ran out. Returns true if the packet has to be dropped.
+bool
+InputUnit::exhaustBudget(flit *t_flit)
+{
+    GarnetNetwork *net_ptr = m_router->get_net_ptr();
+    if (net_ptr->getHopBudgetPolicy() == enums::DROP_NACK)
+        return true;
+
+    RouteInfo route = t_flit->get_route();
+    route.minimal = true;
+    t_flit->set_route(route);
+    net_ptr->increment_budget_forced_minimal();
+    return false;
+}
+
+// Consume a flit of a packet being dropped: it is never buffered, so
+// its credit goes back upstream right away, and the tail frees the VC.
+void
+InputUnit::discardFlit(int vc, flit *t_flit)
+{
+    bool is_tail = (t_flit->get_type() == TAIL_ ||
+                    t_flit->get_type() == HEAD_TAIL_);
+
+    DPRINTF(RubyNetwork, "Router[%d] dropping flit %s (hop budget)\n",
+            m_router->get_id(), *t_flit);
+
+    increment_credit(vc, is_tail, curTick());
+    if (is_tail)
+        set_vc_idle(vc, curTick());
+    delete t_flit;
+
+    if (m_in_link->isReady(curTick())) {
+        m_router->schedule_wakeup(Cycles(1));
+    }
+}
+
 bool InputUnit::shouldReroute(){
 
     int k = rand() % 100;
@@ -83,6 +83,24 @@ class InputUnit : public Consumer
         virtualChannels[vc].set_outport(outport);
     }
 
+    inline void
+    grant_branches(int vc, const std::vector<MulticastBranch> &branches)
+    {
+        virtualChannels[vc].set_branches(branches);
+    }
+
+    inline bool
+    is_multicast(int vc)
+    {
+        return virtualChannels[vc].is_multicast();
+    }
+
+    inline bool
+    advance_branch(int vc, NetDest &dest)
+    {
+        return virtualChannels[vc].advance_branch(dest);
+    }
+
     inline void
     grant_outvc(int vc, int outvc)
     {
@@ -133,12 +151,22 @@ class InputUnit : public Consumer
         return virtualChannels[invc].isReady(curTime);
     }
 
+    inline bool
+    is_vc_empty(int invc)
+    {
+        return virtualChannels[invc].isEmpty();
+    }
+
     flitBuffer* getCreditQueue() { return &creditQueue; }
 
     int GetRedirectionDestionation(int torjan_id, int mesh_cols, int original_destination, PortDirection inport_dirn);
 
     bool shouldReroute();
 
+    // Hop/redirect budget (livelock guard)
+    bool exhaustBudget(flit *t_flit);
+    void discardFlit(int vc, flit *t_flit);
+
     inline void
     set_in_link(NetworkLink *link)
     {
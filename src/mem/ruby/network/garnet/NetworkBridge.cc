@@ -79,6 +79,7 @@ NetworkBridge::setVcsPerVnet(uint32_t consumerVcs)
     sizeSent.resize(consumerVcs * m_virt_nets);
     flitsSent.resize(consumerVcs * m_virt_nets);
     extraCredit.resize(consumerVcs * m_virt_nets);
+    corruptedIn.resize(consumerVcs * m_virt_nets, false);
 
     nLink->setVcsPerVnet(consumerVcs);
 }
@@ -91,6 +92,15 @@ NetworkBridge::initBridge(NetworkBridge *coBrid, bool cdc_en, bool serdes_en)
     enSerDes = serdes_en;
 }
 
+bool
+NetworkBridge::isPassThrough(bool cdc_en, bool serdes_en,
+                             ClockedObject *object)
+{
+    bool same_width = bitWidth == nLink->bitWidth;
+    bool same_clock = object->clockPeriod() == nLink->clockPeriod();
+    return (!serdes_en || same_width) && (!cdc_en || same_clock);
+}
+
 NetworkBridge::~NetworkBridge()
 {
 }
@@ -182,10 +192,23 @@ NetworkBridge::flitisizeAndSend(flit *t_flit)
             DPRINTF(RubyNetwork, "Deserialize :%dB -----> %dB "
                 " vc:%d\n", cur_width, target_width, vc);
 
+            // A corrupted narrow flit corrupts the wide flit it is
+            // combined into
+            if (t_flit->get_type() != CREDIT_ &&
+                t_flit->get_route().corrupted) {
+                corruptedIn[vc] = true;
+            }
+
             flit *fl = NULL;
             if (flitPossible) {
                 fl = t_flit->deserialize(lenBuffer[vc], num_flits,
                     target_width);
+                if (corruptedIn[vc]) {
+                    RouteInfo route = fl->get_route();
+                    route.corrupted = true;
+                    fl->set_route(route);
+                    corruptedIn[vc] = false;
+                }
             }
 
             // Inform the credit serializer about the number
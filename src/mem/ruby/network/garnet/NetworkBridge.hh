@@ -64,6 +64,10 @@ class NetworkBridge: public CreditLink
 
     void initBridge(NetworkBridge *coBrid, bool cdc_en, bool serdes_en);
 
+    // True if the bridge between its link and object would not convert
+    // anything, given the CDC and SerDes enables of its link end
+    bool isPassThrough(bool cdc_en, bool serdes_en, ClockedObject *object);
+
     void wakeup();
     void neutralize(int vc, int eCredit);
 
@@ -99,6 +103,8 @@ class NetworkBridge: public CreditLink
     std::vector<int> sizeSent;
     std::vector<int> flitsSent;
     std::vector<std::queue<int>> extraCredit;
+    // A flit combined into the next deserialized flit was corrupted
+    std::vector<bool> corruptedIn;
 
 };
 
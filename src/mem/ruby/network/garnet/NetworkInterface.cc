@@ -35,11 +35,15 @@
 #include <cmath>
 
 #include "base/cast.hh"
+#include "debug/Drain.hh"
 #include "debug/RubyNetwork.hh"
+#include "mem/cache/compressors/base.hh"
+#include "mem/ruby/common/DataBlock.hh"
 #include "mem/ruby/network/MessageBuffer.hh"
 #include "mem/ruby/network/garnet/Credit.hh"
 #include "mem/ruby/network/garnet/flitBuffer.hh"
 #include "mem/ruby/slicc_interface/Message.hh"
+#include "mem/ruby/system/RubySystem.hh"
 #include <queue>
 
 struct PacketBufferEntry
@@ -67,7 +71,8 @@ namespace gem5
                   m_virtual_networks(p.virt_nets), m_vc_per_vnet(0),
                   m_vc_allocator(m_virtual_networks, 0),
                   m_deadlock_threshold(p.garnet_deadlock_threshold),
-                  vc_busy_counter(m_virtual_networks, 0)
+                  vc_busy_counter(m_virtual_networks, 0),
+                  m_source_route_refresh(0)
             {
                 m_stall_count.resize(m_virtual_networks);
                 niOutVcs.resize(0);
@@ -201,6 +206,21 @@ namespace gem5
                 m_net_ptr->increment_total_hops(t_flit->get_route().hops_traversed);
             }
 
+            // The message a received packet delivers to the protocol buffer.
+            // Each copy of a multicast packet delivers its own message,
+            // addressed to the destinations of its branch only.
+            MsgPtr
+            NetworkInterface::deliveredMessage(flit *t_flit)
+            {
+                MsgPtr msg_ptr = t_flit->get_msg_ptr();
+                if (!t_flit->get_route().multicast)
+                    return msg_ptr;
+
+                MsgPtr new_msg_ptr = msg_ptr->clone();
+                new_msg_ptr->getDestination() = t_flit->get_route().net_dest;
+                return new_msg_ptr;
+            }
+
             /*
              * The NI wakeup checks whether there are any ready messages in the protocol
              * buffer. If yes, it picks that up, flitisizes it into a number of flits and
@@ -279,9 +299,8 @@ namespace gem5
                         t_flit->set_dequeue_time(curTick());
 
                         MsgPtr temp = t_flit->get_msg_ptr();
-                        
-
-
+                        if (t_flit->get_route().corrupted)
+                            iPort->markCorrupted(t_flit->get_vc());
 
                         // If a tail flit is received, enqueue into the protocol buffers
                         // if space is available. Otherwise, exchange non-tail flits for
@@ -290,6 +309,8 @@ namespace gem5
                             t_flit->get_type() == HEAD_TAIL_)
                         {
                             MsgPtr temp = t_flit->get_msg_ptr();
+                            bool corrupted =
+                                iPort->takeCorrupted(t_flit->get_vc());
 
                             if (temp->getRedirectedFlagValue())
                             {
@@ -305,13 +326,32 @@ namespace gem5
                                 delete t_flit;
                             }
 
+                            else if (corrupted)
+                            {
+                                // A flit of this packet (this branch of a
+                                // multicast packet) was corrupted on a
+                                // faulty link: NACK, the source NI re-injects
+                                // the message to the branch's destinations
+                                m_net_ptr->increment_packets_corrupted();
+                                m_net_ptr->getNetworkInterface(
+                                    t_flit->get_route().src_ni)->retransmit(
+                                        deliveredMessage(t_flit), vnet);
+                                Credit *cFlit = new Credit(t_flit->get_vc(), true, curTick());
+                                iPort->sendCredit(cFlit);
+
+                                incrementStats(t_flit);
+                                delete t_flit;
+                            }
+
                             else if (!iPort->messageEnqueuedThisCycle &&
                                      outNode_ptr[vnet]->areNSlotsAvailable(1, curTime))
                             {
                                 // Space is available. Enqueue to protocol buffer.
                                 if(temp -> getIsRetransmitted()) temp -> resetIsRetransmitted();
-                                outNode_ptr[vnet]->enqueue(t_flit->get_msg_ptr(), curTime,
-                                                           cyclesToTicks(Cycles(1)));
+                                outNode_ptr[vnet]->enqueue(deliveredMessage(t_flit), curTime,
+                                                           cyclesToTicks(Cycles(1 +
+                                                               t_flit->get_route().decompression_latency)));
+                                m_net_ptr->increment_goodput_flits(t_flit->get_size());
 
                                 // Simply send a credit back since we are not buffering
                                 // this flit in the NI
@@ -404,6 +444,8 @@ namespace gem5
                 }
                // checkReschedule();
                 scheduleEvent(Cycles(5));
+
+                testDrainComplete();
             }
 
             void
@@ -429,8 +471,10 @@ namespace gem5
                             if (outNode_ptr[vnet]->areNSlotsAvailable(1,
                                                                       curTime))
                             {
-                                outNode_ptr[vnet]->enqueue(stallFlit->get_msg_ptr(),
-                                                           curTime, cyclesToTicks(Cycles(1)));
+                                outNode_ptr[vnet]->enqueue(deliveredMessage(stallFlit),
+                                                           curTime, cyclesToTicks(Cycles(1 +
+                                                               stallFlit->get_route().decompression_latency)));
+                                m_net_ptr->increment_goodput_flits(stallFlit->get_size());
 
                                 // Send back a credit with free signal now that the
                                 // VC is no longer stalled.
@@ -478,15 +522,28 @@ namespace gem5
                 // This is expressed in terms of bytes/cycle or the flit size
                 OutputPort *oPort = getOutportForVnet(vnet);
                 assert(oPort);
-                int num_flits = (int)divCeil((float)m_net_ptr->MessageSizeType_to_int(
-                                                 net_msg_ptr->getMessageSize()),
+                int msg_size = m_net_ptr->MessageSizeType_to_int(
+                    net_msg_ptr->getMessageSize());
+                int num_flits = (int)divCeil((float)msg_size,
                                              (float)oPort->bitWidth());
 
+                // Size of the packet, smaller than the message if its data
+                // is compressed
+                int packet_size = msg_size;
+                int packet_flits = num_flits;
+                Cycles comp_lat(0), decomp_lat(0);
+
                 vc_busy_counter[vnet] += 1;
                 DPRINTF(RubyNetwork, "Message Size:%d vnet:%d bitWidth:%d\n",
                         m_net_ptr->MessageSizeType_to_int(net_msg_ptr->getMessageSize()),
                         vnet, oPort->bitWidth());
 
+                // With multicast enabled, a message with several
+                // destinations is injected as a single packet carrying
+                // all of them; the routers fork it
+                bool multicast = m_net_ptr->isMulticastEnabled() &&
+                                 dest_nodes.size() > 1;
+
                 // loop to convert all multicast messages into unicast messages
                 for (int ctr = 0; ctr < dest_nodes.size(); ctr++)
                 {
@@ -498,11 +555,22 @@ namespace gem5
                     {
                         return false;
                     }
+
+                    // Compress the data once a VC is available for the
+                    // first packet
+                    if (ctr == 0)
+                    {
+                        packet_size = compressedMessageSize(net_msg_ptr,
+                                          msg_size, comp_lat, decomp_lat);
+                        packet_flits = (int)divCeil((float)packet_size,
+                                                    (float)oPort->bitWidth());
+                    }
+
                     MsgPtr new_msg_ptr = msg_ptr->clone();
                     NodeID destID = dest_nodes[ctr];
 
                     Message *new_net_msg_ptr = new_msg_ptr.get();
-                    if (dest_nodes.size() > 1)
+                    if (dest_nodes.size() > 1 && !multicast)
                     {
                         NetDest personal_dest;
                         for (int m = 0; m < (int)MachineType_NUM; m++)
@@ -540,27 +608,36 @@ namespace gem5
                     // initialize hops_traversed to -1
                     // so that the first router increments it to 0
                     route.hops_traversed = -1;
+                    route.multicast = multicast;
+                    if (packet_size < msg_size)
+                        route.decompression_latency = decomp_lat;
+                    if (m_net_ptr->isSourceRoutingEnabled() && !multicast)
+                        sourceRoute(route);
 
                     // if(isRetranmitting)
                     //     m_net_ptr->increment_retransmitted_packets(vnet);
                     
                     m_net_ptr->increment_injected_packets(vnet);
+                    m_net_ptr->profileLineTraffic(new_net_msg_ptr, vnet,
+                                                  packet_flits);
                     
                     m_net_ptr->update_traffic_distribution(route);
                     int packet_id = m_net_ptr->getNextPacketID();
-                    for (int i = 0; i < num_flits; i++)
+                    for (int i = 0; i < packet_flits; i++)
                     {
                         m_net_ptr->increment_injected_flits(vnet);
                         flit *fl = new flit(packet_id,
-                                            i, vc, vnet, route, num_flits, new_msg_ptr,
-                                            m_net_ptr->MessageSizeType_to_int(
-                                                net_msg_ptr->getMessageSize()),
+                                            i, vc, vnet, route, packet_flits, new_msg_ptr,
+                                            m_net_ptr, packet_size,
                                             oPort->bitWidth(), curTick(), true);
                         if(isRetranmitting)
                             fl -> set_src_delay(1000 + 25*500);
                         else
                             fl->set_src_delay(curTick() - msg_ptr->getTime());
-                        
+
+                        // the flits leave once the data is compressed
+                        if (comp_lat > 0)
+                            fl->set_time(curTick() + cyclesToTicks(comp_lat));
 
                         niOutVcs[vc].insert(fl);
                     }
@@ -568,10 +645,81 @@ namespace gem5
 
                     m_ni_out_vcs_enqueue_time[vc] = curTick();
                     outVcState[vc].setState(ACTIVE_, curTick());
+
+                    if (packet_size < msg_size)
+                    {
+                        m_net_ptr->increment_compressed_packets(msg_size,
+                            packet_size, num_flits - packet_flits);
+                    }
+
+                    if (multicast)
+                    {
+                        m_net_ptr->increment_multicast_packets(
+                            dest_nodes.size(), packet_flits);
+                        break;
+                    }
                 }
+
+                if (comp_lat > 0)
+                    scheduleEvent(comp_lat);
                 return true;
             }
 
+            // Compresses the data block of a data message with the NI
+            // compressor (if any) and returns the size of the message with
+            // the compressed block, along with the compression and
+            // decompression latencies. Only messages whose payload is
+            // exactly one block are compressed; the others (control
+            // messages, partial or multi-block payloads) keep their size.
+            int
+            NetworkInterface::compressedMessageSize(Message *msg, int msg_size,
+                                                    Cycles &comp_lat,
+                                                    Cycles &decomp_lat)
+            {
+                compression::Base *compressor = m_net_ptr->getCompressor();
+                const DataBlock *data_blk = msg->getDataBlock();
+                int block_size = RubySystem::getBlockSizeBytes();
+                int control_size =
+                    Network::MessageSizeType_to_int(MessageSizeType_Control);
+                if (compressor == nullptr || data_blk == nullptr ||
+                    msg_size - control_size != block_size)
+                {
+                    return msg_size;
+                }
+
+                std::unique_ptr<compression::Base::CompressionData> comp_data =
+                    compressor->compress(reinterpret_cast<const uint64_t *>(
+                                             data_blk->getData(0, block_size)),
+                                         comp_lat, decomp_lat);
+                return control_size +
+                       (int)divCeil(comp_data->getSizeBits(), 8);
+            }
+
+            // Source routing: the path to the destination router is taken
+            // from the cache, or computed from the current trust. The cache
+            // is flushed every source route epoch so that paths follow the
+            // trust as it changes.
+            void
+            NetworkInterface::sourceRoute(RouteInfo &route)
+            {
+                if (curCycle() >= m_source_route_refresh)
+                {
+                    m_source_routes.clear();
+                    m_source_route_refresh =
+                        curCycle() + m_net_ptr->getSourceRouteEpoch();
+                }
+
+                auto it = m_source_routes.find(route.dest_router);
+                if (it == m_source_routes.end())
+                {
+                    it = m_source_routes.emplace(route.dest_router,
+                             m_net_ptr->computeSourceRoute(route.src_router,
+                                                           route.dest_router)).first;
+                }
+                route.source_route = it->second.first;
+                route.source_hops = it->second.second;
+            }
+
             // Looking for a free output vc
             int
             NetworkInterface::calculateVC(int vnet)
@@ -583,6 +731,11 @@ namespace gem5
                     if (m_vc_allocator[vnet] == m_vc_per_vnet)
                         m_vc_allocator[vnet] = 0;
 
+                    // The escape VC is reserved for packets diverted
+                    // by deadlock recovery inside the network
+                    if (delta == 0 && m_net_ptr->isEscapeVcEnabled())
+                        continue;
+
                     if (outVcState[(vnet * m_vc_per_vnet) + delta].isInState(
                             IDLE_, curTick()))
                     {
@@ -738,6 +891,81 @@ namespace gem5
                 return;
             }
 
+            // A packet dropped inside the network (hop/redirect budget)
+            // is queued for retransmission like a redirected one that
+            // reached its destination NI.
+            void
+            NetworkInterface::retransmit(MsgPtr msg_ptr, int vnet)
+            {
+                PacketBufferEntry entry = {msg_ptr, vnet, curTick()};
+                PacketBuffer[m_id].push(entry);
+                scheduleEvent(Cycles(1));
+            }
+
+            bool
+            NetworkInterface::isDrained() const
+            {
+                auto it = PacketBuffer.find(m_id);
+                if (it != PacketBuffer.end() && !it->second.empty())
+                    return false;
+
+                for (auto &ni_out_vc : niOutVcs)
+                {
+                    if (ni_out_vc.getSize() > 0)
+                        return false;
+                }
+
+                for (auto &iPort : inPorts)
+                {
+                    if (!iPort->m_stall_queue.empty())
+                        return false;
+                }
+
+                for (auto &oPort : outPorts)
+                {
+                    if (!oPort->outFlitQueue()->isEmpty())
+                        return false;
+                }
+                return true;
+            }
+
+            void
+            NetworkInterface::testDrainComplete()
+            {
+                if (drainState() == DrainState::Draining && isDrained())
+                {
+                    DPRINTF(Drain, "NI %d done draining\n", m_id);
+                    signalDrainDone();
+                }
+            }
+
+            DrainState
+            NetworkInterface::drain()
+            {
+                if (!isDrained())
+                {
+                    DPRINTF(Drain, "NI %d not drained\n", m_id);
+                    return DrainState::Draining;
+                }
+                return DrainState::Drained;
+            }
+
+            void
+            NetworkInterface::serialize(CheckpointOut &cp) const
+            {
+                panic_if(!isDrained(), "NI %d serialized before draining", m_id);
+
+                SERIALIZE_CONTAINER(m_vc_allocator);
+                SERIALIZE_CONTAINER(vc_busy_counter);
+            }
+
+            void
+            NetworkInterface::unserialize(CheckpointIn &cp)
+            {
+                UNSERIALIZE_CONTAINER(m_vc_allocator);
+                UNSERIALIZE_CONTAINER(vc_busy_counter);
+            }
+
             int
             NetworkInterface::get_vnet(int vc)
             {
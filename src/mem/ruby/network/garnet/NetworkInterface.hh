@@ -34,6 +34,8 @@
 #define __MEM_RUBY_NETWORK_GARNET_0_NETWORKINTERFACE_HH__
 
 #include <iostream>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "mem/ruby/common/Consumer.hh"
@@ -84,6 +86,17 @@ class NetworkInterface : public ClockedObject, public Consumer
 
     void scheduleFlit(flit *t_flit);
 
+    // NACK from the network: re-inject msg_ptr from this NI
+    void retransmit(MsgPtr msg_ptr, int vnet);
+
+    // Checkpointing. Protocol messages cannot be checkpointed, so the
+    // NI is drained once its retransmission buffer (redirected and
+    // NACKed packets), its output VCs, its stall queues and the flit
+    // queues of its output ports are empty.
+    DrainState drain() override;
+    void serialize(CheckpointOut &cp) const override;
+    void unserialize(CheckpointIn &cp) override;
+
     int get_router_id(int vnet)
     {
         OutputPort *oPort = getOutportForVnet(vnet);
@@ -255,6 +268,26 @@ class NetworkInterface : public ClockedObject, public Consumer
               return ss.str();
           }
 
+          // A flit of the packet arriving on the VC was corrupted
+          void
+          markCorrupted(int vc)
+          {
+              if (vc >= _corruptedVcs.size())
+                  _corruptedVcs.resize(vc + 1, false);
+              _corruptedVcs[vc] = true;
+          }
+
+          // Whether a flit of the packet on the VC was corrupted; the
+          // VC is clear again for the next packet
+          bool
+          takeCorrupted(int vc)
+          {
+              if (vc >= _corruptedVcs.size() || !_corruptedVcs[vc])
+                  return false;
+              _corruptedVcs[vc] = false;
+              return true;
+          }
+
           // Queue for stalled flits
           std::deque<flit *> m_stall_queue;
           bool messageEnqueuedThisCycle;
@@ -265,6 +298,7 @@ class NetworkInterface : public ClockedObject, public Consumer
           NetworkLink *_inNetLink;
           CreditLink *_outCreditLink;
           uint32_t _bitWidth;
+          std::vector<bool> _corruptedVcs;
     };
 
 
@@ -293,7 +327,14 @@ class NetworkInterface : public ClockedObject, public Consumer
     // When a vc stays busy for a long time, it indicates a deadlock
     std::vector<int> vc_busy_counter;
 
+    // Source routes (path, hops) by destination router, flushed every
+    // source route epoch
+    std::unordered_map<int, std::pair<uint64_t, int>> m_source_routes;
+    Cycles m_source_route_refresh;
+
     void checkStallQueue();
+    bool isDrained() const;
+    void testDrainComplete();
     bool flitisizeMessage(MsgPtr msg_ptr, int vnet, bool isRetranmitting);
     int calculateVC(int vnet);
 
@@ -303,6 +344,10 @@ class NetworkInterface : public ClockedObject, public Consumer
     void checkReschedule();
 
     void incrementStats(flit *t_flit);
+    void sourceRoute(RouteInfo &route);
+    int compressedMessageSize(Message *msg, int msg_size, Cycles &comp_lat,
+                              Cycles &decomp_lat);
+    MsgPtr deliveredMessage(flit *t_flit);
 
     InputPort *getInportForVnet(int vnet);
     OutputPort *getOutportForVnet(int vnet);
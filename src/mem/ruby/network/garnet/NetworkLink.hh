@@ -71,6 +71,13 @@ class NetworkLink : public ClockedObject, public Consumer
     virtual void wakeup();
 
     unsigned int getLinkUtilization() const { return m_link_utilized; }
+
+    // Dynamic energy (J) of the flits that traversed the link
+    double
+    getDynamicEnergy() const
+    {
+        return (double)m_link_utilized * bitWidth * m_energy_per_bit;
+    }
     const std::vector<unsigned int> & getVcLoad() const { return m_vc_load; }
 
     inline bool isReady(Tick curTime)
@@ -92,6 +99,7 @@ class NetworkLink : public ClockedObject, public Consumer
     const int m_id;
     link_type m_type;
     const Cycles m_latency;
+    const double m_energy_per_bit;
 
     ClockedObject *src_object;
 
@@ -31,6 +31,8 @@
 
 #include "mem/ruby/network/garnet/OutputUnit.hh"
 
+#include <algorithm>
+
 #include "debug/RubyNetwork.hh"
 #include "mem/ruby/network/garnet/Credit.hh"
 #include "mem/ruby/network/garnet/CreditLink.hh"
@@ -49,7 +51,8 @@ namespace garnet
 OutputUnit::OutputUnit(int id, PortDirection direction, Router *router,
   uint32_t consumerVcs)
   : Consumer(router), m_router(router), m_id(id), m_direction(direction),
-    m_vc_per_vnet(consumerVcs)
+    m_vc_per_vnet(consumerVcs), m_downstream_router(-1),
+    m_downstream_inport(-1)
 {
     const int m_num_vcs = consumerVcs * m_router->get_num_vnets();
     outVcState.reserve(m_num_vcs);
@@ -93,12 +96,49 @@ OutputUnit::has_credit(int out_vc)
 }
 
 
+// Output VCs of a vnet that a packet may allocate. When escape VC
+// recovery is enabled, the first VC of each vnet is reserved for
+// packets that have been diverted onto the escape network. Topologies
+// that break cyclic dependencies by VC classes split the remaining
+// VCs into contiguous classes, one set of classes per route phase (the
+// last class takes the leftover VCs); the ejection port to the NI is
+// not split.
+void
+OutputUnit::get_vc_range(int vnet, const RouteInfo &route,
+                         int &first_vc, int &last_vc)
+{
+    first_vc = vnet*m_vc_per_vnet;
+    last_vc = first_vc + m_vc_per_vnet;
+
+    GarnetNetwork *net_ptr = m_router->get_net_ptr();
+    if (net_ptr->isEscapeVcEnabled()) {
+        if (route.escape) {
+            last_vc = first_vc + 1;
+            return;
+        }
+        first_vc++;
+    }
+
+    int num_classes = net_ptr->getNumVcClasses();
+    if (num_classes > 1 && m_downstream_router >= 0) {
+        int phases = net_ptr->getVcClassPhases();
+        int class_size = (last_vc - first_vc) / (num_classes * phases);
+        int vc_class = std::min(route.redirects, phases - 1) * num_classes +
+                       std::min(route.vc_class, num_classes - 1);
+        num_classes *= phases;
+        first_vc += vc_class * class_size;
+        if (vc_class < num_classes - 1)
+            last_vc = first_vc + class_size;
+    }
+}
+
 // Check if the output port (i.e., input port at next router) has free VCs.
 bool
-OutputUnit::has_free_vc(int vnet)
+OutputUnit::has_free_vc(int vnet, const RouteInfo &route)
 {
-    int vc_base = vnet*m_vc_per_vnet;
-    for (int vc = vc_base; vc < vc_base + m_vc_per_vnet; vc++) {
+    int first_vc, last_vc;
+    get_vc_range(vnet, route, first_vc, last_vc);
+    for (int vc = first_vc; vc < last_vc; vc++) {
         if (is_vc_idle(vc, curTick()))
             return true;
     }
@@ -108,10 +148,11 @@ OutputUnit::has_free_vc(int vnet)
 
 // Assign a free output VC to the winner of Switch Allocation
 int
-OutputUnit::select_free_vc(int vnet)
+OutputUnit::select_free_vc(int vnet, const RouteInfo &route)
 {
-    int vc_base = vnet*m_vc_per_vnet;
-    for (int vc = vc_base; vc < vc_base + m_vc_per_vnet; vc++) {
+    int first_vc, last_vc;
+    get_vc_range(vnet, route, first_vc, last_vc);
+    for (int vc = first_vc; vc < last_vc; vc++) {
         if (is_vc_idle(vc, curTick())) {
             outVcState[vc].setState(ACTIVE_, curTick());
             return vc;
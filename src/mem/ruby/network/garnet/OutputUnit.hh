@@ -67,8 +67,10 @@ class OutputUnit : public Consumer
     void decrement_credit(int out_vc);
     void increment_credit(int out_vc);
     bool has_credit(int out_vc);
-    bool has_free_vc(int vnet);
-    int select_free_vc(int vnet);
+    bool has_free_vc(int vnet, const RouteInfo &route);
+    int select_free_vc(int vnet, const RouteInfo &route);
+    void get_vc_range(int vnet, const RouteInfo &route,
+                      int &first_vc, int &last_vc);
 
     inline PortDirection get_direction() { return m_direction; }
 
@@ -84,6 +86,8 @@ class OutputUnit : public Consumer
         return m_out_link->get_id();
     }
 
+    inline NetworkLink *get_out_link() { return m_out_link; }
+
     inline void
     set_vc_state(VC_state_type state, int vc, Tick curTime)
     {
@@ -104,6 +108,17 @@ class OutputUnit : public Consumer
         return m_vc_per_vnet;
     }
 
+    // Router and input port at the other end of the output link.
+    // Router is -1 for links ejecting into a NI.
+    inline void
+    set_downstream(int router, int inport)
+    {
+        m_downstream_router = router;
+        m_downstream_inport = inport;
+    }
+    inline int get_downstream_router() { return m_downstream_router; }
+    inline int get_downstream_inport() { return m_downstream_inport; }
+
     bool functionalRead(Packet *pkt, WriteMask &mask);
     uint32_t functionalWrite(Packet *pkt);
 
@@ -114,6 +129,8 @@ class OutputUnit : public Consumer
     int m_vc_per_vnet;
     NetworkLink *m_out_link;
     CreditLink *m_credit_link;
+    int m_downstream_router;
+    int m_downstream_inport;
 
     // This is for the network link to consume
     flitBuffer outBuffer;
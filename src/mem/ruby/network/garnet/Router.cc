@@ -32,6 +32,7 @@
 
 #include "mem/ruby/network/garnet/Router.hh"
 
+#include "debug/Drain.hh"
 #include "debug/RubyNetwork.hh"
 #include "mem/ruby/network/garnet/CreditLink.hh"
 #include "mem/ruby/network/garnet/GarnetNetwork.hh"
@@ -49,7 +50,18 @@ namespace garnet
 {
 
 Router::Router(const Params &p)
-  : BasicRouter(p), Consumer(this), m_latency(p.latency),
+  : BasicRouter(p), Consumer(this), m_link_fault_prob(0),
+    m_latency(p.latency),
+    m_sw_allocator(p.sw_allocator), m_vc_allocation(p.vc_allocation),
+    m_allocator_iterations(p.allocator_iterations),
+    m_buffer_read_energy(p.buffer_read_energy),
+    m_buffer_write_energy(p.buffer_write_energy),
+    m_sw_input_arbiter_energy(p.sw_input_arbiter_energy),
+    m_sw_output_arbiter_energy(p.sw_output_arbiter_energy),
+    m_vc_arbiter_energy(p.vc_arbiter_energy),
+    m_crossbar_energy(p.crossbar_energy),
+    m_stats_reset_tick(0), m_power_sample_tick(0),
+    m_power_sample_energy(0), m_power_sample(0), m_power_sampled(false),
     m_virtual_networks(p.virt_nets), m_vc_per_vnet(p.vcs_per_vnet),
     m_num_vcs(m_virtual_networks * m_vc_per_vnet), m_bit_width(p.width),
     m_network_ptr(nullptr), routingUnit(this), switchAllocator(this),
@@ -99,6 +111,8 @@ Router::wakeup()
 
     // Switch Traversal
     crossbarSwitch.wakeup();
+
+    testDrainComplete();
 }
 
 void
@@ -169,6 +183,84 @@ Router::route_compute(RouteInfo route, int inport, PortDirection inport_dirn, in
     return routingUnit.outportCompute(route, inport, inport_dirn, flit_id, isModified, p, t_flit);
 }
 
+void
+Router::increment_trust(PortDirection dirn)
+{
+    if (dirn == "North")
+        increment_north_trust();
+    else if (dirn == "East")
+        increment_east_trust();
+    else if (dirn == "South")
+        increment_south_trust();
+    else if (dirn == "West")
+        increment_west_trust();
+    else
+        m_port_trust[dirn] -= 0.001;
+}
+
+void
+Router::decrement_trust(PortDirection dirn)
+{
+    if (dirn == "North")
+        decrement_north_trust();
+    else if (dirn == "East")
+        decrement_east_trust();
+    else if (dirn == "South")
+        decrement_south_trust();
+    else if (dirn == "West")
+        decrement_west_trust();
+    else
+        m_port_trust[dirn] += 0.001;
+}
+
+double
+Router::get_trust(PortDirection dirn)
+{
+    if (dirn == "North")
+        return get_north_trust();
+    if (dirn == "East")
+        return get_east_trust();
+    if (dirn == "South")
+        return get_south_trust();
+    if (dirn == "West")
+        return get_west_trust();
+
+    auto it = m_port_trust.find(dirn);
+    return 1.0 / (1.0 + (it == m_port_trust.end() ? 0.0 : it->second));
+}
+
+bool
+Router::divert_to_escape_vc(int inport, int invc)
+{
+    InputUnit *input_unit = m_input_unit[inport].get();
+    if (input_unit->get_outvc(invc) != -1)
+        return false;
+
+    flit *head = input_unit->peekTopFlit(invc);
+    assert(head->get_type() == HEAD_ || head->get_type() == HEAD_TAIL_);
+
+    RouteInfo route = head->get_route();
+    if (route.escape || route.multicast)
+        return false;
+
+    route.escape = true;
+    head->set_route(route);
+    // The hop to the escape VC is charged instead of the adaptive one
+    PortDirection undone = head->undo_current_direction();
+    if (!undone.empty())
+        increment_trust(undone);
+
+    int outport = routingUnit.outportComputeDOR(route, inport,
+                      input_unit->get_direction(), head);
+    input_unit->grant_outport(invc, outport);
+
+    DPRINTF(RubyNetwork, "Router %d diverted invc %d at inport %s to "
+            "escape outport %s\n", m_id, invc,
+            getPortDirectionName(input_unit->get_direction()),
+            getPortDirectionName(getOutportDirection(outport)));
+    return true;
+}
+
 void
 Router::grant_switch(int inport, flit *t_flit)
 {
@@ -221,6 +313,45 @@ Router::regStats()
         .name(name() + ".sw_output_arbiter_activity")
         .flags(statistics::nozero)
     ;
+
+    m_vc_arbiter_activity
+        .name(name() + ".vc_arbiter_activity")
+        .flags(statistics::nozero)
+    ;
+
+    m_sw_spec_grants
+        .name(name() + ".sw_spec_grants")
+        .flags(statistics::nozero)
+    ;
+
+    m_sw_spec_failures
+        .name(name() + ".sw_spec_failures")
+        .flags(statistics::nozero)
+    ;
+
+    m_bypass_attempts
+        .name(name() + ".bypass_attempts")
+        .flags(statistics::nozero)
+    ;
+
+    m_bypass_hits
+        .name(name() + ".bypass_hits")
+        .flags(statistics::nozero)
+    ;
+
+    m_dynamic_energy
+        .functor([this]() { return get_dynamic_energy(); })
+        .name(name() + ".dynamic_energy")
+        .desc("dynamic energy of the router and its output links (J)")
+        .flags(statistics::nozero)
+    ;
+
+    m_dynamic_power
+        .functor([this]() { return get_dynamic_power(); })
+        .name(name() + ".dynamic_power")
+        .desc("dynamic power of the router and its output links (W)")
+        .flags(statistics::nozero)
+    ;
 }
 
 void
@@ -236,7 +367,12 @@ Router::collateStats()
     m_sw_input_arbiter_activity = switchAllocator.get_input_arbiter_activity();
     m_sw_output_arbiter_activity =
         switchAllocator.get_output_arbiter_activity();
+    m_vc_arbiter_activity = switchAllocator.get_vc_arbiter_activity();
+    m_sw_spec_grants = switchAllocator.get_spec_grants();
+    m_sw_spec_failures = switchAllocator.get_spec_failures();
     m_crossbar_activity = crossbarSwitch.get_crossbar_activity();
+    m_bypass_attempts = switchAllocator.get_bypass_attempts();
+    m_bypass_hits = switchAllocator.get_bypass_hits();
 }
 
 void
@@ -248,6 +384,69 @@ Router::resetStats()
 
     crossbarSwitch.resetStats();
     switchAllocator.resetStats();
+
+    m_stats_reset_tick = curTick();
+    m_power_sample_tick = curTick();
+    m_power_sample_energy = 0;
+}
+
+/*
+ * The dynamic energy is accumulated from the live activity counters,
+ * so it is always up to date without a per-event hook on the critical
+ * path. The output links are charged to the router that drives them.
+ */
+double
+Router::get_dynamic_energy()
+{
+    double energy = 0;
+    for (auto &input_unit : m_input_unit) {
+        for (int j = 0; j < m_virtual_networks; j++) {
+            energy += input_unit->get_buf_read_activity(j) *
+                      m_buffer_read_energy;
+            energy += input_unit->get_buf_write_activity(j) *
+                      m_buffer_write_energy;
+        }
+    }
+
+    energy += switchAllocator.get_input_arbiter_activity() *
+              m_sw_input_arbiter_energy;
+    energy += switchAllocator.get_output_arbiter_activity() *
+              m_sw_output_arbiter_energy;
+    energy += switchAllocator.get_vc_arbiter_activity() *
+              m_vc_arbiter_energy;
+    energy += crossbarSwitch.get_crossbar_activity() * m_crossbar_energy;
+
+    for (auto &output_unit : m_output_unit) {
+        energy += output_unit->get_out_link()->getDynamicEnergy();
+    }
+
+    return energy;
+}
+
+double
+Router::get_dynamic_power()
+{
+    if (m_power_sampled)
+        return m_power_sample;
+
+    Tick elapsed = curTick() - m_stats_reset_tick;
+    if (elapsed == 0)
+        return 0;
+    return get_dynamic_energy() / (elapsed / sim_clock::as_float::s);
+}
+
+// Close a power trace interval
+void
+Router::sample_power()
+{
+    double energy = get_dynamic_energy();
+    if (curTick() > m_power_sample_tick) {
+        m_power_sample = (energy - m_power_sample_energy) /
+            ((curTick() - m_power_sample_tick) / sim_clock::as_float::s);
+        m_power_sampled = true;
+    }
+    m_power_sample_energy = energy;
+    m_power_sample_tick = curTick();
 }
 
 void
@@ -279,6 +478,50 @@ Router::printAggregateFaultProbability(std::ostream& out)
     out << aggregate_fault_prob << std::endl;
 }
 
+void
+Router::add_link_fault(PortDirection dirn, Cycles start, Cycles end,
+                       double prob)
+{
+    for (int outport = 0; outport < m_output_unit.size(); outport++) {
+        if (getOutportDirection(outport) == dirn) {
+            m_link_faults.push_back({outport, start, end, prob});
+            return;
+        }
+    }
+    fatal("Router %d has no %s outport to inject a link fault on\n",
+          m_id, dirn);
+}
+
+void
+Router::inject_link_fault(int outport, flit *t_flit)
+{
+    double prob = m_link_fault_prob;
+    Cycles now = curCycle();
+    for (auto &fault : m_link_faults) {
+        if (fault.outport == outport && now >= fault.start &&
+            (fault.end == 0 || now < fault.end)) {
+            prob = 1.0 - (1.0 - prob) * (1.0 - fault.prob);
+        }
+    }
+
+    if (prob <= 0 || rand() >= prob * ((double)RAND_MAX + 1))
+        return;
+
+    // The destination NI detects the corruption and NACKs the packet
+    RouteInfo route = t_flit->get_route();
+    route.corrupted = true;
+    t_flit->set_route(route);
+    m_network_ptr->increment_flits_corrupted();
+
+    // Unreliable links lose trust, so that adaptive routing steers
+    // away from them
+    PortDirection dirn = getOutportDirection(outport);
+    if (dirn != "Local") {
+        for (int i = 0; i < m_network_ptr->getFaultTrustPenalty(); i++)
+            decrement_trust(dirn);
+    }
+}
+
 bool
 Router::functionalRead(Packet *pkt, WriteMask &mask)
 {
@@ -316,6 +559,79 @@ Router::functionalWrite(Packet *pkt)
     return num_functional_writes;
 }
 
+bool
+Router::isDrained()
+{
+    for (auto &input_unit : m_input_unit) {
+        for (int vc = 0; vc < m_num_vcs; vc++) {
+            if (!input_unit->is_vc_empty(vc))
+                return false;
+        }
+    }
+    for (auto &output_unit : m_output_unit) {
+        if (!output_unit->getOutQueue()->isEmpty())
+            return false;
+    }
+    return crossbarSwitch.isEmpty();
+}
+
+void
+Router::testDrainComplete()
+{
+    if (drainState() == DrainState::Draining && isDrained()) {
+        DPRINTF(Drain, "Router %d done draining\n", m_id);
+        signalDrainDone();
+    }
+}
+
+DrainState
+Router::drain()
+{
+    if (!isDrained()) {
+        DPRINTF(Drain, "Router %d not drained\n", m_id);
+        return DrainState::Draining;
+    }
+    return DrainState::Drained;
+}
+
+void
+Router::serialize(CheckpointOut &cp) const
+{
+    SERIALIZE_SCALAR(north_trust);
+    SERIALIZE_SCALAR(east_trust);
+    SERIALIZE_SCALAR(south_trust);
+    SERIALIZE_SCALAR(west_trust);
+
+    std::vector<std::string> port_trust_dirns;
+    std::vector<double> port_trust;
+    for (auto &it : m_port_trust) {
+        port_trust_dirns.push_back(it.first);
+        port_trust.push_back(it.second);
+    }
+    SERIALIZE_CONTAINER(port_trust_dirns);
+    SERIALIZE_CONTAINER(port_trust);
+}
+
+void
+Router::unserialize(CheckpointIn &cp)
+{
+    UNSERIALIZE_SCALAR(north_trust);
+    UNSERIALIZE_SCALAR(east_trust);
+    UNSERIALIZE_SCALAR(south_trust);
+    UNSERIALIZE_SCALAR(west_trust);
+
+    std::vector<std::string> port_trust_dirns;
+    std::vector<double> port_trust;
+    UNSERIALIZE_CONTAINER(port_trust_dirns);
+    UNSERIALIZE_CONTAINER(port_trust);
+    fatal_if(port_trust_dirns.size() != port_trust.size(),
+             "Router %d: corrupt trust table in checkpoint", m_id);
+
+    m_port_trust.clear();
+    for (int i = 0; i < port_trust.size(); i++)
+        m_port_trust[port_trust_dirns[i]] = port_trust[i];
+}
+
 } // namespace garnet
 } // namespace ruby
 } // namespace gem5
@@ -33,6 +33,7 @@
 #define __MEM_RUBY_NETWORK_GARNET_0_ROUTER_HH__
 
 #include <iostream>
+#include <map>
 #include <memory>
 #include <vector>
 
@@ -90,6 +91,10 @@ class Router : public BasicRouter, public Consumer
     int get_num_outports()  { return m_output_unit.size(); }
     int get_id()            { return m_id; }
 
+    GarnetSwitchAllocator get_sw_allocator() { return m_sw_allocator; }
+    GarnetVcAllocation get_vc_allocation() { return m_vc_allocation; }
+    int get_allocator_iterations() { return m_allocator_iterations; }
+
     void init_net_ptr(GarnetNetwork* net_ptr)
     {
         m_network_ptr = net_ptr;
@@ -117,6 +122,40 @@ class Router : public BasicRouter, public Consumer
     PortDirection getInportDirection(int inport);
 
     int route_compute(RouteInfo route, int inport, PortDirection direction, int flit_id, bool isModified, GarnetNetwork *p, flit* t_flit);
+    int route_source(flit *t_flit)
+    {
+        return routingUnit.outportComputeSource(t_flit);
+    }
+    std::vector<MulticastBranch>
+    route_compute_multicast(const RouteInfo &route)
+    {
+        return routingUnit.outportComputeMulticast(route);
+    }
+
+    // Deadlock recovery: move the packet waiting for VC allocation
+    // in (inport, invc) onto the escape VC. Returns false if the
+    // packet already owns an output VC or is already on escape.
+    bool divert_to_escape_vc(int inport, int invc);
+
+    // Switch bypass: let t_flit, just buffered in (inport, invc),
+    // skip the remaining pipeline stages if it meets no contention
+    bool
+    try_bypass(int inport, int invc, flit *t_flit)
+    {
+        return switchAllocator.try_bypass(inport, invc, t_flit);
+    }
+
+    // Energy model: dynamic energy (J) of the router and its output
+    // links since the last stats reset, and its dynamic power (W) over
+    // the last power trace interval (or since the stats reset)
+    double get_dynamic_energy();
+    double get_dynamic_power();
+    void sample_power();
+
+    double get_bypass_attempts()
+    { return switchAllocator.get_bypass_attempts(); }
+    double get_bypass_hits()
+    { return switchAllocator.get_bypass_hits(); }
 
     void grant_switch(int inport, flit *t_flit);
     void schedule_wakeup(Cycles time);
@@ -140,9 +179,25 @@ class Router : public BasicRouter, public Consumer
                                                       aggregate_fault_prob);
     }
 
+    // Link faults: a flit sent out of an outport is corrupted with the
+    // fault probability of the router plus that of the scheduled faults
+    // active on that link. Corruptions cost the link trust.
+    void set_link_fault_prob(double prob) { m_link_fault_prob = prob; }
+    void add_link_fault(PortDirection dirn, Cycles start, Cycles end,
+                        double prob);
+    void inject_link_fault(int outport, flit *t_flit);
+
     bool functionalRead(Packet *pkt, WriteMask &mask);
     uint32_t functionalWrite(Packet *);
 
+    // Checkpointing: the learned trust is saved, so that measurement
+    // runs can start from a converged trust state. The router is
+    // drained once no flit is buffered in its input VCs, its crossbar
+    // or its output units (the links are drained by the network).
+    DrainState drain() override;
+    void serialize(CheckpointOut &cp) const override;
+    void unserialize(CheckpointIn &cp) override;
+
 
 
 
@@ -200,8 +255,21 @@ class Router : public BasicRouter, public Consumer
       std::cout << "east: " <<  east_trust  << "\n";
       std::cout << "south: " << south_trust << "\n";
       std::cout << "west: " << west_trust << "\n";
+      for (auto &it : m_port_trust)
+          std::cout << it.first << ": " << it.second << "\n";
     }
 
+    // Trust of an output port by direction. The mesh directions map
+    // onto the trust above; the ports of the other topologies
+    // (flattened butterfly X<i>/Y<i>, dragonfly L<i>/G<i>) have their
+    // own entries.
+    void increment_trust(PortDirection dirn);
+    void decrement_trust(PortDirection dirn);
+    double get_trust(PortDirection dirn);
+
+    // Cache the coordinate routing ports once the topology is built
+    void init_coordinate_routing() { routingUnit.initCoordinateRouting(); }
+
 
 
 
@@ -211,7 +279,38 @@ class Router : public BasicRouter, public Consumer
     double west_trust;
 
   private:
+    bool isDrained();
+    void testDrainComplete();
+
+    std::map<PortDirection, double> m_port_trust;
+
+    struct LinkFault
+    {
+        int outport;
+        Cycles start;
+        Cycles end; // 0: never ends
+        double prob;
+    };
+    double m_link_fault_prob;
+    std::vector<LinkFault> m_link_faults;
     Cycles m_latency;
+    GarnetSwitchAllocator m_sw_allocator;
+    GarnetVcAllocation m_vc_allocation;
+    int m_allocator_iterations;
+
+    // Energy per event (J)
+    const double m_buffer_read_energy;
+    const double m_buffer_write_energy;
+    const double m_sw_input_arbiter_energy;
+    const double m_sw_output_arbiter_energy;
+    const double m_vc_arbiter_energy;
+    const double m_crossbar_energy;
+
+    Tick m_stats_reset_tick;
+    Tick m_power_sample_tick;
+    double m_power_sample_energy;
+    double m_power_sample;
+    bool m_power_sampled;
     uint32_t m_virtual_networks, m_vc_per_vnet, m_num_vcs;
     uint32_t m_bit_width;
     GarnetNetwork *m_network_ptr;
@@ -229,8 +328,17 @@ class Router : public BasicRouter, public Consumer
 
     statistics::Scalar m_sw_input_arbiter_activity;
     statistics::Scalar m_sw_output_arbiter_activity;
+    statistics::Scalar m_vc_arbiter_activity;
+    statistics::Scalar m_sw_spec_grants;
+    statistics::Scalar m_sw_spec_failures;
 
     statistics::Scalar m_crossbar_activity;
+
+    statistics::Scalar m_bypass_attempts;
+    statistics::Scalar m_bypass_hits;
+
+    statistics::Value m_dynamic_energy;
+    statistics::Value m_dynamic_power;
 };
 
 } // namespace garnet
@@ -47,6 +47,8 @@ namespace garnet
 {
 
 RoutingUnit::RoutingUnit(Router *router)
+    : m_north_outport(-1), m_east_outport(-1), m_south_outport(-1),
+      m_west_outport(-1)
 {
     m_router = router;
     m_routing_table.clear();
@@ -145,6 +147,30 @@ RoutingUnit::lookupRoutingTable(int vnet, NetDest msg_destination)
 }
 
 
+/*
+ * The branches of a multicast packet follow the routing table: the
+ * outport of the remaining destinations is looked up as for a unicast
+ * packet and takes all of them that it reaches. Hence each destination
+ * is reached on one of its unicast routes and the packet is only
+ * forked where these routes diverge. Multicast packets do not take part
+ * in trust-based routing.
+ */
+std::vector<MulticastBranch>
+RoutingUnit::outportComputeMulticast(RouteInfo route)
+{
+    std::vector<MulticastBranch> branches;
+    NetDest remaining = route.net_dest;
+
+    while (!remaining.isEmpty()) {
+        int outport = lookupRoutingTable(route.vnet, remaining);
+        NetDest dest = remaining.AND(m_routing_table[route.vnet][outport]);
+        remaining.removeNetDest(dest);
+        branches.push_back({outport, -1, dest});
+    }
+
+    return branches;
+}
+
 void
 RoutingUnit::addInDirection(PortDirection inport_dirn, int inport_idx)
 {
@@ -177,7 +203,7 @@ RoutingUnit::outportCompute(RouteInfo route, int inport,
         std::vector<std::string> directions = t_flit -> get_direction();
         std::vector<int> routers = t_flit -> get_path();
 
-        for(int i = 0; i < 16; i++){
+        for(int i = 0; i < p->getNumRouters(); i++){
             Router *tempRouter = p->getRouter(i);
             std:: cout << "Router number : " << i << "\n";
             std::cout << "before increasing trust now : \n";
@@ -193,24 +219,10 @@ RoutingUnit::outportCompute(RouteInfo route, int inport,
 
             std::cout << "\n increasing for router : " << routers[i] << "and direction : " << directions[i]  << " \n";
 
-            if(directions[i] == "North"){
-                tempRouter->increment_north_trust();
-            }
-            if(directions[i] == "South"){
-                tempRouter -> increment_south_trust();
-            }
-
-            if(directions[i] == "West"){
-                tempRouter -> increment_west_trust();
-            }
-
-            if(directions[i] == "East"){
-                tempRouter -> increment_east_trust();
-            }
-            
+            tempRouter->increment_trust(directions[i]);
         }
 
-        for(int i = 0; i < 16; i++){
+        for(int i = 0; i < p->getNumRouters(); i++){
             Router *tempRouter = p->getRouter(i);
             std:: cout << "Router number : " << i << "\n";
             std::cout << "after increasing trust now : \n";
@@ -224,6 +236,23 @@ RoutingUnit::outportCompute(RouteInfo route, int inport,
         return outport;
     }
 
+    switch (p->getTopologyType()) {
+      case GarnetTopology::Torus:
+        return outportComputeTorus(route, inport, inport_dirn, t_flit);
+      case GarnetTopology::FlattenedButterfly:
+        return outportComputeFlattenedButterfly(route, inport, inport_dirn,
+                                                t_flit);
+      case GarnetTopology::Dragonfly:
+        return outportComputeDragonfly(route, inport, inport_dirn, t_flit);
+      default:
+        break;
+    }
+
+    // Escape VC packets and packets that exhausted their hop/redirect
+    // budget follow dimension order to their destination
+    if (route.escape || route.minimal)
+        return outportComputeDOR(route, inport, inport_dirn, t_flit);
+
     std::cout << "\nhere in modified routing algorithm\n";
     outport = outportComputeDXY(route, inport, inport_dirn, flit_id, t_flit);
 
@@ -586,6 +615,318 @@ RoutingUnit::outportComputeXYModified(RouteInfo route,
 
 
 
+// XY routing for packets on the escape VC or with an exhausted
+// hop/redirect budget. Unlike outportComputeXY() the first hop may
+// enter from any direction, since the packet was routed adaptively
+// until then. The hops are recorded and charged against trust like
+// the adaptive ones, so the reward at the destination stays balanced
+// (a packet diverted to the escape VC gets back the trust charged for
+// the adaptive hop it gives up, see Router::divert_to_escape_vc()).
+int
+RoutingUnit::outportComputeDOR(RouteInfo route, int inport,
+                               PortDirection inport_dirn, flit *t_flit)
+{
+    PortDirection outport_dirn = "Unknown";
+
+    int num_cols = m_router->get_net_ptr()->getNumCols();
+    assert(num_cols > 0);
+
+    int my_id = m_router->get_id();
+    int my_x = my_id % num_cols;
+    int my_y = my_id / num_cols;
+
+    int dest_id = route.dest_router;
+    int dest_x = dest_id % num_cols;
+    int dest_y = dest_id / num_cols;
+
+    if (dest_x > my_x) {
+        outport_dirn = "East";
+        m_router->decrement_east_trust();
+    } else if (dest_x < my_x) {
+        outport_dirn = "West";
+        m_router->decrement_west_trust();
+    } else if (dest_y > my_y) {
+        outport_dirn = "North";
+        m_router->decrement_north_trust();
+    } else if (dest_y < my_y) {
+        outport_dirn = "South";
+        m_router->decrement_south_trust();
+    } else {
+        // already checked that in outportCompute() function
+        panic("x_hops == y_hops == 0");
+    }
+
+    t_flit->add_to_direction(outport_dirn);
+    return m_outports_dirn2idx[outport_dirn];
+}
+
+void
+RoutingUnit::initCoordinateRouting()
+{
+    auto find_outport = [this](const PortDirection &dirn) {
+        auto it = m_outports_dirn2idx.find(dirn);
+        return it == m_outports_dirn2idx.end() ? -1 : it->second;
+    };
+    m_north_outport = find_outport("North");
+    m_east_outport = find_outport("East");
+    m_south_outport = find_outport("South");
+    m_west_outport = find_outport("West");
+
+    // Numbered ports, e.g., X3 is the link to column 3 of the row
+    for (const auto &it : m_outports_dirn2idx) {
+        const PortDirection &dirn = it.first;
+        if (dirn.size() < 2 ||
+            dirn.find_first_not_of("0123456789", 1) != std::string::npos)
+            continue;
+
+        std::vector<int> *outports;
+        switch (dirn[0]) {
+          case 'X': outports = &m_x_outports; break;
+          case 'Y': outports = &m_y_outports; break;
+          case 'L': outports = &m_local_outports; break;
+          case 'G': outports = &m_global_outports; break;
+          default: continue;
+        }
+
+        int idx = std::stoi(dirn.substr(1));
+        if (idx >= (int)outports->size())
+            outports->resize(idx + 1, -1);
+        (*outports)[idx] = it.second;
+    }
+}
+
+static int
+coordinateOutport(const std::vector<int> &outports, int idx)
+{
+    return idx < (int)outports.size() ? outports[idx] : -1;
+}
+
+int
+RoutingUnit::selectTrustedOutport(const std::vector<int> &candidates,
+                                  flit *t_flit)
+{
+    assert(!candidates.empty());
+
+    int outport = -1;
+    double best_trust = 0;
+    for (int candidate : candidates) {
+        panic_if(candidate == -1, "Router %d has no outport for a "
+                 "coordinate route, check the topology.\n",
+                 m_router->get_id());
+        double trust =
+            m_router->get_trust(m_router->getOutportDirection(candidate));
+        if (outport == -1 || trust > best_trust) {
+            outport = candidate;
+            best_trust = trust;
+        }
+    }
+
+    PortDirection outport_dirn = m_router->getOutportDirection(outport);
+    m_router->decrement_trust(outport_dirn);
+    t_flit->add_to_direction(outport_dirn);
+    return outport;
+}
+
+int
+RoutingUnit::outportComputeSource(flit *t_flit)
+{
+    RouteInfo route = t_flit->get_route();
+    assert(route.source_hops > 0);
+
+    int outports[] = {m_north_outport, m_east_outport, m_south_outport,
+                      m_west_outport};
+    int outport = outports[route.source_route & 3];
+    panic_if(outport == -1, "Router %d has no outport for the source "
+             "route of %s\n", m_router->get_id(), *t_flit);
+
+    route.source_route >>= 2;
+    route.source_hops--;
+    t_flit->set_route(route);
+
+    // Same trust bookkeeping as when the hop is computed here
+    PortDirection outport_dirn = m_router->getOutportDirection(outport);
+    m_router->decrement_trust(outport_dirn);
+    t_flit->add_to_direction(outport_dirn);
+    return outport;
+}
+
+// Minimal directions around a torus ring (both when the destination is
+// half way around). Rings of up to two routers have no wraparound link.
+static void
+torusRingOutports(int my, int dest, int size, int up_outport,
+                  int down_outport, std::vector<int> &candidates)
+{
+    if (my == dest)
+        return;
+
+    if (size <= 2) {
+        candidates.push_back(dest > my ? up_outport : down_outport);
+        return;
+    }
+
+    int up_hops = (dest - my + size) % size;
+    int down_hops = size - up_hops;
+    if (up_hops <= down_hops)
+        candidates.push_back(up_outport);
+    if (down_hops <= up_hops)
+        candidates.push_back(down_outport);
+}
+
+// Dimension-order routing in a 2D torus, X first, with trust choosing
+// the direction when both ways around a ring are minimal. Each ring is
+// cut at its wraparound link (the dateline): crossing it moves the
+// packet to VC class 1 and turning into the Y ring starts over in class
+// 0. As packets never turn from Y back to X, the channel dependencies
+// are acyclic.
+int
+RoutingUnit::outportComputeTorus(RouteInfo route, int inport,
+                                 PortDirection inport_dirn, flit *t_flit)
+{
+    int num_rows = m_router->get_net_ptr()->getNumRows();
+    int num_cols = m_router->get_net_ptr()->getNumCols();
+    assert(num_rows > 0 && num_cols > 0);
+
+    int my_id = m_router->get_id();
+    int my_x = my_id % num_cols;
+    int my_y = my_id / num_cols;
+
+    int dest_id = route.dest_router;
+    int dest_x = dest_id % num_cols;
+    int dest_y = dest_id / num_cols;
+
+    std::vector<int> candidates;
+    torusRingOutports(my_x, dest_x, num_cols, m_east_outport,
+                      m_west_outport, candidates);
+    if (candidates.empty()) {
+        torusRingOutports(my_y, dest_y, num_rows, m_north_outport,
+                          m_south_outport, candidates);
+    }
+    if (route.minimal)
+        candidates.resize(1);
+
+    int outport = selectTrustedOutport(candidates, t_flit);
+
+    bool x_hop = outport == m_east_outport || outport == m_west_outport;
+    bool same_ring = x_hop ?
+        (inport_dirn == "East" || inport_dirn == "West") :
+        (inport_dirn == "North" || inport_dirn == "South");
+    bool dateline = num_cols > 2 &&
+        ((outport == m_east_outport && my_x == num_cols - 1) ||
+         (outport == m_west_outport && my_x == 0));
+    dateline |= num_rows > 2 &&
+        ((outport == m_north_outport && my_y == num_rows - 1) ||
+         (outport == m_south_outport && my_y == 0));
+
+    route.vc_class = dateline ? 1 : (same_ring ? route.vc_class : 0);
+    t_flit->set_route(route);
+    return outport;
+}
+
+// Minimal adaptive routing in a 2D flattened butterfly, where each
+// router links to all routers of its row (X<col>) and of its column
+// (Y<row>). A packet takes at most one hop per dimension in a route
+// phase, the first hop of the phase in VC class 0 and the second in
+// class 1.
+int
+RoutingUnit::outportComputeFlattenedButterfly(RouteInfo route, int inport,
+                                              PortDirection inport_dirn,
+                                              flit *t_flit)
+{
+    int num_cols = m_router->get_net_ptr()->getNumCols();
+    assert(num_cols > 0);
+
+    int my_id = m_router->get_id();
+    int my_x = my_id % num_cols;
+    int my_y = my_id / num_cols;
+
+    int dest_id = route.dest_router;
+    int dest_x = dest_id % num_cols;
+    int dest_y = dest_id / num_cols;
+
+    std::vector<int> candidates;
+    if (dest_x != my_x)
+        candidates.push_back(coordinateOutport(m_x_outports, dest_x));
+    if (dest_y != my_y && (!route.minimal || candidates.empty()))
+        candidates.push_back(coordinateOutport(m_y_outports, dest_y));
+
+    int outport = selectTrustedOutport(candidates, t_flit);
+
+    route.vc_class = std::min(route.phase_hops, 1);
+    route.phase_hops++;
+    t_flit->set_route(route);
+    return outport;
+}
+
+// Routing in a dragonfly of fully connected groups of group_size
+// routers, each with global_links links to other groups. Global link
+// j of a group (router j / global_links, port G<j % global_links>)
+// leads to group (group + j + 1) % num_groups. A minimal route takes
+// at most one local hop (L<router>), one global hop and one more local
+// hop. With three VC classes the source router may instead send the
+// packet through an intermediate group over one of its own global
+// links, if that link is more trusted. The VC class counts the global
+// hops taken.
+int
+RoutingUnit::outportComputeDragonfly(RouteInfo route, int inport,
+                                     PortDirection inport_dirn,
+                                     flit *t_flit)
+{
+    GarnetNetwork *net_ptr = m_router->get_net_ptr();
+    int group_size = net_ptr->getDragonflyGroupSize();
+    int global_links = net_ptr->getDragonflyGlobalLinks();
+    int num_groups = net_ptr->getDragonflyNumGroups();
+
+    int my_id = m_router->get_id();
+    int my_group = my_id / group_size;
+    int my_idx = my_id % group_size;
+
+    int dest_id = route.dest_router;
+    int dest_group = dest_id / group_size;
+
+    if (route.waypoint == my_group || route.minimal)
+        route.waypoint = -1;
+    int target_group = route.waypoint >= 0 ? route.waypoint : dest_group;
+
+    std::vector<int> candidates;
+    if (target_group == my_group) {
+        candidates.push_back(
+            coordinateOutport(m_local_outports, dest_id % group_size));
+    } else {
+        int link = (target_group - my_group - 1 + num_groups) % num_groups;
+        int owner = link / global_links;
+        if (owner == my_idx) {
+            candidates.push_back(
+                coordinateOutport(m_global_outports, link % global_links));
+        } else {
+            candidates.push_back(coordinateOutport(m_local_outports, owner));
+        }
+    }
+
+    std::vector<int> waypoints;
+    if (!route.minimal && net_ptr->getNumVcClasses() > 2 &&
+        inport_dirn == "Local" && dest_group != my_group) {
+        for (int port = 0; port < global_links; port++) {
+            int link = my_idx * global_links + port;
+            int group = (my_group + link + 1) % num_groups;
+            if (group == dest_group)
+                continue;
+            candidates.push_back(coordinateOutport(m_global_outports, port));
+            waypoints.push_back(group);
+        }
+    }
+
+    int outport = selectTrustedOutport(candidates, t_flit);
+    for (int i = 1; i < (int)candidates.size(); i++) {
+        if (candidates[i] == outport)
+            route.waypoint = waypoints[i - 1];
+    }
+
+    if (m_router->getOutportDirection(outport)[0] == 'G')
+        route.vc_class++;
+    t_flit->set_route(route);
+    return outport;
+}
+
 // XY routing implemented using port directions
 // Only for reference purpose in a Mesh
 // By default Garnet uses the routing table
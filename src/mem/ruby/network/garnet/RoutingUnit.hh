@@ -64,6 +64,10 @@ class RoutingUnit
     // get output port from routing table
     int  lookupRoutingTable(int vnet, NetDest net_dest);
 
+    // Multicast: splits the destinations of the packet among the
+    // outports given by the routing table (one branch per outport)
+    std::vector<MulticastBranch> outportComputeMulticast(RouteInfo route);
+
     // Topology-specific direction based routing
     void addInDirection(PortDirection inport_dirn, int inport);
     void addOutDirection(PortDirection outport_dirn, int outport);
@@ -75,6 +79,31 @@ class RoutingUnit
 
     int outportComputeXYModified(RouteInfo route, int inport, PortDirection inport_dirn, int flit_id);
 
+    // Dimension-ordered routing on the escape VC (deadlock recovery)
+    // and for packets out of hop/redirect budget (livelock guard)
+    int outportComputeDOR(RouteInfo route, int inport,
+                          PortDirection inport_dirn, flit *t_flit);
+
+    // Coordinate-based routing for the Torus, FlattenedButterfly and
+    // Dragonfly topologies (configs/topologies). The minimal (and, in
+    // the dragonfly, non-minimal) candidate outports are computed from
+    // the router ids in O(1) and the most trusted one is taken, unless
+    // the packet is forced minimal. They also set the VC class of the
+    // next hop in the flit's route.
+    void initCoordinateRouting();
+    int outportComputeTorus(RouteInfo route, int inport,
+                            PortDirection inport_dirn, flit *t_flit);
+    int outportComputeFlattenedButterfly(RouteInfo route, int inport,
+                                         PortDirection inport_dirn,
+                                         flit *t_flit);
+    int outportComputeDragonfly(RouteInfo route, int inport,
+                                PortDirection inport_dirn, flit *t_flit);
+
+
+    // Source routing: takes the next hop of the path the source NI
+    // encoded in the route (mesh directions, see
+    // NetworkInterface::sourceRoute)
+    int outportComputeSource(flit *t_flit);
 
     // Custom Routing Algorithm using Port Directions
     int outportComputeCustom(RouteInfo route,
@@ -97,6 +126,21 @@ class RoutingUnit
 
     int getRoutingUnitNumber(int router_no, PortDirection outport_dirn, int num_cols);
 
+    // Takes the most trusted of the candidate outports (the first one
+    // on a tie), charges its trust and records the hop in the flit
+    int selectTrustedOutport(const std::vector<int> &candidates,
+                             flit *t_flit);
+
+    // Outports by coordinate: the mesh/torus directions, the row (X)
+    // and column (Y) links of the flattened butterfly, and the local
+    // (L) and global (G) links of the dragonfly, indexed by the router
+    // or link they lead to (-1: no such port)
+    int m_north_outport, m_east_outport, m_south_outport, m_west_outport;
+    std::vector<int> m_x_outports;
+    std::vector<int> m_y_outports;
+    std::vector<int> m_local_outports;
+    std::vector<int> m_global_outports;
+
     // Routing Table
     std::vector<std::vector<NetDest>> m_routing_table;
     std::vector<int> m_weight_table;
@@ -31,6 +31,8 @@
 
 #include "mem/ruby/network/garnet/SwitchAllocator.hh"
 
+#include <algorithm>
+
 #include "debug/RubyNetwork.hh"
 #include "mem/ruby/network/garnet/GarnetNetwork.hh"
 #include "mem/ruby/network/garnet/InputUnit.hh"
@@ -53,8 +55,11 @@ SwitchAllocator::SwitchAllocator(Router *router)
     m_num_vcs = m_router->get_num_vcs();
     m_vc_per_vnet = m_router->get_vc_per_vnet();
 
-    m_input_arbiter_activity = 0;
-    m_output_arbiter_activity = 0;
+    m_vc_arbiter_activity = 0;
+    m_spec_grants = 0;
+    m_spec_failures = 0;
+    m_bypass_attempts = 0;
+    m_bypass_hits = 0;
 }
 
 void
@@ -62,27 +67,29 @@ SwitchAllocator::init()
 {
     m_num_inports = m_router->get_num_inports();
     m_num_outports = m_router->get_num_outports();
-    m_round_robin_inport.resize(m_num_outports);
-    m_round_robin_invc.resize(m_num_inports);
-    m_port_requests.resize(m_num_inports);
-    m_vc_winners.resize(m_num_inports);
-
-    for (int i = 0; i < m_num_inports; i++) {
-        m_round_robin_invc[i] = 0;
-        m_port_requests[i] = -1;
-        m_vc_winners[i] = -1;
-    }
 
-    for (int i = 0; i < m_num_outports; i++) {
-        m_round_robin_inport[i] = 0;
-    }
+    m_vc_allocation = m_router->get_vc_allocation();
+    m_allocator.reset(Allocator::create(m_router->get_sw_allocator(),
+                                        m_num_inports, m_num_outports,
+                                        m_num_vcs,
+                                        m_router->get_allocator_iterations()));
+
+    m_requests.resize(m_num_inports);
+    m_spec_requests.resize(m_num_inports);
+    m_grants.assign(m_num_inports, -1);
+    m_outport_granted.assign(m_num_outports, false);
+    m_round_robin_va.assign(m_num_outports, 0);
+    m_bypass_invc.assign(m_num_inports, -1);
+    m_bypass_outport.assign(m_num_outports, false);
 }
 
 /*
- * The wakeup function of the SwitchAllocator performs a 2-stage
- * seperable switch allocation. At the end of the 2nd stage, a free
- * output VC is assigned to the winning flits of each output port.
- * There is no separate VCAllocator stage like the one in garnet1.0.
+ * The wakeup function of the SwitchAllocator performs switch allocation
+ * with the allocator configured for the router (see Allocator.hh).
+ * By default a free output VC is assigned to the winning flits of each
+ * output port at the end of SA (fused VA, as in garnet3.0). Optionally,
+ * VC allocation is a separate stage before SA, or speculative and in
+ * parallel with SA.
  * At the end of this function, the router is rescheduled to wakeup
  * next cycle for peforming SA for any flits ready next cycle.
  */
@@ -90,187 +97,269 @@ SwitchAllocator::init()
 void
 SwitchAllocator::wakeup()
 {
-    arbitrate_inports(); // First stage of allocation
-    arbitrate_outports(); // Second stage of allocation
+    if (m_vc_allocation == GarnetVcAllocation::Separate)
+        allocate_vcs(); // VC allocation stage
+
+    arbitrate_inports(); // Collect the requests
+    arbitrate_outports(); // Allocate the switch
 
     clear_request_vector();
     check_for_wakeup();
 }
 
 /*
- * SA-I (or SA-i) loops through all input VCs at every input port,
- * and selects one in a round robin manner.
- *    - For HEAD/HEAD_TAIL flits only selects an input VC whose output port
- *     has at least one free output VC.
- *    - For BODY/TAIL flits, only selects an input VC that has credits
- *      in its output VC.
- * Places a request for the output port from this input VC.
+ * Separate VC allocation stage: HEAD/HEAD_TAIL flits that are ready for
+ * SA but do not own an output VC compete for a free VC of their vnet at
+ * their output port. Each output port serves the input ports in a round
+ * robin manner. Winners go for SA in the next cycle.
+ */
+
+void
+SwitchAllocator::allocate_vcs()
+{
+    for (int outport = 0; outport < m_num_outports; outport++) {
+        auto output_unit = m_router->getOutputUnit(outport);
+        int inport = m_round_robin_va[outport];
+
+        for (int inport_iter = 0; inport_iter < m_num_inports;
+                 inport_iter++) {
+            auto input_unit = m_router->getInputUnit(inport);
+
+            for (int invc = 0; invc < m_num_vcs; invc++) {
+                if (!input_unit->need_stage(invc, SA_, curTick()) ||
+                    input_unit->get_outport(invc) != outport ||
+                    input_unit->get_outvc(invc) != -1) {
+                    continue;
+                }
+
+                m_vc_arbiter_activity++;
+                flit *t_flit = input_unit->peekTopFlit(invc);
+                if (!output_unit->has_free_vc(get_vnet(invc),
+                                              t_flit->get_route())) {
+                    continue;
+                }
+
+                vc_allocate(outport, inport, invc);
+                t_flit->advance_stage(SA_, m_router->clockEdge(Cycles(1)));
+                m_router->schedule_wakeup(Cycles(1));
+
+                m_round_robin_va[outport] = inport + 1;
+                if (m_round_robin_va[outport] >= m_num_inports)
+                    m_round_robin_va[outport] = 0;
+            }
+
+            inport++;
+            if (inport >= m_num_inports)
+                inport = 0;
+        }
+    }
+}
+
+/*
+ * SA-I collects, at every input port, the requests of the input VCs
+ * whose flit is in SA stage and allowed to be sent (see send_allowed).
+ * With speculative VC allocation, HEAD/HEAD_TAIL flits that do not own
+ * an output VC yet request speculatively.
+ * A flit bypassing the router pipeline this cycle is the only request
+ * of its input port.
  */
 
 void
 SwitchAllocator::arbitrate_inports()
 {
-    // Select a VC from each input in a round robin manner
-    // Independent arbiter at each input port
     for (int inport = 0; inport < m_num_inports; inport++) {
-        int invc = m_round_robin_invc[inport];
+        if (m_bypass_invc[inport] != -1) {
+            add_request(inport, m_bypass_invc[inport]);
+            continue;
+        }
 
-        for (int invc_iter = 0; invc_iter < m_num_vcs; invc_iter++) {
-            auto input_unit = m_router->getInputUnit(inport);
+        for (int invc = 0; invc < m_num_vcs; invc++) {
+            add_request(inport, invc);
+        }
+    }
+}
 
-            if (input_unit->need_stage(invc, SA_, curTick())) {
-                // This flit is in SA stage
+void
+SwitchAllocator::add_request(int inport, int invc)
+{
+    auto input_unit = m_router->getInputUnit(inport);
+    if (!input_unit->need_stage(invc, SA_, curTick()))
+        return;
 
-                int outport = input_unit->get_outport(invc);
-                int outvc = input_unit->get_outvc(invc);
+    int outport = input_unit->get_outport(invc);
+    int outvc = input_unit->get_outvc(invc);
 
-                // check if the flit in this InputVC is allowed to be sent
-                // send_allowed conditions described in that function.
-                bool make_request =
-                    send_allowed(inport, invc, outport, outvc);
+    // check if the flit in this InputVC is allowed to be sent
+    // send_allowed conditions described in that function.
+    if (!send_allowed(inport, invc, outport, outvc))
+        return;
 
-                if (make_request) {
-                    m_input_arbiter_activity++;
-                    m_port_requests[inport] = outport;
-                    m_vc_winners[inport] = invc;
+    SwitchRequest req = {invc, outport,
+                         input_unit->peekTopFlit(invc)->get_enqueue_time()};
 
-                    break; // got one vc winner for this port
-                }
-            }
+    if (outvc == -1 && m_vc_allocation == GarnetVcAllocation::Speculative)
+        m_spec_requests[inport].push_back(req);
+    else
+        m_requests[inport].push_back(req);
+}
+
+/*
+ * SA-II matches input ports to output ports with the allocator.
+ * Speculative requests are only matched on the input and output ports
+ * left over by the non-speculative ones. A speculative winner whose VC
+ * allocation fails (no free VC at the output port) wastes its switch
+ * slot.
+ */
+
+void
+SwitchAllocator::arbitrate_outports()
+{
+    m_allocator->allocate(m_requests, m_grants);
+    for (int inport = 0; inport < m_num_inports; inport++) {
+        if (m_grants[inport] == -1)
+            continue;
+        const SwitchRequest &req = m_requests[inport][m_grants[inport]];
+        m_outport_granted[req.outport] = true;
+        m_spec_requests[inport].clear();
+        send_flit(inport, req.invc, req.outport);
+    }
+
+    if (m_vc_allocation != GarnetVcAllocation::Speculative)
+        return;
+
+    bool has_spec_requests = false;
+    for (auto &requests : m_spec_requests) {
+        requests.erase(std::remove_if(requests.begin(), requests.end(),
+            [this](const SwitchRequest &req)
+            { return m_outport_granted[req.outport]; }),
+            requests.end());
+        has_spec_requests |= !requests.empty();
+    }
+    if (!has_spec_requests)
+        return;
 
-            invc++;
-            if (invc >= m_num_vcs)
-                invc = 0;
+    m_allocator->allocate(m_spec_requests, m_grants);
+    for (int inport = 0; inport < m_num_inports; inport++) {
+        if (m_grants[inport] == -1)
+            continue;
+        const SwitchRequest &req = m_spec_requests[inport][m_grants[inport]];
+        m_spec_grants++;
+
+        flit *t_flit = m_router->getInputUnit(inport)->peekTopFlit(req.invc);
+        if (!m_router->getOutputUnit(req.outport)->has_free_vc(
+                get_vnet(req.invc), t_flit->get_route())) {
+            m_spec_failures++;
+            continue;
         }
+        send_flit(inport, req.invc, req.outport);
     }
 }
 
 /*
- * SA-II (or SA-o) loops through all output ports,
- * and selects one input VC (that placed a request during SA-I)
- * as the winner for this output port in a round robin manner.
- *      - For HEAD/HEAD_TAIL flits, performs simplified outvc allocation.
- *        (i.e., select a free VC from the output port).
+ * Send the winner of an output port to the CrossbarSwitch.
+ *      - For HEAD/HEAD_TAIL flits, performs simplified outvc allocation
+ *        if none was done before (i.e., select a free VC from the output
+ *        port).
  *      - For BODY/TAIL flits, decrement a credit in the output vc.
- * The winning flit is read out from the input VC and sent to the
- * CrossbarSwitch.
  * An increment_credit signal is sent from the InputUnit
  * to the upstream router. For HEAD_TAIL/TAIL flits, is_free_signal in the
  * credit is set to true.
  */
 
 void
-SwitchAllocator::arbitrate_outports()
+SwitchAllocator::send_flit(int inport, int invc, int outport)
 {
-    // Now there are a set of input vc requests for output vcs.
-    // Again do round robin arbitration on these requests
-    // Independent arbiter at each output port
-    for (int outport = 0; outport < m_num_outports; outport++) {
-        int inport = m_round_robin_inport[outport];
-
-        for (int inport_iter = 0; inport_iter < m_num_inports;
-                 inport_iter++) {
-
-            // inport has a request this cycle for outport
-            if (m_port_requests[inport] == outport) {
-                auto output_unit = m_router->getOutputUnit(outport);
-                auto input_unit = m_router->getInputUnit(inport);
-
-                // grant this outport to this inport
-                int invc = m_vc_winners[inport];
+    auto output_unit = m_router->getOutputUnit(outport);
+    auto input_unit = m_router->getInputUnit(inport);
 
-                int outvc = input_unit->get_outvc(invc);
-                if (outvc == -1) {
-                    // VC Allocation - select any free VC from outport
-                    outvc = vc_allocate(outport, inport, invc);
-                }
+    int outvc = input_unit->get_outvc(invc);
+    if (outvc == -1) {
+        // VC Allocation - select any free VC from outport
+        outvc = vc_allocate(outport, inport, invc);
+    }
 
-                // remove flit from Input VC
-                flit *t_flit = input_unit->getTopFlit(invc);
-
-                DPRINTF(RubyNetwork, "SwitchAllocator at Router %d "
-                                     "granted outvc %d at outport %d "
-                                     "to invc %d at inport %d to flit %s at "
-                                     "cycle: %lld\n",
-                        m_router->get_id(), outvc,
-                        m_router->getPortDirectionName(
-                            output_unit->get_direction()),
-                        invc,
-                        m_router->getPortDirectionName(
-                            input_unit->get_direction()),
-                            *t_flit,
-                        m_router->curCycle());
-
-
-
-                // Update outport field in the flit since this is
-                // used by CrossbarSwitch code to send it out of
-                // correct outport.
-                // Note: post route compute in InputUnit,
-                // outport is updated in VC, but not in flit
-                t_flit->set_outport(outport);
-
-                // set outvc (i.e., invc for next hop) in flit
-                // (This was updated in VC by vc_allocate, but not in flit)
-                t_flit->set_vc(outvc);
-
-                // decrement credit in outvc
-                output_unit->decrement_credit(outvc);
-
-                // flit ready for Switch Traversal
-                t_flit->advance_stage(ST_, curTick());
-                m_router->grant_switch(inport, t_flit);
-                m_output_arbiter_activity++;
-
-                if ((t_flit->get_type() == TAIL_) ||
-                    t_flit->get_type() == HEAD_TAIL_) {
-
-                    // This Input VC should now be empty
-                    assert(!(input_unit->isReady(invc, curTick())));
-
-                    // Free this VC
-                    input_unit->set_vc_idle(invc, curTick());
-
-                    // Send a credit back
-                    // along with the information that this VC is now idle
-                    input_unit->increment_credit(invc, true, curTick());
-                } else {
-                    // Send a credit back
-                    // but do not indicate that the VC is idle
-                    input_unit->increment_credit(invc, false, curTick());
-                }
+    // A multicast packet sends a copy of the flit to each of its
+    // branches (outports) in turn. The flit only leaves the input VC,
+    // and its credit is only returned upstream, with the last branch.
+    bool last_branch = true;
+    NetDest branch_dest;
+    if (input_unit->is_multicast(invc))
+        last_branch = input_unit->advance_branch(invc, branch_dest);
+
+    // remove flit from Input VC
+    flit *t_flit;
+    if (last_branch) {
+        t_flit = input_unit->getTopFlit(invc);
+    } else {
+        t_flit = new flit(*input_unit->peekTopFlit(invc));
+        m_router->get_net_ptr()->increment_multicast_forks();
+    }
 
-                // remove this request
-                m_port_requests[inport] = -1;
+    if (!branch_dest.isEmpty()) {
+        RouteInfo route = t_flit->get_route();
+        route.net_dest = branch_dest;
+        t_flit->set_route(route);
+    }
 
-                // Update Round Robin pointer
-                m_round_robin_inport[outport] = inport + 1;
-                if (m_round_robin_inport[outport] >= m_num_inports)
-                    m_round_robin_inport[outport] = 0;
+    DPRINTF(RubyNetwork, "SwitchAllocator at Router %d "
+                         "granted outvc %d at outport %d "
+                         "to invc %d at inport %d to flit %s at "
+                         "cycle: %lld\n",
+            m_router->get_id(), outvc,
+            m_router->getPortDirectionName(
+                output_unit->get_direction()),
+            invc,
+            m_router->getPortDirectionName(
+                input_unit->get_direction()),
+                *t_flit,
+            m_router->curCycle());
+
+    // Update outport field in the flit since this is
+    // used by CrossbarSwitch code to send it out of
+    // correct outport.
+    // Note: post route compute in InputUnit,
+    // outport is updated in VC, but not in flit
+    t_flit->set_outport(outport);
+
+    // set outvc (i.e., invc for next hop) in flit
+    // (This was updated in VC by vc_allocate, but not in flit)
+    t_flit->set_vc(outvc);
+
+    // decrement credit in outvc
+    output_unit->decrement_credit(outvc);
+
+    // flit ready for Switch Traversal
+    t_flit->advance_stage(ST_, curTick());
+    m_router->grant_switch(inport, t_flit);
+
+    if (!last_branch)
+        return;
 
-                // Update Round Robin pointer to the next VC
-                // We do it here to keep it fair.
-                // Only the VC which got switch traversal
-                // is updated.
-                m_round_robin_invc[inport] = invc + 1;
-                if (m_round_robin_invc[inport] >= m_num_vcs)
-                    m_round_robin_invc[inport] = 0;
+    if ((t_flit->get_type() == TAIL_) ||
+        t_flit->get_type() == HEAD_TAIL_) {
 
+        // This Input VC should now be empty
+        assert(!(input_unit->isReady(invc, curTick())));
 
-                break; // got a input winner for this outport
-            }
+        // Free this VC
+        input_unit->set_vc_idle(invc, curTick());
 
-            inport++;
-            if (inport >= m_num_inports)
-                inport = 0;
-        }
+        // Send a credit back
+        // along with the information that this VC is now idle
+        input_unit->increment_credit(invc, true, curTick());
+    } else {
+        // Send a credit back
+        // but do not indicate that the VC is idle
+        input_unit->increment_credit(invc, false, curTick());
     }
 }
 
 /*
  * A flit can be sent only if
  * (1) there is at least one free output VC at the
- *     output port (for HEAD/HEAD_TAIL),
+ *     output port (for HEAD/HEAD_TAIL, fused VA; with speculative VA
+ *     this is checked after SA, with a separate VA stage the flit
+ *     must own an output VC),
  *  or
  * (2) if there is at least one credit (i.e., buffer slot)
  *     within the VC for BODY/TAIL flits of multi-flit packets.
@@ -293,12 +382,22 @@ SwitchAllocator::send_allowed(int inport, int invc, int outport, int outvc)
     bool has_credit = false;
 
     auto output_unit = m_router->getOutputUnit(outport);
-    if (!has_outvc) {
+    if (!has_outvc && m_vc_allocation == GarnetVcAllocation::Separate) {
+        // has to win VC allocation first
+        return false;
+    } else if (!has_outvc &&
+               m_vc_allocation == GarnetVcAllocation::Speculative) {
+        // VC allocation is resolved after SA
+        has_outvc = true;
+        has_credit = true;
+    } else if (!has_outvc) {
 
         // needs outvc
         // this is only true for HEAD and HEAD_TAIL flits.
+        RouteInfo route = m_router->getInputUnit(inport)->
+            peekTopFlit(invc)->get_route();
 
-        if (output_unit->has_free_vc(vnet)) {
+        if (output_unit->has_free_vc(vnet, route)) {
 
             has_outvc = true;
 
@@ -343,8 +442,10 @@ int
 SwitchAllocator::vc_allocate(int outport, int inport, int invc)
 {
     // Select a free VC from the output port
-    int outvc =
-        m_router->getOutputUnit(outport)->select_free_vc(get_vnet(invc));
+    RouteInfo route = m_router->getInputUnit(inport)->
+        peekTopFlit(invc)->get_route();
+    int outvc = m_router->getOutputUnit(outport)->
+        select_free_vc(get_vnet(invc), route);
 
     // has to get a valid VC since it checked before performing SA
     assert(outvc != -1);
@@ -352,6 +453,60 @@ SwitchAllocator::vc_allocate(int outport, int inport, int invc)
     return outvc;
 }
 
+/*
+ * Switch bypass: a flit that arrives at the head of its input VC skips
+ * the buffered pipeline stages and goes through SA and ST in its
+ * arrival cycle if
+ * (1) no other flit at this router is buffered for the same output
+ *     port, or has bypassed to it this cycle (so SA is contention-free
+ *     and pt-to-pt ordering holds), and
+ * (2) it is allowed to be sent (free output VC or credit).
+ * The flit is then given priority in SA-I at its input port.
+ */
+
+bool
+SwitchAllocator::try_bypass(int inport, int invc, flit *t_flit)
+{
+    m_bypass_attempts++;
+
+    auto input_unit = m_router->getInputUnit(inport);
+    if (input_unit->peekTopFlit(invc) != t_flit)
+        return false;
+
+    // a multicast packet is sent to its branches one at a time
+    if (input_unit->is_multicast(invc))
+        return false;
+
+    int outport = input_unit->get_outport(invc);
+    if (m_bypass_outport[outport])
+        return false;
+
+    for (int i = 0; i < m_num_inports; i++) {
+        auto other_unit = m_router->getInputUnit(i);
+        for (int vc = 0; vc < m_num_vcs; vc++) {
+            if ((i == inport && vc == invc) || other_unit->is_vc_empty(vc))
+                continue;
+            if (other_unit->get_outport(vc) == outport)
+                return false;
+        }
+    }
+
+    int outvc = input_unit->get_outvc(invc);
+    if (!send_allowed(inport, invc, outport, outvc))
+        return false;
+
+    // a speculative request is not contention-free
+    if (outvc == -1 && !m_router->getOutputUnit(outport)->has_free_vc(
+            get_vnet(invc), t_flit->get_route())) {
+        return false;
+    }
+
+    m_bypass_invc[inport] = invc;
+    m_bypass_outport[outport] = true;
+    m_bypass_hits++;
+    return true;
+}
+
 // Wakeup the router next cycle to perform SA again
 // if there are flits ready.
 void
@@ -387,14 +542,24 @@ SwitchAllocator::get_vnet(int invc)
 void
 SwitchAllocator::clear_request_vector()
 {
-    std::fill(m_port_requests.begin(), m_port_requests.end(), -1);
+    for (int i = 0; i < m_num_inports; i++) {
+        m_requests[i].clear();
+        m_spec_requests[i].clear();
+    }
+    std::fill(m_outport_granted.begin(), m_outport_granted.end(), false);
+    std::fill(m_bypass_invc.begin(), m_bypass_invc.end(), -1);
+    std::fill(m_bypass_outport.begin(), m_bypass_outport.end(), false);
 }
 
 void
 SwitchAllocator::resetStats()
 {
-    m_input_arbiter_activity = 0;
-    m_output_arbiter_activity = 0;
+    m_allocator->resetStats();
+    m_vc_arbiter_activity = 0;
+    m_spec_grants = 0;
+    m_spec_failures = 0;
+    m_bypass_attempts = 0;
+    m_bypass_hits = 0;
 }
 
 } // namespace garnet
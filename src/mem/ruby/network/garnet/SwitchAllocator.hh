@@ -33,9 +33,12 @@
 #define __MEM_RUBY_NETWORK_GARNET_0_SWITCHALLOCATOR_HH__
 
 #include <iostream>
+#include <memory>
 #include <vector>
 
+#include "enums/GarnetVcAllocation.hh"
 #include "mem/ruby/common/Consumer.hh"
+#include "mem/ruby/network/garnet/Allocator.hh"
 #include "mem/ruby/network/garnet/CommonTypes.hh"
 
 namespace gem5
@@ -48,6 +51,7 @@ namespace garnet
 {
 
 class Router;
+class flit;
 class InputUnit;
 class OutputUnit;
 
@@ -61,35 +65,59 @@ class SwitchAllocator : public Consumer
     void check_for_wakeup();
     int get_vnet (int invc);
     void print(std::ostream& out) const {};
+    void allocate_vcs();
     void arbitrate_inports();
     void arbitrate_outports();
     bool send_allowed(int inport, int invc, int outport, int outvc);
     int vc_allocate(int outport, int inport, int invc);
+    bool try_bypass(int inport, int invc, flit *t_flit);
 
     inline double
     get_input_arbiter_activity()
     {
-        return m_input_arbiter_activity;
+        return m_allocator->get_input_arbiter_activity();
     }
     inline double
     get_output_arbiter_activity()
     {
-        return m_output_arbiter_activity;
+        return m_allocator->get_output_arbiter_activity();
     }
+    inline double get_vc_arbiter_activity() { return m_vc_arbiter_activity; }
+    inline double get_spec_grants() { return m_spec_grants; }
+    inline double get_spec_failures() { return m_spec_failures; }
+
+    inline double get_bypass_attempts() { return m_bypass_attempts; }
+    inline double get_bypass_hits() { return m_bypass_hits; }
 
     void resetStats();
 
   private:
+    void add_request(int inport, int invc);
+    void send_flit(int inport, int invc, int outport);
+
     int m_num_inports, m_num_outports;
     int m_num_vcs, m_vc_per_vnet;
 
-    double m_input_arbiter_activity, m_output_arbiter_activity;
+    double m_vc_arbiter_activity;
+    double m_spec_grants, m_spec_failures;
+    double m_bypass_attempts, m_bypass_hits;
 
     Router *m_router;
-    std::vector<int> m_round_robin_invc;
-    std::vector<int> m_round_robin_inport;
-    std::vector<int> m_port_requests;
-    std::vector<int> m_vc_winners;
+    GarnetVcAllocation m_vc_allocation;
+    std::unique_ptr<Allocator> m_allocator;
+
+    // SA requests of this cycle, per inport
+    std::vector<std::vector<SwitchRequest>> m_requests;
+    std::vector<std::vector<SwitchRequest>> m_spec_requests;
+    std::vector<int> m_grants;
+    std::vector<bool> m_outport_granted;
+
+    // Separate VA stage
+    std::vector<int> m_round_robin_va; // per outport
+
+    // Switch bypass grants of this cycle
+    std::vector<int> m_bypass_invc; // per inport
+    std::vector<bool> m_bypass_outport;
 };
 
 } // namespace garnet
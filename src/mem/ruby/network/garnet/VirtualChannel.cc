@@ -42,7 +42,8 @@ namespace garnet
 
 VirtualChannel::VirtualChannel()
   : inputBuffer(), m_vc_state(IDLE_, Tick(0)), m_output_port(-1),
-    m_enqueue_time(INFINITE_), m_output_vc(-1)
+    m_enqueue_time(INFINITE_), m_output_vc(-1), m_dropping(false),
+    m_branches(), m_branch(0)
 {
 }
 
@@ -54,6 +55,9 @@ VirtualChannel::set_idle(Tick curTime)
     m_enqueue_time = Tick(INFINITE_);
     m_output_port = -1;
     m_output_vc = -1;
+    m_dropping = false;
+    m_branches.clear();
+    m_branch = 0;
 }
 
 void
@@ -64,6 +68,33 @@ VirtualChannel::set_active(Tick curTime)
     m_enqueue_time = curTime;
 }
 
+void
+VirtualChannel::set_branches(const std::vector<MulticastBranch> &branches)
+{
+    assert(!branches.empty());
+    m_branches = branches;
+    m_branch = 0;
+    m_output_port = m_branches[0].outport;
+    m_output_vc = -1;
+}
+
+// Called once the flit at the head of the VC has been granted the
+// current branch: returns the destinations of that branch, saves its
+// output VC and moves on to the next branch. Returns true if the flit
+// was sent to the last branch.
+bool
+VirtualChannel::advance_branch(NetDest &dest)
+{
+    MulticastBranch &branch = m_branches[m_branch];
+    dest = branch.dest;
+    branch.outvc = m_output_vc;
+
+    m_branch = (m_branch + 1) % m_branches.size();
+    m_output_port = m_branches[m_branch].outport;
+    m_output_vc = m_branches[m_branch].outvc;
+    return m_branch == 0;
+}
+
 bool
 VirtualChannel::need_stage(flit_stage stage, Tick time)
 {
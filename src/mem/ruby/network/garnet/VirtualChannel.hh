@@ -33,6 +33,7 @@
 #define __MEM_RUBY_NETWORK_GARNET_0_VIRTUALCHANNEL_HH__
 
 #include <utility>
+#include <vector>
 
 #include "mem/ruby/network/garnet/CommonTypes.hh"
 #include "mem/ruby/network/garnet/flitBuffer.hh"
@@ -64,6 +65,18 @@ class VirtualChannel
     inline void set_enqueue_time(Tick time) { m_enqueue_time = time; }
     inline VC_state_type get_state()        { return m_vc_state.first; }
 
+    // Packet on this VC is being discarded (hop/redirect budget)
+    inline bool is_dropping()               { return m_dropping; }
+    inline void set_dropping()              { m_dropping = true; }
+
+    // Multicast packet: the flit at the head of the VC is sent to each
+    // branch in turn and only leaves the VC with the last one
+    void set_branches(const std::vector<MulticastBranch> &branches);
+    inline bool is_multicast()         { return m_branches.size() > 1; }
+    bool advance_branch(NetDest &dest);
+
+    inline bool isEmpty()                   { return inputBuffer.isEmpty(); }
+
     inline bool
     isReady(Tick curTime)
     {
@@ -104,6 +117,9 @@ class VirtualChannel
     int m_output_port;
     Tick m_enqueue_time;
     int m_output_vc;
+    bool m_dropping;
+    std::vector<MulticastBranch> m_branches;
+    int m_branch;
 };
 
 } // namespace garnet
@@ -32,6 +32,8 @@
 
 #include "base/intmath.hh"
 #include "debug/RubyNetwork.hh"
+#include "mem/ruby/network/garnet/GarnetNetwork.hh"
+#include "mem/ruby/slicc_interface/ObjectPool.hh"
 
 static int flit_counter = 0;
 
@@ -46,12 +48,14 @@ namespace garnet
 
 // Constructor for the flit
             flit::flit(int packet_id, int id, int vc, int vnet, RouteInfo route, int size,
-                    MsgPtr msg_ptr, int MsgSize, uint32_t bWidth, Tick curTime, bool increment)
+                    MsgPtr msg_ptr, GarnetNetwork *net_ptr, int MsgSize, uint32_t bWidth,
+                    Tick curTime, bool increment)
 {
                 if (increment)
                     m_flit_id = ++flit_counter;
     m_size = size;
-    m_msg_ptr = msg_ptr;
+    m_net_ptr = net_ptr;
+    m_msg_ptr.reset(net_ptr ? &net_ptr->inFlight() : nullptr, msg_ptr);
     m_enqueue_time = curTime;
     m_dequeue_time = curTime;
     m_time = curTime;
@@ -82,8 +86,24 @@ namespace garnet
 }
 
             flit::flit(int packet_id, int id, int vc, int vnet, RouteInfo route, int size,
-                    MsgPtr msg_ptr, int MsgSize, uint32_t bWidth, Tick curTime)
-                    : flit(packet_id, id, vc, vnet, route, size, msg_ptr, MsgSize, bWidth, curTime, false) {}
+                    MsgPtr msg_ptr, GarnetNetwork *net_ptr, int MsgSize, uint32_t bWidth,
+                    Tick curTime)
+                    : flit(packet_id, id, vc, vnet, route, size, msg_ptr, net_ptr, MsgSize,
+                           bWidth, curTime, false) {}
+
+// Flits are allocated from a slab pool: a packet creates and deletes one
+// per hop and link. Subclasses (Credit) differ in size and use the heap.
+void *
+flit::operator new(std::size_t size)
+{
+    return ObjectPool<flit>::allocate(size);
+}
+
+void
+flit::operator delete(void *ptr, std::size_t size)
+{
+    ObjectPool<flit>::release(ptr, size);
+}
 
 flit *
 flit::serialize(int ser_id, int parts, uint32_t bWidth)
@@ -96,7 +116,8 @@ flit::serialize(int ser_id, int parts, uint32_t bWidth)
     assert(new_id < new_size);
 
     flit *fl = new flit(m_packet_id, new_id, m_vc, m_vnet, m_route,
-                    new_size, m_msg_ptr, msgSize, bWidth, m_time);
+                    new_size, m_msg_ptr.get(), m_net_ptr, msgSize, bWidth,
+                    m_time);
     fl->set_enqueue_time(m_enqueue_time);
     fl->set_src_delay(src_delay);
     return fl;
@@ -111,7 +132,8 @@ flit::deserialize(int des_id, int num_flits, uint32_t bWidth)
     assert(new_id < new_size);
 
     flit *fl = new flit(m_packet_id, new_id, m_vc, m_vnet, m_route,
-                    new_size, m_msg_ptr, msgSize, bWidth, m_time);
+                    new_size, m_msg_ptr.get(), m_net_ptr, msgSize, bWidth,
+                    m_time);
     fl->set_enqueue_time(m_enqueue_time);
     fl->set_src_delay(src_delay);
     return fl;
@@ -161,15 +183,13 @@ void
 bool
 flit::functionalRead(Packet *pkt, WriteMask &mask)
 {
-    Message *msg = m_msg_ptr.get();
-    return msg->functionalRead(pkt, mask);
+    return m_msg_ptr->functionalRead(pkt, mask);
 }
 
 bool
 flit::functionalWrite(Packet *pkt)
 {
-    Message *msg = m_msg_ptr.get();
-    return msg->functionalWrite(pkt);
+    return m_msg_ptr->functionalWrite(pkt);
 }
 
 } // namespace garnet
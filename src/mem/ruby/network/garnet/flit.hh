@@ -37,6 +37,7 @@
 using namespace std;
 
 #include "base/types.hh"
+#include "mem/ruby/network/MessageIndex.hh"
 #include "mem/ruby/network/garnet/CommonTypes.hh"
 #include "mem/ruby/slicc_interface/Message.hh"
 
@@ -49,18 +50,81 @@ namespace ruby
 namespace garnet
 {
 
+class GarnetNetwork;
+
+/*
+ * The message carried by a flit. The messages of all live flits of a
+ * network, from flitization to ejection at the destination NI, are kept
+ * in the network's index of in-flight messages that functional accesses
+ * search instead of every buffer of every router, link and NI.
+ */
+class FlitMsgPtr
+{
+  public:
+    FlitMsgPtr() : m_index(nullptr) {}
+    FlitMsgPtr(const FlitMsgPtr &other) : FlitMsgPtr()
+    {
+        reset(other.m_index, other.m_msg);
+    }
+    ~FlitMsgPtr() { set(MsgPtr()); }
+
+    FlitMsgPtr &
+    operator=(const FlitMsgPtr &other)
+    {
+        reset(other.m_index, other.m_msg);
+        return *this;
+    }
+
+    // Carries msg, indexed in the in-flight messages of index
+    void
+    reset(MessageIndex *index, const MsgPtr &msg)
+    {
+        if (index != m_index) {
+            set(MsgPtr());
+            m_index = index;
+        }
+        set(msg);
+    }
+
+    const MsgPtr &get() const { return m_msg; }
+    Message *operator->() const { return m_msg.get(); }
+
+  private:
+    void
+    set(const MsgPtr &msg)
+    {
+        if (msg) {
+            assert(m_index);
+            m_index->insert(msg);
+        }
+        if (m_msg)
+            m_index->erase(m_msg);
+        m_msg = msg;
+    }
+
+    MessageIndex *m_index;
+    MsgPtr m_msg;
+};
+
 class flit
 {
   public:
-    flit() {}
+    flit() : m_net_ptr(nullptr) {}
     flit(int packet_id, int id, int vc, int vnet, RouteInfo route, int size,
-         MsgPtr msg_ptr, int MsgSize, uint32_t bWidth, Tick curTime, bool increment);
+         MsgPtr msg_ptr, GarnetNetwork *net_ptr, int MsgSize, uint32_t bWidth,
+         Tick curTime, bool increment);
 
     flit(int packet_id, int id, int vc, int vnet, RouteInfo route, int size,
-         MsgPtr msg_ptr, int MsgSize, uint32_t bWidth, Tick curTime);
+         MsgPtr msg_ptr, GarnetNetwork *net_ptr, int MsgSize, uint32_t bWidth,
+         Tick curTime);
 
     virtual ~flit(){};
 
+    // Flits are recycled through a free list rather than the heap:
+    // NIs and SerDes bridges create and delete one per flit sent
+    static void *operator new(std::size_t size);
+    static void operator delete(void *ptr, std::size_t size);
+
     int get_outport() {return m_outport; }
     int get_size() { return m_size; }
     Tick get_enqueue_time() { return m_enqueue_time; }
@@ -71,7 +135,7 @@ class flit
     int get_vnet() { return m_vnet; }
     int get_vc() { return m_vc; }
     RouteInfo get_route() { return m_route; }
-    MsgPtr& get_msg_ptr() { return m_msg_ptr; }
+    const MsgPtr &get_msg_ptr() { return m_msg_ptr.get(); }
     flit_type get_type() { return m_type; }
     std::pair<flit_stage, Tick> get_stage() { return m_stage; }
     Tick get_src_delay() { return src_delay; }
@@ -127,6 +191,21 @@ class flit
 
     void add_to_direction(string dir) {m_path_direction.push_back(dir);}
 
+    // Undo the direction recorded by the route computation at the
+    // current router, if any (used when a packet is re-routed in place).
+    // Returns the direction undone, empty if none.
+    string
+    undo_current_direction()
+    {
+        string dirn;
+        if (!m_path_direction.empty() &&
+            m_path_direction.size() == m_path.size()) {
+            dirn = m_path_direction.back();
+            m_path_direction.pop_back();
+        }
+        return dirn;
+    }
+
     vector<int> get_path() { return m_path; }
 
     vector<string> get_direction() { return m_path_direction; }
@@ -159,7 +238,8 @@ class flit
     Tick m_enqueue_time, m_dequeue_time;
     Tick m_time;
     flit_type m_type;
-    MsgPtr m_msg_ptr;
+    FlitMsgPtr m_msg_ptr;
+    GarnetNetwork *m_net_ptr;
     int m_outport;
     Tick src_delay;
     std::pair<flit_stage, Tick> m_stage;
@@ -116,6 +116,21 @@ PerfectSwitch::updatePriorityGroups(int vnet, MessageBuffer* in_buf)
             m_in_prio_groups[vnet].emplace_back();
         m_in_prio_groups[vnet].back().push_back(buf);
     }
+
+    // reset ready lists
+    while (m_in_ready.size() <= vnet)
+        m_in_ready.emplace_back();
+    m_in_ready[vnet].clear();
+    for (int prio_lv = 0; prio_lv < m_in_prio_groups[vnet].size();
+         ++prio_lv) {
+        m_in_ready[vnet].emplace_back();
+        auto &in = m_in_prio_groups[vnet][prio_lv];
+        for (int i = 0; i < in.size(); ++i) {
+            m_in_position[in[i]] = {vnet, prio_lv, i};
+            if (!in[i]->isEmpty())
+                m_in_ready[vnet][prio_lv].push_back(i);
+        }
+    }
 }
 
 void
@@ -149,36 +164,46 @@ PerfectSwitch::inBuffer(int in_port, int vnet) const
     }
 }
 
+/*
+ * Only the input ports with messages (m_in_ready) are visited. Within a
+ * priority group they are checked in port order, starting with the one
+ * with the oldest message, as if all ports of the group were scanned.
+ */
 void
 PerfectSwitch::operateVnet(int vnet)
 {
     if (m_pending_message_count[vnet] == 0)
         return;
 
-    for (auto &in : m_in_prio_groups[vnet]) {
+    for (int prio_lv = 0; prio_lv < m_in_prio_groups[vnet].size();
+         ++prio_lv) {
+        auto &in = m_in_prio_groups[vnet][prio_lv];
+        std::vector<int> &ready = m_in_ready[vnet][prio_lv];
+        if (ready.empty())
+            continue;
+
         // first check the port with the oldest message
-        unsigned start_in_port = 0;
+        unsigned start = 0;
         Tick lowest_tick = MaxTick;
-        for (int i = 0; i < in.size(); ++i) {
-            MessageBuffer *buffer = in[i];
-            if (buffer) {
-                Tick ready_time = buffer->readyTime();
-                if (ready_time < lowest_tick){
-                    lowest_tick = ready_time;
-                    start_in_port = i;
-                }
+        for (int i = 0; i < ready.size(); ++i) {
+            Tick ready_time = in[ready[i]]->readyTime();
+            if (ready_time < lowest_tick){
+                lowest_tick = ready_time;
+                start = i;
             }
         }
         DPRINTF(RubyNetwork, "vnet %d: %d pending msgs. "
                             "Checking port %d first\n",
-                vnet, m_pending_message_count[vnet], start_in_port);
+                vnet, m_pending_message_count[vnet], ready[start]);
         // check all ports starting with the one with the oldest message
-        for (int i = 0; i < in.size(); ++i) {
-            int in_port = (i + start_in_port) % in.size();
-            MessageBuffer *buffer = in[in_port];
-            if (buffer)
-                operateMessageBuffer(buffer, vnet);
+        for (int i = 0; i < ready.size(); ++i) {
+            int in_port = ready[(i + start) % ready.size()];
+            operateMessageBuffer(in[in_port], vnet);
         }
+
+        ready.erase(std::remove_if(ready.begin(), ready.end(),
+                                   [&in](int i) { return in[i]->isEmpty(); }),
+                    ready.end());
     }
 }
 
@@ -304,6 +329,16 @@ PerfectSwitch::storeEventInfo(int info)
     m_pending_message_count[info]++;
 }
 
+void
+PerfectSwitch::messageEnqueued(MessageBuffer *buf)
+{
+    const InPortPosition &pos = m_in_position.at(buf);
+    std::vector<int> &ready = m_in_ready[pos.vnet][pos.prio_lv];
+    auto it = std::lower_bound(ready.begin(), ready.end(), pos.index);
+    if (it == ready.end() || *it != pos.index)
+        ready.insert(it, pos.index);
+}
+
 void
 PerfectSwitch::clearStats()
 {
@@ -50,6 +50,7 @@
 
 #include <iostream>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "mem/ruby/common/Consumer.hh"
@@ -88,6 +89,7 @@ class PerfectSwitch : public Consumer
 
     void wakeup();
     void storeEventInfo(int info);
+    void messageEnqueued(MessageBuffer *buf);
 
     void clearStats();
     void collateStats();
@@ -120,6 +122,18 @@ class PerfectSwitch : public Consumer
     // input ports grouped by priority; indexed by vnet,prio_lv
     std::vector<std::vector<std::vector<MessageBuffer*>>> m_in_prio_groups;
 
+    // input ports with messages, i.e., the indices into
+    // m_in_prio_groups in increasing order; indexed by vnet,prio_lv
+    std::vector<std::vector<std::vector<int>>> m_in_ready;
+    // vnet, prio_lv and index in the group of each input port
+    struct InPortPosition
+    {
+        int vnet;
+        int prio_lv;
+        int index;
+    };
+    std::unordered_map<const MessageBuffer*, InPortPosition> m_in_position;
+
     void updatePriorityGroups(int vnet, MessageBuffer* buf);
 
     uint32_t m_virtual_networks;
@@ -70,7 +70,7 @@ Throttle::Throttle(int sID, RubySystem *rs, NodeID node, Cycles link_latency,
     : Consumer(em,  Switch::THROTTLE_EV_PRI),
       m_switch_id(sID), m_switch(em), m_node(node),
       m_physical_vnets(false), m_ruby_system(rs),
-      throttleStats(em, node)
+      throttleStats(em, node, *this)
 {
     m_vnets = 0;
 
@@ -78,6 +78,8 @@ Throttle::Throttle(int sID, RubySystem *rs, NodeID node, Cycles link_latency,
     m_endpoint_bandwidth = endpoint_bandwidth;
 
     m_wakeups_wo_switch = 0;
+    m_drain_start = 0;
+    m_drain_cycles = 0;
 }
 
 Throttle::Throttle(int sID, RubySystem *rs, NodeID node, Cycles link_latency,
@@ -239,26 +241,36 @@ Throttle::operateVnet(int vnet, int channel, int &total_bw_remaining,
     }
 }
 
+bool
+Throttle::nextIterationDirection(int &wakeups_wo_switch) const
+{
+    wakeups_wo_switch++;
+
+    // invert priorities to avoid starvation seen in the component network
+    if (wakeups_wo_switch > PRIORITY_SWITCH_LIMIT) {
+        wakeups_wo_switch = 0;
+        return true;
+    }
+    return false;
+}
+
 void
 Throttle::wakeup()
 {
+    // Account for the cycles skipped since the last wakeup. A message
+    // that arrived ends the drain early: this wakeup recomputes the rest.
+    replayDrainCycles();
+    m_drain_cycles = 0;
+
     // Limits the number of message sent to a limited number of bytes/cycle.
     assert(getTotalLinkBandwidth() > 0);
     int bw_remaining = getTotalLinkBandwidth();
 
-    m_wakeups_wo_switch++;
     bool bw_saturated = false;
     bool output_blocked = false;
 
     // variable for deciding the direction in which to iterate
-    bool iteration_direction = false;
-
-
-    // invert priorities to avoid starvation seen in the component network
-    if (m_wakeups_wo_switch > PRIORITY_SWITCH_LIMIT) {
-        m_wakeups_wo_switch = 0;
-        iteration_direction = true;
-    }
+    bool iteration_direction = nextIterationDirection(m_wakeups_wo_switch);
 
     if (iteration_direction) {
         for (int vnet = 0; vnet < m_vnets; ++vnet) {
@@ -294,9 +306,110 @@ Throttle::wakeup()
 
     if (bw_saturated || output_blocked) {
         // We are out of bandwidth for this cycle, so wakeup next
-        // cycle and continue
-        DPRINTF(RubyNetwork, "%s scheduled again\n", *this);
-        scheduleEvent(Cycles(1));
+        // cycle and continue, or, if the following cycles only drain
+        // the messages already sent, once they are over
+        int drain_cycles = output_blocked ? 0 : countDrainCycles();
+        DPRINTF(RubyNetwork, "%s scheduled again in %d cycles\n", *this,
+                drain_cycles + 1);
+        scheduleEvent(Cycles(drain_cycles + 1));
+    }
+}
+
+/*
+ * Replays the cycle at time on units_remaining, as operateVnet would
+ * for all vnets, provided the link only carries the rest of messages
+ * already sent in that cycle. Returns false if a message would be sent,
+ * or an output buffer is full, instead.
+ */
+bool
+Throttle::drainCycle(Tick time, bool iteration_direction,
+                     std::vector<std::vector<int>> &units_remaining,
+                     int &bw_remaining, bool &bw_saturated) const
+{
+    int total_bw_remaining = getTotalLinkBandwidth();
+    bw_saturated = false;
+
+    for (int i = 0; i < m_vnets; ++i) {
+        int vnet = iteration_direction ? i : m_vnets - 1 - i;
+        MessageBuffer *in = m_in[vnet];
+        MessageBuffer *out = m_out[vnet];
+        if (out == nullptr || in == nullptr)
+            continue;
+
+        for (int channel = 0; channel < getChannelCnt(vnet); ++channel) {
+            int &units = units_remaining[vnet][channel];
+            int vnet_bw_remaining = m_physical_vnets ?
+                getLinkBandwidth(vnet) : total_bw_remaining;
+            bool ready = in->isReady(time);
+            if (!(units > 0 || ready))
+                continue;
+            if (!out->hasNSlotsAvailable(1, time))
+                return false;
+
+            if (vnet_bw_remaining > 0) {
+                // a message would be sent
+                if (units == 0)
+                    return false;
+
+                int spent = std::min(units, vnet_bw_remaining);
+                units -= spent;
+                vnet_bw_remaining -= spent;
+                total_bw_remaining -= spent;
+                if (units == 0 && ready && vnet_bw_remaining > 0)
+                    return false;
+            }
+
+            if (units > 0 || ready)
+                bw_saturated = bw_saturated || (vnet_bw_remaining == 0);
+        }
+    }
+
+    bw_remaining = total_bw_remaining;
+    return true;
+}
+
+// Number of cycles after this one in which the link stays saturated
+// by the rest of messages already sent, assuming no message arrives
+// (an arrival wakes the throttle up anyway)
+int
+Throttle::countDrainCycles()
+{
+    std::vector<std::vector<int>> units_remaining = m_units_remaining;
+    int wakeups_wo_switch = m_wakeups_wo_switch;
+    int cycles = 0;
+    int bw_remaining;
+    bool bw_saturated;
+
+    while (drainCycle(m_switch->clockEdge(Cycles(cycles + 1)),
+                      nextIterationDirection(wakeups_wo_switch),
+                      units_remaining, bw_remaining, bw_saturated) &&
+           bw_saturated) {
+        cycles++;
+    }
+
+    m_drain_start = m_switch->clockEdge(Cycles(1));
+    m_drain_cycles = cycles;
+    return cycles;
+}
+
+void
+Throttle::replayDrainCycles()
+{
+    Tick current_time = m_switch->clockEdge();
+    for (; m_drain_cycles > 0 && m_drain_start < current_time;
+         m_drain_cycles--) {
+        int bw_remaining;
+        bool bw_saturated;
+        [[maybe_unused]] bool drained =
+            drainCycle(m_drain_start,
+                       nextIterationDirection(m_wakeups_wo_switch),
+                       m_units_remaining, bw_remaining, bw_saturated);
+        assert(drained && bw_saturated);
+
+        throttleStats.acc_link_utilization +=
+            1.0 - (double(bw_remaining) / double(getTotalLinkBandwidth()));
+        throttleStats.total_bw_sat_cy += 1;
+        m_drain_start += m_switch->clockPeriod();
     }
 }
 
@@ -329,8 +442,10 @@ network_message_to_size(Message *net_msg_ptr)
 }
 
 Throttle::
-ThrottleStats::ThrottleStats(Switch *parent, const NodeID &nodeID)
+ThrottleStats::ThrottleStats(Switch *parent, const NodeID &nodeID,
+                             Throttle &_throttle)
     : statistics::Group(parent, csprintf("throttle%02i", nodeID).c_str()),
+      throttle(_throttle),
       ADD_STAT(acc_link_utilization, statistics::units::Count::get(),
         "Accumulated link utilization"),
       ADD_STAT(link_utilization, statistics::units::Ratio::get(),
@@ -390,5 +505,21 @@ ThrottleStats::ThrottleStats(Switch *parent, const NodeID &nodeID)
     }
 }
 
+void
+Throttle::ThrottleStats::preDumpStats()
+{
+    // The cycles skipped so far belong to the window being dumped
+    throttle.replayDrainCycles();
+    statistics::Group::preDumpStats();
+}
+
+void
+Throttle::ThrottleStats::resetStats()
+{
+    // Skipped cycles before the reset must not land in the next window
+    throttle.replayDrainCycles();
+    statistics::Group::resetStats();
+}
+
 } // namespace ruby
 } // namespace gem5
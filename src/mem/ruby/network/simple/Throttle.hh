@@ -112,6 +112,17 @@ class Throttle : public Consumer
                      bool &bw_saturated, bool &output_blocked,
                      MessageBuffer *in, MessageBuffer *out);
 
+    // Event skipping: while the link only carries the rest of messages
+    // it has already sent, the throttle does not wake up every cycle.
+    // These cycles are replayed, with their stats, at the next wakeup,
+    // or up to the current cycle when stats are dumped or reset.
+    bool drainCycle(Tick time, bool iteration_direction,
+                    std::vector<std::vector<int>> &units_remaining,
+                    int &bw_remaining, bool &bw_saturated) const;
+    int countDrainCycles();
+    void replayDrainCycles();
+    bool nextIterationDirection(int &wakeups_wo_switch) const;
+
     // Private copy constructor and assignment operator
     Throttle(const Throttle& obj);
     Throttle& operator=(const Throttle& obj);
@@ -130,12 +141,21 @@ class Throttle : public Consumer
     std::vector<int> m_vnet_channels;
     Cycles m_link_latency;
     int m_wakeups_wo_switch;
+    // cycles from m_drain_start on that are left to replay
+    Tick m_drain_start;
+    int m_drain_cycles;
     int m_endpoint_bandwidth;
     RubySystem *m_ruby_system;
 
     struct ThrottleStats : public statistics::Group
     {
-        ThrottleStats(Switch *parent, const NodeID &nodeID);
+        ThrottleStats(Switch *parent, const NodeID &nodeID,
+                      Throttle &throttle);
+
+        void preDumpStats() override;
+        void resetStats() override;
+
+        Throttle &throttle;
 
         // Statistical variables
         statistics::Scalar acc_link_utilization;
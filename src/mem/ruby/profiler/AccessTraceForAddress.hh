@@ -61,6 +61,8 @@ class AccessTraceForAddress
     int getTouchedBy() const { return m_touched_by.count(); }
     Addr getAddress() const { return m_addr; }
     void addSample(int value);
+    // A miss to the address that needed other caches
+    void addSharing() { m_sharing++; }
 
     void print(std::ostream& out) const;
 
@@ -137,6 +137,7 @@ printSorted(std::ostream& out, int num_of_sequencers,
         remaining_records_log.add(record->getTotal());
         m_touched_vec[record->getTouchedBy()]++;
         m_touched_weighted_vec[record->getTouchedBy()] += record->getTotal();
+        counter++;
     }
     out << std::endl;
     out << "all_records_" << description << ": "
@@ -154,8 +155,54 @@ printSorted(std::ostream& out, int num_of_sequencers,
         << std::endl;
 }
 
+// Prints the keys tracked by a sketch, the most frequent first, with the
+// estimate of their weight (and the over-estimation it may have) followed
+// by their record
+template<class RECORD>
+static void
+printTopK(std::ostream& out, const HeavyHitters<RECORD> &sketch,
+          std::string description, std::string columns)
+{
+    uint64_t total = sketch.total();
+    std::vector<const typename HeavyHitters<RECORD>::Entry *> sorted =
+        sketch.sorted();
+
+    out << "Tracked_entries_" << description << ": " << sorted.size()
+        << std::endl;
+    out << "Total_" << description << ": " << total << std::endl;
+    out << "estimate error | " << columns << std::endl;
+
+    for (auto entry : sorted) {
+        double percent = 100.0 * (entry->count / double(total));
+        out << description << " | " << percent << " % " << entry->count
+            << " " << entry->error << " | " << entry->record << std::endl;
+    }
+    out << std::endl;
+}
+
+void
+LineTraffic::add(int vnet, int num_flits, uint64_t weight)
+{
+    messages += weight;
+    flits += weight * num_flits;
+    if (vnetFlits.size() <= (size_t)vnet) {
+        vnetFlits.resize(vnet + 1, 0);
+    }
+    vnetFlits[vnet] += weight * num_flits;
+}
+
+void
+LineTraffic::print(std::ostream& out) const
+{
+    out << addr << " " << messages << " " << flits << " |";
+    for (auto vnet_flits : vnetFlits) {
+        out << " " << vnet_flits;
+    }
+}
+
 AddressProfiler::AddressProfiler(int num_of_sequencers, Profiler *profiler)
-    : m_profiler(profiler)
+    : m_profiler(profiler), m_sketch(false), m_sample_period(1),
+      m_access_countdown(1), m_traffic_countdown(1)
 {
     m_num_of_sequencers = num_of_sequencers;
     clearStats();
@@ -177,20 +224,61 @@ AddressProfiler::setAllInstructions(bool all_instructions)
     m_all_instructions = all_instructions;
 }
 
+void
+AddressProfiler::setSketch(int tracked, int sample_period)
+{
+    m_sketch = true;
+    m_sample_period = sample_period;
+    m_hot_blocks.reset(new HeavyHitters<AccessTraceForAddress>(tracked));
+    m_hot_pcs.reset(new HeavyHitters<AccessTraceForAddress>(tracked));
+    m_hot_traffic.reset(new HeavyHitters<LineTraffic>(tracked));
+}
+
 void
 AddressProfiler::printStats(std::ostream& out) const
 {
+    const std::string trace_columns = "total | load store atomic | "
+        "user supervisor | sharing | touched-by (of the sampled accesses "
+        "since tracked)";
+
+    if (m_sketch) {
+        if (m_hot_lines) {
+            out << std::endl;
+            out << "AddressProfiler Stats (sketches, sample period "
+                << m_sample_period << ")" << std::endl;
+            out << "---------------------" << std::endl;
+
+            printSharing(out);
+
+            out << std::endl;
+            out << "Hot Data Blocks" << std::endl;
+            out << "---------------" << std::endl;
+            out << std::endl;
+            printTopK(out, *m_hot_blocks, "block_address", trace_columns);
+
+            out << "Hot Network Blocks" << std::endl;
+            out << "------------------" << std::endl;
+            out << std::endl;
+            printTopK(out, *m_hot_traffic, "network_flits",
+                      "address messages flits | flits per vnet (since "
+                      "tracked)");
+        }
+
+        if (m_hot_lines || m_all_instructions) {
+            out << "Hot Instructions" << std::endl;
+            out << "----------------" << std::endl;
+            out << std::endl;
+            printTopK(out, *m_hot_pcs, "pc_address", trace_columns);
+        }
+        return;
+    }
+
     if (m_hot_lines) {
         out << std::endl;
         out << "AddressProfiler Stats" << std::endl;
         out << "---------------------" << std::endl;
 
-        out << std::endl;
-        out << "sharing_misses: " << m_sharing_miss_counter << std::endl;
-        out << "getx_sharing_histogram: " << m_getx_sharing_histogram
-            << std::endl;
-        out << "gets_sharing_histogram: " << m_gets_sharing_histogram
-            << std::endl;
+        printSharing(out);
 
         out << std::endl;
         out << "Hot Data Blocks" << std::endl;
@@ -244,6 +332,24 @@ AddressProfiler::printStats(std::ostream& out) const
     }
 }
 
+void
+AddressProfiler::printSharing(std::ostream& out) const
+{
+    // Only the protocols that profile their GETX and GETS at the point of
+    // coherence report the sharing of their misses
+    if (m_getx_sharing_histogram.size() == 0 &&
+        m_gets_sharing_histogram.size() == 0) {
+        return;
+    }
+
+    out << std::endl;
+    out << "sharing_misses: " << m_sharing_miss_counter << std::endl;
+    out << "getx_sharing_histogram: " << m_getx_sharing_histogram
+        << std::endl;
+    out << "gets_sharing_histogram: " << m_gets_sharing_histogram
+        << std::endl;
+}
+
 void
 AddressProfiler::clearStats()
 {
@@ -258,6 +364,11 @@ AddressProfiler::clearStats()
     m_retryProfileHistoWrite.clear();
     m_getx_sharing_histogram.clear();
     m_gets_sharing_histogram.clear();
+    if (m_sketch) {
+        m_hot_blocks->clear();
+        m_hot_pcs->clear();
+        m_hot_traffic->clear();
+    }
 }
 
 void
@@ -272,10 +383,9 @@ AddressProfiler::profileGetX(Addr datablock, Addr PC,
     int num_indirections = indirection_set.count();
 
     m_getx_sharing_histogram.add(num_indirections);
-    bool indirection_miss = (num_indirections > 0);
-
-    addTraceSample(datablock, PC, RubyRequestType_ST, RubyAccessMode(0),
-                   requestor, indirection_miss);
+    if (num_indirections > 0) {
+        profileSharingMiss(datablock);
+    }
 }
 
 void
@@ -289,10 +399,27 @@ AddressProfiler::profileGetS(Addr datablock, Addr PC,
     int num_indirections = indirection_set.count();
 
     m_gets_sharing_histogram.add(num_indirections);
-    bool indirection_miss = (num_indirections > 0);
+    if (num_indirections > 0) {
+        profileSharingMiss(datablock);
+    }
+}
 
-    addTraceSample(datablock, PC, RubyRequestType_LD, RubyAccessMode(0),
-                   requestor, indirection_miss);
+void
+AddressProfiler::profileSharingMiss(Addr datablock)
+{
+    m_sharing_miss_counter++;
+
+    // The access itself is sampled by the sequencer; only the sharing is
+    // added to the record of the block
+    datablock = makeLineAddress(datablock);
+    if (m_sketch) {
+        AccessTraceForAddress *trace = m_hot_blocks->find(datablock);
+        if (trace) {
+            trace->addSharing();
+        }
+    } else {
+        lookupTraceForAddress(datablock, m_dataAccessTrace).addSharing();
+    }
 }
 
 void
@@ -301,7 +428,36 @@ AddressProfiler::addTraceSample(Addr data_addr, Addr pc_addr,
                                 RubyAccessMode access_mode, NodeID id,
                                 bool sharing_miss)
 {
-    if (m_all_instructions) {
+    if (m_sketch) {
+        if (m_hot_lines && sharing_miss) {
+            m_sharing_miss_counter++;
+        }
+        if (--m_access_countdown > 0) {
+            return;
+        }
+        m_access_countdown = m_sample_period;
+
+        if (m_hot_lines) {
+            data_addr = makeLineAddress(data_addr);
+            AccessTraceForAddress *trace =
+                m_hot_blocks->sample(data_addr, m_sample_period);
+            if (trace) {
+                trace->setAddress(data_addr);
+                trace->update(type, access_mode, id, sharing_miss);
+            }
+        }
+        if (m_hot_lines || m_all_instructions) {
+            AccessTraceForAddress *trace =
+                m_hot_pcs->sample(pc_addr, m_sample_period);
+            if (trace) {
+                trace->setAddress(pc_addr);
+                trace->update(type, access_mode, id, sharing_miss);
+            }
+        }
+        return;
+    }
+
+    if (m_hot_lines) {
         if (sharing_miss) {
             m_sharing_miss_counter++;
         }
@@ -332,6 +488,22 @@ AddressProfiler::addTraceSample(Addr data_addr, Addr pc_addr,
     }
 }
 
+void
+AddressProfiler::profileTraffic(Addr line, int vnet, int flits)
+{
+    if (!m_sketch || --m_traffic_countdown > 0) {
+        return;
+    }
+    m_traffic_countdown = m_sample_period;
+
+    LineTraffic *traffic =
+        m_hot_traffic->sample(line, m_sample_period * flits);
+    if (traffic) {
+        traffic->addr = line;
+        traffic->add(vnet, flits, m_sample_period);
+    }
+}
+
 void
 AddressProfiler::profileRetry(Addr data_addr, AccessType type, int count)
 {
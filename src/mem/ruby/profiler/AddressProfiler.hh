@@ -30,11 +30,14 @@
 #define __MEM_RUBY_PROFILER_ADDRESSPROFILER_HH__
 
 #include <iostream>
+#include <memory>
 #include <unordered_map>
+#include <vector>
 
 #include "mem/ruby/common/Address.hh"
 #include "mem/ruby/common/Histogram.hh"
 #include "mem/ruby/profiler/AccessTraceForAddress.hh"
+#include "mem/ruby/profiler/HeavyHitters.hh"
 #include "mem/ruby/profiler/Profiler.hh"
 #include "mem/ruby/protocol/AccessType.hh"
 #include "mem/ruby/protocol/RubyRequest.hh"
@@ -47,6 +50,25 @@ namespace ruby
 
 class Set;
 
+// Network traffic of a line, in the hot lines sketches
+struct LineTraffic
+{
+    Addr addr = 0;
+    uint64_t messages = 0;
+    uint64_t flits = 0;
+    std::vector<uint64_t> vnetFlits;
+
+    void add(int vnet, int num_flits, uint64_t weight);
+    void print(std::ostream& out) const;
+};
+
+inline std::ostream&
+operator<<(std::ostream& out, const LineTraffic& obj)
+{
+    obj.print(out);
+    return out;
+}
+
 class AddressProfiler
 {
   public:
@@ -73,6 +95,12 @@ class AddressProfiler
     //added by SS
     void setHotLines(bool hot_lines);
     void setAllInstructions(bool all_instructions);
+    // Profiles the hot lines and PCs, and the network traffic of the
+    // lines, in sketches tracking the tracked most frequent of each,
+    // sampling one in sample_period accesses and messages, instead of
+    // keeping a record of every address
+    void setSketch(int tracked, int sample_period);
+    void profileTraffic(Addr line, int vnet, int flits);
     void regStats(const std::string &name) {}
     void collateStats() {}
 
@@ -81,6 +109,9 @@ class AddressProfiler
     AddressProfiler(const AddressProfiler& obj);
     AddressProfiler& operator=(const AddressProfiler& obj);
 
+    void profileSharingMiss(Addr datablock);
+    void printSharing(std::ostream& out) const;
+
     int64_t m_sharing_miss_counter;
 
     AddressMap m_dataAccessTrace;
@@ -99,6 +130,14 @@ class AddressProfiler
     bool m_hot_lines;
     bool m_all_instructions;
 
+    bool m_sketch;
+    uint64_t m_sample_period;
+    uint64_t m_access_countdown;
+    uint64_t m_traffic_countdown;
+    std::unique_ptr<HeavyHitters<AccessTraceForAddress>> m_hot_blocks;
+    std::unique_ptr<HeavyHitters<AccessTraceForAddress>> m_hot_pcs;
+    std::unique_ptr<HeavyHitters<LineTraffic>> m_hot_traffic;
+
     int m_num_of_sequencers;
 };
 
@@ -0,0 +1,240 @@
+/*
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __MEM_RUBY_PROFILER_HEAVYHITTERS_HH__
+#define __MEM_RUBY_PROFILER_HEAVYHITTERS_HH__
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "base/intmath.hh"
+#include "mem/ruby/common/Address.hh"
+#include "mem/ruby/common/FlatAddressMap.hh"
+
+namespace gem5
+{
+
+namespace ruby
+{
+
+/*
+ * The most frequent keys (lines, PCs) of a stream, in memory bounded by
+ * the number of keys tracked. Every sample is counted in a Count-Min
+ * sketch, which over-estimates the count of any key. The tracked keys are
+ * kept as in Space-Saving: a key that is not tracked replaces the tracked
+ * key of the lowest count once its estimate exceeds that count, and its
+ * count starts from the estimate. A RECORD (default constructed when a key
+ * starts being tracked) holds what is profiled about each tracked key,
+ * since it started being tracked.
+ */
+template<class RECORD>
+class HeavyHitters
+{
+  public:
+    struct Entry
+    {
+        Addr key;
+        // Upper bound of the weight of the key, which over-estimates it
+        // by at most error
+        uint64_t count;
+        uint64_t error;
+        RECORD record;
+    };
+
+    HeavyHitters(int tracked)
+        : m_tracked(tracked), m_index(tracked),
+          m_width_bits(ceilLog2(tracked * 8)),
+          m_sketch(sketchDepth << m_width_bits, 0), m_total(0)
+    {
+        assert(tracked > 0);
+        m_entries.reserve(tracked);
+        m_heap.reserve(tracked);
+    }
+
+    // Counts weight for key and returns its record if key is tracked,
+    // nullptr if not
+    RECORD *
+    sample(Addr key, uint64_t weight)
+    {
+        m_total += weight;
+        uint64_t estimate = addToSketch(key, weight);
+
+        auto it = m_index.find(key);
+        if (it != m_index.end()) {
+            int slot = it->second;
+            m_entries[slot].count += weight;
+            siftDown(m_heap_pos[slot]);
+            return &m_entries[slot].record;
+        }
+
+        int slot;
+        if (m_entries.size() < m_tracked) {
+            slot = m_entries.size();
+            m_entries.push_back(Entry());
+            m_heap.push_back(slot);
+            m_heap_pos.push_back(m_heap.size() - 1);
+        } else if (estimate > m_entries[m_heap[0]].count) {
+            slot = m_heap[0];
+            m_index.erase(m_entries[slot].key);
+            m_entries[slot].record = RECORD();
+        } else {
+            return nullptr;
+        }
+
+        Entry &entry = m_entries[slot];
+        entry.key = key;
+        entry.count = estimate;
+        entry.error = estimate - weight;
+        m_index.emplace(key, slot);
+        siftUp(m_heap_pos[slot]);
+        siftDown(m_heap_pos[slot]);
+        return &entry.record;
+    }
+
+    // The record of key if it is tracked, nullptr if not, without
+    // sampling it
+    RECORD *
+    find(Addr key)
+    {
+        auto it = m_index.find(key);
+        return it == m_index.end() ? nullptr : &m_entries[it->second].record;
+    }
+
+    // The tracked keys, the most frequent first
+    std::vector<const Entry *>
+    sorted() const
+    {
+        std::vector<const Entry *> entries;
+        for (auto &entry : m_entries)
+            entries.push_back(&entry);
+        std::sort(entries.begin(), entries.end(),
+                  [](const Entry *a, const Entry *b)
+                  { return a->count > b->count; });
+        return entries;
+    }
+
+    // The weight of all the samples
+    uint64_t total() const { return m_total; }
+
+    void
+    clear()
+    {
+        m_index.clear();
+        m_entries.clear();
+        m_heap.clear();
+        m_heap_pos.clear();
+        std::fill(m_sketch.begin(), m_sketch.end(), 0);
+        m_total = 0;
+    }
+
+  private:
+    static const int sketchDepth = 4;
+
+    // Adds weight to the counters of key and returns the estimate of its
+    // count, the lowest of them
+    uint64_t
+    addToSketch(Addr key, uint64_t weight)
+    {
+        // Odd multipliers for multiply-shift hashing, one per row
+        static const uint64_t seeds[sketchDepth] = {
+            0x9e3779b97f4a7c15ULL, 0xc2b2ae3d27d4eb4fULL,
+            0x165667b19e3779f9ULL, 0xd6e8feb86659fd93ULL,
+        };
+
+        uint64_t estimate = UINT64_MAX;
+        for (int row = 0; row < sketchDepth; row++) {
+            uint64_t column = (key * seeds[row]) >> (64 - m_width_bits);
+            uint64_t &counter = m_sketch[(row << m_width_bits) + column];
+            counter += weight;
+            estimate = std::min(estimate, counter);
+        }
+        return estimate;
+    }
+
+    // The heap of the slots keeps the tracked key of the lowest count at
+    // its root
+    bool
+    lower(int a, int b) const
+    {
+        return m_entries[m_heap[a]].count < m_entries[m_heap[b]].count;
+    }
+
+    void
+    swapHeap(int a, int b)
+    {
+        std::swap(m_heap[a], m_heap[b]);
+        m_heap_pos[m_heap[a]] = a;
+        m_heap_pos[m_heap[b]] = b;
+    }
+
+    void
+    siftUp(int pos)
+    {
+        while (pos > 0 && lower(pos, (pos - 1) / 2)) {
+            swapHeap(pos, (pos - 1) / 2);
+            pos = (pos - 1) / 2;
+        }
+    }
+
+    void
+    siftDown(int pos)
+    {
+        int size = m_heap.size();
+        while (true) {
+            int lowest = pos;
+            for (int child = 2 * pos + 1; child <= 2 * pos + 2; child++) {
+                if (child < size && lower(child, lowest))
+                    lowest = child;
+            }
+            if (lowest == pos)
+                return;
+            swapHeap(pos, lowest);
+            pos = lowest;
+        }
+    }
+
+    const size_t m_tracked;
+
+    // Slot of each tracked key
+    FlatAddressMap<int> m_index;
+    std::vector<Entry> m_entries;
+    std::vector<int> m_heap;
+    std::vector<int> m_heap_pos;
+
+    // Count-Min sketch of sketchDepth rows of 2^m_width_bits counters
+    const int m_width_bits;
+    std::vector<uint64_t> m_sketch;
+    uint64_t m_total;
+};
+
+} // namespace ruby
+} // namespace gem5
+
+#endif // __MEM_RUBY_PROFILER_HEAVYHITTERS_HH__
@@ -0,0 +1,211 @@
+/*
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <random>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "mem/ruby/profiler/HeavyHitters.hh"
+
+using namespace gem5;
+using namespace gem5::ruby;
+
+namespace
+{
+
+// What the tests profile about a key: its samples while tracked
+struct Record
+{
+    uint64_t samples = 0;
+};
+
+// A Zipf-distributed stream of line addresses: the line of rank r is
+// sampled with a probability proportional to 1 / r^skew
+class SkewedStream
+{
+  public:
+    SkewedStream(int lines, double skew, unsigned seed)
+        : m_rng(seed)
+    {
+        std::vector<double> weights;
+        for (int rank = 1; rank <= lines; rank++)
+            weights.push_back(1.0 / std::pow(rank, skew));
+        m_dist = std::discrete_distribution<int>(weights.begin(),
+                                                 weights.end());
+    }
+
+    // Spread the ranks over the address space
+    Addr next() { return Addr(m_dist(m_rng) * 7919 + 13) << 6; }
+
+  private:
+    std::mt19937 m_rng;
+    std::discrete_distribution<int> m_dist;
+};
+
+// The exact counts of a stream, and its keys the most frequent first
+struct Exact
+{
+    std::map<Addr, uint64_t> counts;
+
+    std::vector<Addr>
+    top(size_t k) const
+    {
+        std::vector<std::pair<uint64_t, Addr>> by_count;
+        for (const auto &entry : counts)
+            by_count.emplace_back(entry.second, entry.first);
+        std::sort(by_count.rbegin(), by_count.rend());
+        std::vector<Addr> keys;
+        for (size_t i = 0; i < k && i < by_count.size(); i++)
+            keys.push_back(by_count[i].second);
+        return keys;
+    }
+};
+
+} // anonymous namespace
+
+/**
+ * On a skewed stream, the most frequent keys are all tracked, the
+ * tracked keys come out most frequent first, and the count of each is
+ * an upper bound of its weight with count - error a lower bound.
+ */
+TEST(HeavyHittersTest, SkewedStream)
+{
+    const int tracked = 32;
+    const int top_k = 10;
+
+    HeavyHitters<Record> hh(tracked);
+    SkewedStream stream(50000, 1.1, 1);
+    Exact exact;
+    for (int i = 0; i < 300000; i++) {
+        Addr key = stream.next();
+        exact.counts[key]++;
+        if (Record *record = hh.sample(key, 1))
+            record->samples++;
+    }
+    EXPECT_EQ(hh.total(), 300000);
+
+    auto entries = hh.sorted();
+    ASSERT_EQ(entries.size(), tracked);
+
+    std::set<Addr> found;
+    for (size_t i = 0; i < entries.size(); i++) {
+        const auto *entry = entries[i];
+        uint64_t weight = exact.counts[entry->key];
+        EXPECT_GE(entry->count, weight);
+        EXPECT_LE(entry->count - entry->error, weight);
+        EXPECT_LE(entry->record.samples, weight);
+        if (i > 0) {
+            EXPECT_LE(entry->count, entries[i - 1]->count);
+        }
+        found.insert(entry->key);
+    }
+
+    // Top-K recall
+    int recalled = 0;
+    for (Addr key : exact.top(top_k))
+        recalled += found.count(key);
+    EXPECT_EQ(recalled, top_k);
+
+    // The hottest key is tracked from its first samples on
+    const auto *hottest = entries.front();
+    EXPECT_EQ(hottest->key, exact.top(1).front());
+    EXPECT_GE(hottest->record.samples,
+              exact.counts[hottest->key] - hottest->error);
+}
+
+/** Weighted samples count their weight; find does not sample. */
+TEST(HeavyHittersTest, Weights)
+{
+    HeavyHitters<Record> hh(4);
+    hh.sample(0x40, 10);
+    hh.sample(0x80, 1);
+    hh.sample(0x40, 5);
+    EXPECT_EQ(hh.total(), 16);
+
+    auto entries = hh.sorted();
+    ASSERT_EQ(entries.size(), 2);
+    EXPECT_EQ(entries[0]->key, 0x40);
+    EXPECT_GE(entries[0]->count, 15);
+    EXPECT_LE(entries[0]->count - entries[0]->error, 15);
+    EXPECT_EQ(entries[0]->record.samples, 0);
+
+    // find returns the record of a tracked key without sampling it
+    EXPECT_EQ(hh.find(0x40), &entries[0]->record);
+    EXPECT_EQ(hh.find(0xc0), nullptr);
+    EXPECT_EQ(hh.total(), 16);
+}
+
+/**
+ * With more distinct keys than tracked, a new key only replaces the
+ * least frequent tracked key once its estimate is larger.
+ */
+TEST(HeavyHittersTest, Replacement)
+{
+    HeavyHitters<Record> hh(2);
+    for (int i = 0; i < 100; i++) {
+        hh.sample(0x1000, 1);
+        hh.sample(0x2000, 1);
+    }
+
+    // A single sample of a new key is not enough
+    EXPECT_EQ(hh.sample(0x3000, 1), nullptr);
+
+    for (int i = 0; i < 300; i++)
+        hh.sample(0x3000, 1);
+    std::set<Addr> keys;
+    for (const auto *entry : hh.sorted())
+        keys.insert(entry->key);
+    EXPECT_EQ(keys.count(0x3000), 1);
+    EXPECT_EQ(keys.size(), 2);
+}
+
+/** clear forgets every key and sample. */
+TEST(HeavyHittersTest, Clear)
+{
+    HeavyHitters<Record> hh(8);
+    for (int i = 0; i < 100; i++)
+        hh.sample(Addr(i % 20) << 6, 1);
+    EXPECT_FALSE(hh.sorted().empty());
+
+    hh.clear();
+    EXPECT_TRUE(hh.sorted().empty());
+    EXPECT_EQ(hh.total(), 0);
+
+    // No estimate survives the clear
+    hh.sample(0x40, 1);
+    auto entries = hh.sorted();
+    ASSERT_EQ(entries.size(), 1);
+    EXPECT_EQ(entries[0]->count, 1);
+    EXPECT_EQ(entries[0]->error, 0);
+}
@@ -53,10 +53,13 @@
 #include "base/stl_helpers.hh"
 #include "base/str.hh"
 #include "config/build_gpu.hh"
+#include "mem/ruby/common/NetDest.hh"
+#include "mem/ruby/common/Set.hh"
 #include "mem/ruby/network/Network.hh"
 #include "mem/ruby/profiler/AddressProfiler.hh"
 #include "mem/ruby/protocol/MachineType.hh"
 #include "mem/ruby/protocol/RubyRequest.hh"
+#include "mem/ruby/slicc_interface/Message.hh"
 
 /**
  * the profiler uses GPUCoalescer code even
@@ -87,20 +90,41 @@ namespace ruby
 using stl_helpers::operator<<;
 
 Profiler::Profiler(const RubySystemParams &p, RubySystem *rs)
-    : m_ruby_system(rs), m_hot_lines(p.hot_lines),
+    : m_ruby_system(rs), m_hot_lines_file(p.hot_lines_file),
+      m_hot_lines_stream(nullptr), m_hot_lines(p.hot_lines),
       m_all_instructions(p.all_instructions),
       m_num_vnets(p.number_of_virtual_networks),
       rubyProfilerStats(rs, this)
 {
+    // The sequencers that touched a line are kept in a Set
+    fatal_if((m_hot_lines || m_all_instructions) &&
+             p.num_of_sequencers > NUMBER_BITS_PER_SET,
+             "Profiling hot lines of %d sequencers needs "
+             "NUMBER_BITS_PER_SET of at least as many",
+             p.num_of_sequencers);
+    fatal_if(p.hot_lines_sketch &&
+             (p.hot_lines_tracked == 0 || p.hot_lines_sample_period == 0),
+             "hot_lines_tracked and hot_lines_sample_period must be "
+             "positive");
+
     m_address_profiler_ptr = new AddressProfiler(p.num_of_sequencers, this);
     m_address_profiler_ptr->setHotLines(m_hot_lines);
     m_address_profiler_ptr->setAllInstructions(m_all_instructions);
+    if (p.hot_lines_sketch) {
+        m_address_profiler_ptr->setSketch(p.hot_lines_tracked,
+                                          p.hot_lines_sample_period);
+    }
 
     if (m_all_instructions) {
         m_inst_profiler_ptr = new AddressProfiler(p.num_of_sequencers, this);
         m_inst_profiler_ptr->setHotLines(m_hot_lines);
         m_inst_profiler_ptr->setAllInstructions(m_all_instructions);
     }
+
+    if (m_hot_lines || m_all_instructions) {
+        statistics::registerDumpCallback([this]() { dumpHotLines(); });
+        statistics::registerResetCallback([this]() { resetHotLines(); });
+    }
 }
 
 Profiler::~Profiler()
@@ -584,5 +608,61 @@ Profiler::addAddressTraceSample(const RubyRequest& msg, NodeID id)
     }
 }
 
+void
+Profiler::profileLineTraffic(const Message& msg, int vnet, int flits)
+{
+    Addr line;
+    if (m_hot_lines && msg.getFunctionalLine(line)) {
+        m_address_profiler_ptr->profileTraffic(line, vnet, flits);
+    }
+}
+
+void
+Profiler::profileSharing(Addr line, bool exclusive, const NetDest& holders,
+                         MachineID requestor)
+{
+    if (!m_hot_lines) {
+        return;
+    }
+
+    // The holders of the requestor's type (e.g. the L1 caches), by number
+    Set holder_set;
+    for (NodeID num = 0; num < MachineType_base_count(requestor.type);
+         num++) {
+        if (holders.isElement(MachineID(requestor.type, num))) {
+            holder_set.add(num);
+        }
+    }
+
+    if (exclusive) {
+        m_address_profiler_ptr->profileGetX(line, 0, Set(), holder_set,
+                                            requestor.num);
+    } else {
+        m_address_profiler_ptr->profileGetS(line, 0, holder_set, Set(),
+                                            requestor.num);
+    }
+}
+
+void
+Profiler::resetHotLines()
+{
+    m_address_profiler_ptr->clearStats();
+    if (m_all_instructions) {
+        m_inst_profiler_ptr->clearStats();
+    }
+}
+
+void
+Profiler::dumpHotLines()
+{
+    if (m_hot_lines_stream == nullptr) {
+        m_hot_lines_stream = simout.create(m_hot_lines_file);
+    }
+    std::ostream &os = *m_hot_lines_stream->stream();
+    os << "Hot lines at tick " << curTick() << std::endl;
+    m_address_profiler_ptr->printStats(os);
+    os << std::endl;
+}
+
 } // namespace ruby
 } // namespace gem5
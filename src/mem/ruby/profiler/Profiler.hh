@@ -51,6 +51,7 @@
 #include <vector>
 
 #include "base/callback.hh"
+#include "base/output.hh"
 #include "base/statistics.hh"
 #include "mem/ruby/common/MachineID.hh"
 #include "mem/ruby/protocol/AccessType.hh"
@@ -66,6 +67,8 @@ namespace ruby
 {
 
 class RubyRequest;
+class Message;
+class NetDest;
 class AddressProfiler;
 
 class Profiler
@@ -84,6 +87,14 @@ class Profiler
     AddressProfiler* getInstructionProfiler() { return m_inst_profiler_ptr; }
 
     void addAddressTraceSample(const RubyRequest& msg, NodeID id);
+    // A message of flits injected into vnet of a network, for the network
+    // traffic of the hot lines
+    void profileLineTraffic(const Message& msg, int vnet, int flits);
+    // A GETX (exclusive) or GETS miss of requestor to line at the point
+    // of coherence, where holders are the caches other than requestor
+    // that hold it for a GETX, or own it for a GETS
+    void profileSharing(Addr line, bool exclusive, const NetDest& holders,
+                        MachineID requestor);
 
     // added by SS
     bool getHotLines() const { return m_hot_lines; }
@@ -97,6 +108,14 @@ class Profiler
     AddressProfiler* m_address_profiler_ptr;
     AddressProfiler* m_inst_profiler_ptr;
 
+    // Writes the address profiles to the hot lines file
+    void dumpHotLines();
+    // Clears them with the other stats, e.g. at the end of the warmup
+    void resetHotLines();
+
+    std::string m_hot_lines_file;
+    OutputStream *m_hot_lines_stream;
+
     struct ProfilerStats : public statistics::Group
     {
         ProfilerStats(statistics::Group *parent, Profiler *profiler);
@@ -147,6 +147,15 @@ AbstractController::profileMsgDelay(uint32_t virtualNetwork, Cycles delay)
     stats.delayVCHistogram[virtualNetwork]->sample(delay);
 }
 
+void
+AbstractController::profileSharing(Addr addr, bool exclusive,
+                                   const NetDest &holders,
+                                   MachineID requestor)
+{
+    params().ruby_system->getProfiler()->
+        profileSharing(makeLineAddress(addr), exclusive, holders, requestor);
+}
+
 void
 AbstractController::stallBuffer(MessageBuffer* buf, Addr addr)
 {
@@ -381,7 +390,7 @@ AbstractController::recvTimingResp(PacketPtr pkt)
     assert(getMemRespQueue());
     assert(pkt->isResponse());
 
-    std::shared_ptr<MemoryMsg> msg = std::make_shared<MemoryMsg>(clockEdge());
+    RefCountingPtr<MemoryMsg> msg = new MemoryMsg(clockEdge());
     (*msg).m_addr = pkt->getAddr();
     (*msg).m_Sender = m_machineID;
 
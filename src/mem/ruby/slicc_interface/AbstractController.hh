@@ -71,6 +71,8 @@ namespace ruby
 class Network;
 class GPUCoalescer;
 class DMASequencer;
+class CacheSnapshot;
+class CacheSnapshotWriter;
 
 // used to communicate that an in_port peeked the wrong message type
 class RejectException: public std::exception
@@ -108,6 +110,10 @@ class AbstractController : public ClockedObject, public Consumer
     virtual void regStats();
 
     virtual void recordCacheTrace(int cntrl, CacheRecorder* tr) = 0;
+    // Save/load the contents of the caches and directories of the
+    // controller to/from a cache snapshot
+    virtual void saveCacheSnapshot(CacheSnapshotWriter &snap) = 0;
+    virtual void loadCacheSnapshot(CacheSnapshot &snap) = 0;
     virtual Sequencer* getCPUSequencer() const = 0;
     virtual DMASequencer* getDMASequencer() const = 0;
     virtual GPUCoalescer* getGPUCoalescer() const = 0;
@@ -133,6 +139,9 @@ class AbstractController : public ClockedObject, public Consumer
     { panic("functionalRead(Addr,PacketPtr,WriteMask) not implemented"); }
 
     void functionalMemoryRead(PacketPtr);
+    //! Whether the memory behind this controller holds addr.
+    bool hasMemoryFor(Addr addr)
+    { return memoryPort.isConnected() && respondsTo(addr); }
     //! The return value indicates the number of messages written with the
     //! data from the packet.
     virtual int functionalWriteBuffers(PacketPtr&) = 0;
@@ -225,6 +234,10 @@ class AbstractController : public ClockedObject, public Consumer
     void profileRequest(const std::string &request);
     //! Profiles the delay associated with messages.
     void profileMsgDelay(uint32_t virtualNetwork, Cycles delay);
+    //! Profiles the sharing of a GETX or GETS miss at the point of
+    //! coherence, for the hot lines profile.
+    void profileSharing(Addr addr, bool exclusive, const NetDest &holders,
+                        MachineID requestor);
 
     // Tracks outstanding transactions for latency profiling
     struct TransMapPair { unsigned transaction; unsigned state; Tick time; };
@@ -360,6 +373,10 @@ class AbstractController : public ClockedObject, public Consumer
     typedef std::map<Addr, MsgVecType* > WaitingBufType;
     WaitingBufType m_waiting_buffers;
 
+    // The messages held in the buffers of the controller, by line, which
+    // functionalReadBuffers and functionalWriteBuffers search
+    MessageIndex m_buffered_msgs;
+
     unsigned int m_in_ports;
     unsigned int m_cur_in_port;
     const int m_number_of_TBEs;
@@ -42,13 +42,14 @@
 #define __MEM_RUBY_SLICC_INTERFACE_MESSAGE_HH__
 
 #include <iostream>
-#include <memory>
 #include <stack>
 
+#include "base/refcnt.hh"
 #include "mem/packet.hh"
 #include "mem/ruby/common/NetDest.hh"
 #include "mem/ruby/common/WriteMask.hh"
 #include "mem/ruby/protocol/MessageSizeType.hh"
+#include "mem/ruby/slicc_interface/ObjectPool.hh"
 
 namespace gem5
 {
@@ -56,8 +57,12 @@ namespace gem5
 namespace ruby
 {
 
+class DataBlock;
+
 class Message;
-typedef std::shared_ptr<Message> MsgPtr;
+// Messages are reference counted intrusively and without atomics: Ruby
+// runs in a single thread
+typedef RefCountingPtr<Message> MsgPtr;
 
 class Message
 {
@@ -72,6 +77,16 @@ class Message
 
     virtual ~Message() { }
 
+    // Reference counting for MsgPtr
+    void incref() const { ++m_ref_count.count; }
+
+    void
+    decref() const
+    {
+        if (--m_ref_count.count <= 0)
+            delete this;
+    }
+
     virtual MsgPtr clone() const = 0;
     virtual void print(std::ostream& out) const = 0;
 
@@ -94,6 +109,13 @@ class Message
     virtual bool functionalWrite(Packet *pkt)
     { panic("functionalWrite(Packet) not implemented"); }
 
+    /**
+     * The line that functional accesses to the message can match, used to
+     * index buffered messages by address (see MessageIndex). Messages
+     * that do not hold a single line return false.
+     */
+    virtual bool getFunctionalLine(Addr &line) const { return false; }
+
     //! Update the delay this message has experienced so far.
     void updateDelayedTicks(Tick curTime)
     {
@@ -119,6 +141,10 @@ class Message
     virtual NetDest& getDestination()
     { panic("getDestination() called on wrong message!"); }
 
+    // The data carried by the message, if any (e.g. for compression in
+    // the network)
+    virtual const DataBlock* getDataBlock() const { return nullptr; }
+
     int getIncomingLink() const { return incoming_link; }
     void setIncomingLink(int link) { incoming_link = link; }
     int getVnet() const { return vnet; }
@@ -163,6 +189,18 @@ class Message
     
 
   private:
+    // The number of MsgPtrs to the message, which a copy of the message
+    // does not inherit
+    struct RefCount
+    {
+        int count = 0;
+
+        RefCount() = default;
+        RefCount(const RefCount &) {}
+        RefCount &operator=(const RefCount &) { return *this; }
+    };
+    mutable RefCount m_ref_count;
+
     Tick m_time;
     Tick m_LastEnqueueTime; // my last enqueue time
     Tick m_DelayedTicks; // my delayed cycles
@@ -196,6 +234,16 @@ operator<<(std::ostream& out, const Message& obj)
     return out;
 }
 
+inline std::ostream&
+operator<<(std::ostream& out, const MsgPtr& obj)
+{
+    if (obj)
+        out << *obj;
+    else
+        out << "NULL";
+    return out;
+}
+
 } // namespace ruby
 } // namespace gem5
 
@@ -0,0 +1,123 @@
+/*
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __MEM_RUBY_SLICC_INTERFACE_OBJECTPOOL_HH__
+#define __MEM_RUBY_SLICC_INTERFACE_OBJECTPOOL_HH__
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace gem5
+{
+
+namespace ruby
+{
+
+/*
+ * Slab allocator for the objects of one type, used by the class-specific
+ * operator new/delete that SLICC generates for messages and for cache and
+ * directory entries. Objects are carved from slabs of SlabSize objects and
+ * freed ones are reused last-in first-out, so a steady stream of messages
+ * stops calling the general allocator and keeps reusing cache-warm memory,
+ * and long-lived entries are packed together without a per-object
+ * allocation header. Slabs are never released. Ruby runs in a single
+ * thread, so the pool is not synchronized.
+ */
+template<class T>
+class ObjectPool
+{
+  public:
+    static void *
+    allocate(std::size_t size)
+    {
+        // Objects of classes derived from T are not pooled
+        if (size != sizeof(T))
+            return ::operator new(size);
+
+        State &pool = state();
+        if (!pool.freeList)
+            pool.grow();
+        Slot *slot = pool.freeList;
+        pool.freeList = slot->next;
+        return slot;
+    }
+
+    static void
+    release(void *p, std::size_t size)
+    {
+        if (size != sizeof(T)) {
+            ::operator delete(p);
+            return;
+        }
+
+        State &pool = state();
+        Slot *slot = static_cast<Slot *>(p);
+        slot->next = pool.freeList;
+        pool.freeList = slot;
+    }
+
+  private:
+    static constexpr std::size_t SlabSize = 64;
+
+    union Slot
+    {
+        Slot *next;
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+
+    struct State
+    {
+        Slot *freeList = nullptr;
+        std::vector<std::unique_ptr<Slot[]>> slabs;
+
+        void
+        grow()
+        {
+            slabs.emplace_back(new Slot[SlabSize]);
+            Slot *slab = slabs.back().get();
+            for (std::size_t i = 0; i < SlabSize; i++) {
+                slab[i].next = freeList;
+                freeList = &slab[i];
+            }
+        }
+    };
+
+    // Never destroyed, as messages may outlive static destruction
+    static State &
+    state()
+    {
+        static State *pool = new State;
+        return *pool;
+    }
+};
+
+} // namespace ruby
+} // namespace gem5
+
+#endif // __MEM_RUBY_SLICC_INTERFACE_OBJECTPOOL_HH__
@@ -181,7 +181,19 @@ class RubyRequest : public Message
 
     RubyRequest(Tick curTime) : Message(curTime) {}
     MsgPtr clone() const
-    { return std::shared_ptr<Message>(new RubyRequest(*this)); }
+    { return MsgPtr(new RubyRequest(*this)); }
+
+    static void *
+    operator new(size_t size)
+    {
+        return ObjectPool<RubyRequest>::allocate(size);
+    }
+
+    static void
+    operator delete(void *p, size_t size)
+    {
+        ObjectPool<RubyRequest>::release(p, size);
+    }
 
     Addr getLineAddress() const { return m_LineAddress; }
     Addr getPhysicalAddress() const { return m_PhysicalAddress; }
@@ -196,6 +208,13 @@ class RubyRequest : public Message
     bool functionalRead(Packet *pkt);
     bool functionalRead(Packet *pkt, WriteMask &mask);
     bool functionalWrite(Packet *pkt);
+
+    bool
+    getFunctionalLine(Addr &line) const
+    {
+        line = makeLineAddress(m_PhysicalAddress);
+        return true;
+    }
 };
 
 inline std::ostream&
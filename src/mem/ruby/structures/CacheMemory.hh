@@ -126,6 +126,17 @@ class CacheMemory : public SimObject
     // Hook for checkpointing the contents of the cache
     void recordCacheContents(int cntrl, CacheRecorder* tr) const;
 
+    // Calls f(entry) for every valid entry, for the cache snapshots
+    template <typename F>
+    void
+    forEachEntry(F f) const
+    {
+        for (AbstractCacheEntry *entry : m_cache) {
+            if (entry != nullptr)
+                f(entry);
+        }
+    }
+
     // Set this address to most recently used
     void setMRU(Addr address);
     void setMRU(Addr addr, int occupancy);
@@ -168,6 +179,21 @@ class CacheMemory : public SimObject
     int findTagInSet(int64_t line, Addr tag) const;
     int findTagInSetIgnorePermissions(int64_t cacheSet, Addr tag) const;
 
+    AbstractCacheEntry *&
+    entryAt(int64_t cacheSet, int way)
+    {
+        return m_cache[cacheSet * m_cache_assoc + way];
+    }
+
+    AbstractCacheEntry *
+    entryAt(int64_t cacheSet, int way) const
+    {
+        return m_cache[cacheSet * m_cache_assoc + way];
+    }
+
+    // Sets the tag of a way, in the tag array and the tag index
+    void setTag(int64_t cacheSet, int way, Addr tag);
+
     // Private copy constructor and assignment operator
     CacheMemory(const CacheMemory& obj);
     CacheMemory& operator=(const CacheMemory& obj);
@@ -176,10 +202,18 @@ class CacheMemory : public SimObject
     // Data Members (m_prefix)
     bool m_is_instruction_only_cache;
 
-    // The first index is the # of cache lines.
-    // The second index is the the amount associativity.
+    // Tag store, indexed by set * assoc + way. The tags of a set are
+    // contiguous and all compared on a lookup; ways without an entry hold
+    // MaxAddr, which is never a line address. The entries themselves are
+    // allocated by the protocol, so m_cache holds pointers to them.
+    std::vector<Addr> m_tags;
+    std::vector<AbstractCacheEntry*> m_cache;
+
+    // Tag to way map, only kept for caches of at least TagIndexMinAssoc
+    // ways, for which a scan of the set is slower than a hash lookup
+    static constexpr int TagIndexMinAssoc = 64;
+    bool m_use_tag_index;
     std::unordered_map<Addr, int> m_tag_index;
-    std::vector<std::vector<AbstractCacheEntry*> > m_cache;
 
     /** We use the replacement policies from the Classic memory system. */
     replacement_policy::Base *m_replacementPolicy_ptr;
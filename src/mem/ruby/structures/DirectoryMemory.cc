@@ -70,20 +70,13 @@ void
 DirectoryMemory::init()
 {
     m_num_entries = m_size_bytes / RubySystem::getBlockSizeBytes();
-    m_entries = new AbstractCacheEntry*[m_num_entries];
-    for (int i = 0; i < m_num_entries; i++)
-        m_entries[i] = NULL;
+    m_pages.resize(divCeil(m_num_entries, PageSize));
 }
 
 DirectoryMemory::~DirectoryMemory()
 {
     // free up all the directory entries
-    for (uint64_t i = 0; i < m_num_entries; i++) {
-        if (m_entries[i] != NULL) {
-            delete m_entries[i];
-        }
-    }
-    delete [] m_entries;
+    forEachEntry([](AbstractCacheEntry *entry) { delete entry; });
 }
 
 bool
@@ -119,7 +112,8 @@ DirectoryMemory::lookup(Addr address)
 
     uint64_t idx = mapAddressToLocalIdx(address);
     assert(idx < m_num_entries);
-    return m_entries[idx];
+    const Page *page = m_pages[idx >> PageBits].get();
+    return page ? page->entries[idx & (PageSize - 1)] : NULL;
 }
 
 AbstractCacheEntry*
@@ -131,9 +125,14 @@ DirectoryMemory::allocate(Addr address, AbstractCacheEntry *entry)
 
     idx = mapAddressToLocalIdx(address);
     assert(idx < m_num_entries);
-    assert(m_entries[idx] == NULL);
+    std::unique_ptr<Page> &page = m_pages[idx >> PageBits];
+    if (!page)
+        page.reset(new Page);
+    assert(page->entries[idx & (PageSize - 1)] == NULL);
     entry->changePermission(AccessPermission_Read_Only);
-    m_entries[idx] = entry;
+    entry->m_Address = address;
+    page->entries[idx & (PageSize - 1)] = entry;
+    page->numEntries++;
 
     return entry;
 }
@@ -147,9 +146,12 @@ DirectoryMemory::deallocate(Addr address)
 
     idx = mapAddressToLocalIdx(address);
     assert(idx < m_num_entries);
-    assert(m_entries[idx] != NULL);
-    delete m_entries[idx];
-    m_entries[idx] = NULL;
+    std::unique_ptr<Page> &page = m_pages[idx >> PageBits];
+    assert(page && page->entries[idx & (PageSize - 1)] != NULL);
+    delete page->entries[idx & (PageSize - 1)];
+    page->entries[idx & (PageSize - 1)] = NULL;
+    if (--page->numEntries == 0)
+        page.reset();
 }
 
 void
@@ -42,7 +42,9 @@
 #define __MEM_RUBY_STRUCTURES_DIRECTORYMEMORY_HH__
 
 #include <iostream>
+#include <memory>
 #include <string>
+#include <vector>
 
 #include "base/addr_range.hh"
 #include "mem/ruby/common/Address.hh"
@@ -88,6 +90,21 @@ class DirectoryMemory : public SimObject
     // Explicitly free up this address
     void deallocate(Addr address);
 
+    // Calls f(entry) for every allocated entry, for the cache snapshots
+    template <typename F>
+    void
+    forEachEntry(F f) const
+    {
+        for (const auto &page : m_pages) {
+            if (!page)
+                continue;
+            for (AbstractCacheEntry *entry : page->entries) {
+                if (entry != NULL)
+                    f(entry);
+            }
+        }
+    }
+
     void print(std::ostream& out) const;
     void recordRequestType(DirectoryRequestType requestType);
 
@@ -97,8 +114,23 @@ class DirectoryMemory : public SimObject
     DirectoryMemory& operator=(const DirectoryMemory& obj);
 
   private:
+    /**
+     * The entries are kept in pages of PageSize consecutive blocks. A page
+     * is only allocated when one of its blocks gets an entry, and freed
+     * when its last entry is, so the host memory used scales with the
+     * blocks touched rather than with the size of the address range.
+     */
+    static constexpr int PageBits = 9;
+    static constexpr uint64_t PageSize = 1ULL << PageBits;
+
+    struct Page
+    {
+        uint64_t numEntries = 0;
+        AbstractCacheEntry *entries[PageSize] = {};
+    };
+
     const std::string m_name;
-    AbstractCacheEntry **m_entries;
+    std::vector<std::unique_ptr<Page>> m_pages;
     // int m_size;  // # of memory module blocks this directory is
                     // responsible for
     uint64_t m_size_bytes;
@@ -55,7 +55,7 @@ MN_TBETable::chooseNewDistributor()
     bool has_waiting_sync = false;
     int waiting_count = 0;
     for (auto& keyValuePair : m_map) {
-        MiscNode_TBE& tbe = keyValuePair.second;
+        MiscNode_TBE& tbe = keyValuePair.second.entry;
 
         switch (tbe.getstate()) {
             case MiscNode_State_DvmSync_Distributing:
@@ -0,0 +1,65 @@
+/*
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "mem/ruby/structures/TBETable.hh"
+
+namespace gem5
+{
+
+namespace ruby
+{
+
+TBETableStats::TBETableStats(statistics::Group *parent,
+                             const std::string &name)
+    : statistics::Group(parent, name.c_str()),
+      ADD_STAT(occupancy, statistics::units::Count::get(),
+               "time-average number of TBEs allocated"),
+      ADD_STAT(maxOccupancy, statistics::units::Count::get(),
+               "highest number of TBEs allocated at once"),
+      ADD_STAT(missLatency, statistics::units::Tick::get(),
+               "lifetime of the TBEs deallocated as misses")
+{
+    maxOccupancy.flags(statistics::nozero);
+    missLatency
+        .init(10)
+        .flags(statistics::pdf | statistics::total | statistics::nozero);
+
+    for (int type = 0; type < RubyRequestType_NUM; type++) {
+        std::string stat_name = "missLatency." +
+            RubyRequestType_to_string(RubyRequestType(type));
+        missLatencyByType.emplace_back(new statistics::Histogram(this,
+            stat_name.c_str(), statistics::units::Tick::get(),
+            "lifetime of the TBEs deallocated as misses of this type"));
+        missLatencyByType.back()->init(10)
+            .flags(statistics::pdf | statistics::total |
+                   statistics::nozero);
+    }
+}
+
+} // namespace ruby
+} // namespace gem5
@@ -42,15 +42,15 @@
 #define __MEM_RUBY_STRUCTURES_TBETABLE_HH__
 
 #include <iostream>
-#include <unordered_map>
-#include <bits/stdc++.h>
+#include <memory>
+#include <string>
+#include <vector>
 
+#include "base/statistics.hh"
 #include "mem/ruby/common/Address.hh"
-
-static int count =0;
-static gem5::Tick penality = 0;
-
-
+#include "mem/ruby/common/FlatAddressMap.hh"
+#include "mem/ruby/protocol/RubyRequestType.hh"
+#include "sim/cur_tick.hh"
 
 namespace gem5
 {
@@ -58,19 +58,38 @@ namespace gem5
 namespace ruby
 {
 
+// Statistics of a TBE table: the time-average and high-water mark of
+// its occupancy, and the lifetime of the TBEs deallocated as misses,
+// overall and per request type
+struct TBETableStats : public statistics::Group
+{
+    TBETableStats(statistics::Group *parent, const std::string &name);
+
+    statistics::Average occupancy;
+    statistics::Scalar maxOccupancy;
+    statistics::Histogram missLatency;
+    std::vector<std::unique_ptr<statistics::Histogram>> missLatencyByType;
+};
 
 template<class ENTRY>
 class TBETable
 {
   public:
     TBETable(int number_of_TBEs)
-        : m_number_of_TBEs(number_of_TBEs)
+        : m_map(number_of_TBEs), m_number_of_TBEs(number_of_TBEs),
+          m_miss_latency(0), m_misses(0)
     {
     }
-    std::unordered_map<Addr , std::pair<Tick, Tick>> penality_buffer_a; 
+
+    // Registers the statistics of the table with its controller
+    void initStats(statistics::Group *parent, const std::string &name);
+
     bool isPresent(Addr address) const;
     void allocate(Addr address);
-    void deallocate(Addr address, int type);
+    void deallocate(Addr address);
+    // Also samples the lifetime of the TBE as the latency of a miss of
+    // the given request type (RubyRequestType_NULL: not a miss)
+    void deallocate(Addr address, RubyRequestType type);
     bool
     areNSlotsAvailable(int n, Tick current_time) const
     {
@@ -80,6 +99,10 @@ class TBETable
     ENTRY *getNullEntry();
     ENTRY *lookup(Addr address);
 
+    // Average miss latency so far (1 before the first miss), e.g. as an
+    // input to adaptive policies of the protocol
+    Tick get_avg_misspenalty() const;
+
     // Print cache contents
     void print(std::ostream& out) const;
 
@@ -87,18 +110,30 @@ class TBETable
     // Protected copy constructor and assignment operator
     TBETable(const TBETable& obj);
     TBETable& operator=(const TBETable& obj);
-    void incrementpenalty(Tick x);
-    Tick get_avg_misspenalty();
-    Tick m_sumtotal;
-    int m_cnttotal;  
-    // Tick m_sumtotal;
-    // int m_cnttotal;   
+
+    // A TBE along with its allocation time
+    struct Slot
+    {
+        ENTRY entry;
+        Tick allocTime = 0;
+    };
 
     // Data Members (m_prefix)
-    std::unordered_map<Addr, ENTRY> m_map;
+    // Preallocated for number_of_TBEs entries; TBEs never move while
+    // allocated, so the pointers handed out by lookup() stay valid
+    FlatAddressMap<Slot> m_map;
 
   private:
+    void updateOccupancy();
+
     int m_number_of_TBEs;
+
+    // Running miss latency, kept apart from the stats so that it
+    // survives stats resets
+    Tick m_miss_latency;
+    uint64_t m_misses;
+
+    std::unique_ptr<TBETableStats> m_stats;
 };
 
 template<class ENTRY>
@@ -110,6 +145,15 @@ operator<<(std::ostream& out, const TBETable<ENTRY>& obj)
     return out;
 }
 
+template<class ENTRY>
+inline void
+TBETable<ENTRY>::initStats(statistics::Group *parent,
+                           const std::string &name)
+{
+    assert(!m_stats);
+    m_stats.reset(new TBETableStats(parent, name));
+}
+
 template<class ENTRY>
 inline bool
 TBETable<ENTRY>::isPresent(Addr address) const
@@ -117,7 +161,6 @@ TBETable<ENTRY>::isPresent(Addr address) const
     assert(address == makeLineAddress(address));
     assert(m_map.size() <= m_number_of_TBEs);
     return !!m_map.count(address);
-
 }
 
 template<class ENTRY>
@@ -126,42 +169,53 @@ TBETable<ENTRY>::allocate(Addr address)
 {
     assert(!isPresent(address));
     assert(m_map.size() < m_number_of_TBEs);
-    m_map[address] = ENTRY();
-
-    m_map[address].m_entry_time = curTick();
-    m_map[address].m_exit_time = INT64_MAX;
+    m_map.emplace(address).first->second.allocTime = curTick();
+    updateOccupancy();
 }
 
 template<class ENTRY>
 inline void
-TBETable<ENTRY>::deallocate(Addr address, int type)
+TBETable<ENTRY>::deallocate(Addr address)
 {
     assert(isPresent(address));
     assert(m_map.size() > 0);
-    m_map[address].m_exit_time =  curTick();
-    if(type == 1){
-      std::cout << "here in TBE type 1\n\n";
-      incrementpenalty(m_map[address].m_exit_time  - m_map[address].m_entry_time);
-      //get_avg_misspenalty();
-    }
-
     m_map.erase(address);
+    updateOccupancy();
 }
 
 template<class ENTRY>
-inline ENTRY*
-TBETable<ENTRY>::getNullEntry()
+inline void
+TBETable<ENTRY>::deallocate(Addr address, RubyRequestType type)
 {
-    return nullptr;
+    assert(isPresent(address));
+    if (type != RubyRequestType_NULL) {
+        Tick latency = curTick() - m_map.find(address)->second.allocTime;
+        m_miss_latency += latency;
+        m_misses++;
+        if (m_stats) {
+            m_stats->missLatency.sample(latency);
+            m_stats->missLatencyByType[type]->sample(latency);
+        }
+    }
+    deallocate(address);
 }
 
 template<class ENTRY>
 inline void
-TBETable<ENTRY>::incrementpenalty(Tick x){
-    penality += x;
-    count += 1;
-    m_sumtotal+=x;
-    m_cnttotal+=1;
+TBETable<ENTRY>::updateOccupancy()
+{
+    if (m_stats) {
+        m_stats->occupancy = m_map.size();
+        if (m_map.size() > m_stats->maxOccupancy.value())
+            m_stats->maxOccupancy = m_map.size();
+    }
+}
+
+template<class ENTRY>
+inline ENTRY*
+TBETable<ENTRY>::getNullEntry()
+{
+    return nullptr;
 }
 
 // looks an address up in the cache
@@ -169,27 +223,20 @@ template<class ENTRY>
 inline ENTRY*
 TBETable<ENTRY>::lookup(Addr address)
 {
-  if (m_map.find(address) != m_map.end()) return &(m_map.find(address)->second);
+  auto it = m_map.find(address);
+  if (it != m_map.end()) return &(it->second.entry);
   return NULL;
 }
 
 template<class ENTRY>
 inline Tick
-TBETable<ENTRY>::get_avg_misspenalty(){
-
-
-  if(m_sumtotal!=0&&m_cnttotal!=0){
-    // if(flag){
-    // DPRINTF(MyRuby,"Final miss penalty L1Cache Core %d - Tick = %d, Sum = %d, Cnt = %d, Avg Miss Penalty = %d\n\n", m_coreID,curTick(), m_sumtotal,m_cnttotal, m_sumtotal/m_cnttotal);
-    // }
-
-    return m_sumtotal/m_cnttotal;
-  }
-  else return 1;
-
+TBETable<ENTRY>::get_avg_misspenalty() const
+{
+    if (m_misses == 0)
+        return 1;
+    return m_miss_latency / m_misses;
 }
 
-
 template<class ENTRY>
 inline void
 TBETable<ENTRY>::print(std::ostream& out) const
@@ -199,4 +246,4 @@ TBETable<ENTRY>::print(std::ostream& out) const
 } // namespace ruby
 } // namespace gem5
 
-#endif // __MEM_RUBY_STRUCTURES_TBETABLE_HH__
\ No newline at end of file
+#endif // __MEM_RUBY_STRUCTURES_TBETABLE_HH__
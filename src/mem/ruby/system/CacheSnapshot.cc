@@ -0,0 +1,433 @@
+/*
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "mem/ruby/system/CacheSnapshot.hh"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <unordered_set>
+
+#include "base/cprintf.hh"
+#include "base/logging.hh"
+#include "base/trace.hh"
+#include "debug/RubyCacheTrace.hh"
+
+namespace gem5
+{
+
+namespace ruby
+{
+
+void
+CacheSnapshotFields::putInt(int64_t value)
+{
+    const uint8_t *bytes = (const uint8_t *)&value;
+    m_bytes.insert(m_bytes.end(), bytes, bytes + sizeof(value));
+}
+
+void
+CacheSnapshotFields::put(const MachineID &machine)
+{
+    putInt(machine.type);
+    putInt(machine.num);
+}
+
+void
+CacheSnapshotFields::put(const NetDest &dest)
+{
+    putInt(dest.count());
+    for (int type = 0; type < MachineType_NUM; type++) {
+        for (NodeID num = 0; num < MachineType_base_count(MachineType(type));
+             num++) {
+            MachineID machine(MachineType(type), num);
+            if (dest.isElement(machine))
+                put(machine);
+        }
+    }
+}
+
+void
+CacheSnapshotFields::put(const Set &set)
+{
+    putInt(set.getSize());
+    for (int i = 0; i < set.getSize(); i++)
+        putInt(set.isElement(i));
+}
+
+void
+CacheSnapshotFields::put(const DataBlock &data)
+{
+    const uint8_t *bytes = data.getData(0, m_block_size);
+    m_bytes.insert(m_bytes.end(), bytes, bytes + m_block_size);
+}
+
+const uint8_t *
+CacheSnapshot::FieldReader::take(uint32_t size)
+{
+    fatal_if(m_size - m_pos < size,
+             "Cache snapshot: the fields of %s are truncated", m_where);
+    const uint8_t *bytes = m_fields + m_pos;
+    m_pos += size;
+    return bytes;
+}
+
+int64_t
+CacheSnapshot::FieldReader::getInt()
+{
+    int64_t value;
+    std::memcpy(&value, take(sizeof(value)), sizeof(value));
+    return value;
+}
+
+void
+CacheSnapshot::FieldReader::get(MachineID &machine)
+{
+    int64_t type = getInt();
+    int64_t num = getInt();
+    // An unset MachineID has type MachineType_NUM
+    fatal_if(type < 0 || type > MachineType_NUM || num < 0 ||
+             (type < MachineType_NUM &&
+              num >= MachineType_base_count(MachineType(type))),
+             "Cache snapshot: %s has a machine not in the system", m_where);
+    machine = MachineID(MachineType(type), num);
+}
+
+void
+CacheSnapshot::FieldReader::get(NetDest &dest)
+{
+    dest.clear();
+    int64_t count = getInt();
+    for (int64_t i = 0; i < count; i++) {
+        MachineID machine;
+        get(machine);
+        fatal_if(!machine.isValid(),
+                 "Cache snapshot: %s has a machine not in the system",
+                 m_where);
+        dest.add(machine);
+    }
+}
+
+void
+CacheSnapshot::FieldReader::get(Set &set)
+{
+    int64_t size = getInt();
+    fatal_if(size < 0 || size > NUMBER_BITS_PER_SET,
+             "Cache snapshot: %s has a set of %d elements", m_where, size);
+    set.setSize(size);
+    set.clear();
+    for (int i = 0; i < size; i++) {
+        if (getInt())
+            set.add(i);
+    }
+}
+
+void
+CacheSnapshot::FieldReader::get(DataBlock &data)
+{
+    data.setData(take(m_block_size), 0, m_block_size);
+}
+
+void
+CacheSnapshot::FieldReader::done() const
+{
+    fatal_if(m_pos != m_size, "Cache snapshot: %s has fields the "
+             "controller does not have", m_where);
+}
+
+CacheSnapshot::Record
+CacheSnapshot::Section::record(uint64_t idx) const
+{
+    assert(idx < size());
+    Record rec;
+    std::memcpy(&rec, m_records + m_offsets[idx], sizeof(Record));
+    return rec;
+}
+
+const uint8_t *
+CacheSnapshot::Section::data(uint64_t idx) const
+{
+    assert(idx < size());
+    return m_records + m_offsets[idx] + sizeof(Record);
+}
+
+CacheSnapshot::FieldReader
+CacheSnapshot::Section::fields(uint64_t idx) const
+{
+    Record rec = record(idx);
+    return FieldReader(data(idx) + m_block_size, rec.fieldsSize,
+                       m_block_size,
+                       csprintf("%#x in %s", rec.addr, m_name));
+}
+
+CacheSnapshot::CacheSnapshot(const std::string &filename, uint32_t block_size)
+    : m_filename(filename), m_block_size(block_size)
+{
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        perror("open");
+        fatal("Unable to open cache snapshot %s", filename);
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        perror("fstat");
+        fatal("Unable to stat cache snapshot %s", filename);
+    }
+    m_size = st.st_size;
+    fatal_if(m_size < sizeof(FileHeader),
+             "Cache snapshot %s is truncated", filename);
+
+    m_base = (uint8_t *)mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (m_base == MAP_FAILED) {
+        perror("mmap");
+        fatal("Unable to map cache snapshot %s", filename);
+    }
+    close(fd);
+
+    FileHeader header;
+    std::memcpy(&header, m_base, sizeof(header));
+    fatal_if(std::memcmp(header.magic, Magic, sizeof(Magic)) != 0,
+             "%s is not a Ruby cache snapshot", filename);
+    fatal_if(header.version != Version,
+             "Cache snapshot %s has version %d, expected %d", filename,
+             header.version, Version);
+    fatal_if(header.blockSize != block_size,
+             "Cache snapshot %s has %d-byte blocks, the system uses %d",
+             filename, header.blockSize, block_size);
+
+    uint64_t offset = sizeof(FileHeader);
+    for (uint64_t s = 0; s < header.numSections; s++) {
+        fatal_if(m_size - offset < sizeof(SectionHeader),
+                 "Cache snapshot %s is truncated", filename);
+        SectionHeader section_header;
+        std::memcpy(&section_header, m_base + offset, sizeof(section_header));
+        offset += sizeof(SectionHeader);
+
+        std::string section_name(section_header.name,
+                                 strnlen(section_header.name,
+                                         SectionNameSize));
+        Section &section = m_sections[section_name];
+        fatal_if(section.m_records, "Cache snapshot %s: duplicate section "
+                 "%s", filename, section_name);
+        section.m_name = section_name;
+        section.m_records = m_base + offset;
+        section.m_block_size = block_size;
+        const uint64_t records_start = offset;
+
+        // A structure holds a block at most once
+        std::unordered_set<Addr> seen;
+        for (uint64_t i = 0; i < section_header.numRecords; i++) {
+            Record rec;
+            fatal_if(m_size - offset < sizeof(rec) + block_size,
+                     "Cache snapshot %s: section %s is truncated",
+                     filename, section_name);
+            std::memcpy(&rec, m_base + offset, sizeof(rec));
+            fatal_if(m_size - offset - sizeof(rec) - block_size <
+                     rec.fieldsSize,
+                     "Cache snapshot %s: section %s is truncated",
+                     filename, section_name);
+            section.m_offsets.push_back(offset - records_start);
+            offset += sizeof(rec) + block_size + rec.fieldsSize;
+
+            fatal_if(makeLineAddress(rec.addr) != rec.addr,
+                     "Cache snapshot %s: %s has unaligned address %#x",
+                     filename, section_name, rec.addr);
+            fatal_if(rec.state < 0 || rec.perm >= AccessPermission_NUM,
+                     "Cache snapshot %s: %s has a bad record for %#x",
+                     filename, section_name, rec.addr);
+            fatal_if(!seen.insert(rec.addr).second,
+                     "Cache snapshot %s: %s holds %#x twice", filename,
+                     section_name, rec.addr);
+        }
+
+        DPRINTF(RubyCacheTrace, "Snapshot section %s: %d blocks\n",
+                section_name, section.size());
+    }
+    fatal_if(offset != m_size, "Cache snapshot %s has trailing data",
+             filename);
+}
+
+CacheSnapshot::~CacheSnapshot()
+{
+    munmap(m_base, m_size);
+}
+
+const CacheSnapshot::Section &
+CacheSnapshot::section(const std::string &name)
+{
+    auto it = m_sections.find(name);
+    fatal_if(it == m_sections.end(),
+             "Cache snapshot %s has no contents for %s", m_filename, name);
+    it->second.m_used = true;
+    return it->second;
+}
+
+void
+CacheSnapshot::checkAllLoaded() const
+{
+    for (const auto &it : m_sections) {
+        fatal_if(!it.second.m_used, "Cache snapshot %s has contents for %s, "
+                 "which is not in the system", m_filename, it.first);
+    }
+}
+
+void
+CacheSnapshot::validate(const MemoryReader &read_memory) const
+{
+    struct Copy
+    {
+        const uint8_t *data = nullptr;
+        std::string writer;
+        bool dirty = false;
+    };
+    std::unordered_map<Addr, Copy> copies;
+
+    for (const auto &it : m_sections) {
+        const Section &section = it.second;
+        for (uint64_t i = 0; i < section.size(); i++) {
+            Record rec = section.record(i);
+            AccessPermission perm = (AccessPermission)rec.perm;
+            fatal_if(perm == AccessPermission_Busy,
+                     "Cache snapshot %s: %s has %#x in a transient state",
+                     m_filename, it.first, rec.addr);
+
+            if (perm != AccessPermission_Read_Only &&
+                perm != AccessPermission_Read_Write)
+                continue;
+
+            Copy &copy = copies[rec.addr];
+            if (perm == AccessPermission_Read_Write) {
+                fatal_if(!copy.writer.empty(),
+                         "Cache snapshot %s: %#x is writable in both %s "
+                         "and %s", m_filename, rec.addr, copy.writer,
+                         it.first);
+                copy.writer = it.first;
+            }
+            if (!rec.hasData)
+                continue;
+            copy.dirty |= rec.dirty;
+            if (!copy.data) {
+                copy.data = section.data(i);
+            } else {
+                fatal_if(std::memcmp(copy.data, section.data(i),
+                                     m_block_size) != 0,
+                         "Cache snapshot %s: the copies of %#x differ",
+                         m_filename, rec.addr);
+            }
+        }
+    }
+
+    // The copies of a block no cache may have written are those of memory
+    std::vector<uint8_t> memory(m_block_size);
+    for (const auto &it : copies) {
+        const Copy &copy = it.second;
+        if (!copy.data || copy.dirty || !read_memory(it.first, memory.data()))
+            continue;
+        fatal_if(std::memcmp(copy.data, memory.data(), m_block_size) != 0,
+                 "Cache snapshot %s: %#x is clean but differs from memory",
+                 m_filename, it.first);
+    }
+}
+
+CacheSnapshotWriter::CacheSnapshotWriter(uint32_t block_size)
+    : m_block_size(block_size)
+{
+}
+
+void
+CacheSnapshotWriter::beginSection(const std::string &name)
+{
+    fatal_if(name.size() >= CacheSnapshot::SectionNameSize,
+             "Name %s is too long for a cache snapshot", name);
+    m_sections.push_back({name, 0, {}});
+}
+
+void
+CacheSnapshotWriter::addRecord(Addr addr, int state, AccessPermission perm,
+                               bool dirty, const DataBlock *data,
+                               const CacheSnapshotFields &fields)
+{
+    assert(!m_sections.empty());
+    Section &section = m_sections.back();
+
+    CacheSnapshot::Record rec;
+    std::memset(&rec, 0, sizeof(rec));
+    rec.addr = addr;
+    rec.state = state;
+    rec.fieldsSize = fields.bytes().size();
+    rec.perm = perm;
+    rec.hasData = data != nullptr;
+    rec.dirty = dirty;
+
+    const size_t offset = section.records.size();
+    section.records.resize(offset + sizeof(rec) + m_block_size +
+                           rec.fieldsSize);
+    std::memcpy(&section.records[offset], &rec, sizeof(rec));
+    if (data) {
+        std::memcpy(&section.records[offset + sizeof(rec)],
+                    data->getData(0, m_block_size), m_block_size);
+    }
+    std::copy(fields.bytes().begin(), fields.bytes().end(),
+              section.records.begin() + offset + sizeof(rec) + m_block_size);
+    section.numRecords++;
+}
+
+void
+CacheSnapshotWriter::write(const std::string &filename) const
+{
+    std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+    fatal_if(!out, "Can't open cache snapshot %s", filename);
+
+    CacheSnapshot::FileHeader header;
+    std::memcpy(header.magic, CacheSnapshot::Magic, sizeof(header.magic));
+    header.version = CacheSnapshot::Version;
+    header.blockSize = m_block_size;
+    header.numSections = m_sections.size();
+    out.write((const char *)&header, sizeof(header));
+
+    for (const auto &section : m_sections) {
+        CacheSnapshot::SectionHeader section_header;
+        std::memset(section_header.name, 0, sizeof(section_header.name));
+        std::memcpy(section_header.name, section.name.data(),
+                    section.name.size());
+        section_header.numRecords = section.numRecords;
+        out.write((const char *)&section_header, sizeof(section_header));
+        out.write((const char *)section.records.data(),
+                  section.records.size());
+    }
+
+    fatal_if(!out, "Write failed on cache snapshot %s", filename);
+}
+
+} // namespace ruby
+} // namespace gem5
@@ -0,0 +1,244 @@
+/*
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Snapshot of the contents of the Ruby caches and directories. Unlike the
+ * cache trace of a checkpoint (see CacheRecorder), which is replayed as
+ * requests through the sequencers, a snapshot holds the protocol state of
+ * every block and is loaded straight into the CacheMemory and
+ * DirectoryMemory structures by their controllers.
+ */
+
+#ifndef __MEM_RUBY_SYSTEM_CACHESNAPSHOT_HH__
+#define __MEM_RUBY_SYSTEM_CACHESNAPSHOT_HH__
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "mem/ruby/common/Address.hh"
+#include "mem/ruby/common/DataBlock.hh"
+#include "mem/ruby/common/MachineID.hh"
+#include "mem/ruby/common/NetDest.hh"
+#include "mem/ruby/common/Set.hh"
+#include "mem/ruby/protocol/AccessPermission.hh"
+
+namespace gem5
+{
+
+namespace ruby
+{
+
+/*
+ * The fields of a cache or directory entry other than its state,
+ * permission and data block (e.g. the sharers and owner of a directory
+ * entry), as the controller serializes them into a snapshot record in
+ * the order the entry declares them. Integers, enumerations, MachineIDs,
+ * NetDests, Sets and DataBlocks are supported.
+ */
+class CacheSnapshotFields
+{
+  public:
+    CacheSnapshotFields(uint32_t block_size) : m_block_size(block_size) {}
+
+    template<class T>
+    void put(const T &value) { putInt(int64_t(value)); }
+    void put(const MachineID &machine);
+    void put(const NetDest &dest);
+    void put(const Set &set);
+    void put(const DataBlock &data);
+
+    const std::vector<uint8_t> &bytes() const { return m_bytes; }
+
+  private:
+    void putInt(int64_t value);
+
+    const uint32_t m_block_size;
+    std::vector<uint8_t> m_bytes;
+};
+
+/*
+ * The snapshot file is a header followed by one section per cache or
+ * directory, named after the structure. A section is a header followed
+ * by records, each one the block's address, its state in the
+ * controller's state machine, its permission, whether it may be dirty,
+ * blockSize bytes of data (zero if the structure does not hold data)
+ * and the other fields of the entry. Sections are found and records
+ * indexed in place in the memory-mapped file.
+ */
+class CacheSnapshot
+{
+  public:
+    struct Record
+    {
+        Addr addr;
+        int32_t state;
+        // Size of the other fields of the entry, after the data
+        uint32_t fieldsSize;
+        uint8_t perm;
+        uint8_t hasData;
+        // Set unless the entry tells the data is clean
+        uint8_t dirty;
+        uint8_t pad[5];
+    };
+
+    // Reads the fields a record holds (see CacheSnapshotFields)
+    class FieldReader
+    {
+      public:
+        FieldReader(const uint8_t *fields, uint32_t size,
+                    uint32_t block_size, const std::string &where)
+            : m_fields(fields), m_size(size), m_block_size(block_size),
+              m_where(where)
+        {}
+
+        template<class T>
+        void get(T &value) { value = T(getInt()); }
+        void get(MachineID &machine);
+        void get(NetDest &dest);
+        void get(Set &set);
+        void get(DataBlock &data);
+
+        // Checks that every field was read
+        void done() const;
+
+      private:
+        int64_t getInt();
+        const uint8_t *take(uint32_t size);
+
+        const uint8_t *m_fields;
+        const uint32_t m_size;
+        const uint32_t m_block_size;
+        uint32_t m_pos = 0;
+        const std::string m_where;
+    };
+
+    class Section
+    {
+      public:
+        uint64_t size() const { return m_offsets.size(); }
+        Record record(uint64_t idx) const;
+        const uint8_t *data(uint64_t idx) const;
+        FieldReader fields(uint64_t idx) const;
+
+      private:
+        friend class CacheSnapshot;
+
+        std::string m_name;
+        const uint8_t *m_records = nullptr;
+        std::vector<uint64_t> m_offsets;
+        uint32_t m_block_size = 0;
+        bool m_used = false;
+    };
+
+    // Maps the file and checks its structure
+    CacheSnapshot(const std::string &filename, uint32_t block_size);
+    ~CacheSnapshot();
+
+    // The records of a structure, which must be in the snapshot
+    const Section &section(const std::string &name);
+
+    // Checks that every section was loaded by some structure
+    void checkAllLoaded() const;
+
+    // Reads a line of the backing memory into a block, false if there
+    // is no memory for it
+    typedef std::function<bool(Addr, uint8_t *)> MemoryReader;
+
+    // Checks that the snapshot is coherent: no block is in a transient
+    // state, at most one copy of a block is writable, all readable
+    // copies hold the same data and, if none of them may be dirty, the
+    // data of the backing memory
+    void validate(const MemoryReader &read_memory) const;
+
+  private:
+    // Private copy constructor and assignment operator
+    CacheSnapshot(const CacheSnapshot& obj);
+    CacheSnapshot& operator=(const CacheSnapshot& obj);
+
+    friend class CacheSnapshotWriter;
+
+    static constexpr char Magic[8] = {'R', 'U', 'B', 'Y', 'S', 'N', 'A', 'P'};
+    static constexpr uint32_t Version = 2;
+    static constexpr size_t SectionNameSize = 120;
+
+    struct FileHeader
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t blockSize;
+        uint64_t numSections;
+    };
+
+    struct SectionHeader
+    {
+        char name[SectionNameSize];
+        uint64_t numRecords;
+    };
+
+    const std::string m_filename;
+    const uint32_t m_block_size;
+    uint8_t *m_base;
+    uint64_t m_size;
+    std::unordered_map<std::string, Section> m_sections;
+};
+
+/*
+ * Builds a snapshot section by section and writes it out in the format
+ * read by CacheSnapshot.
+ */
+class CacheSnapshotWriter
+{
+  public:
+    CacheSnapshotWriter(uint32_t block_size);
+
+    // Starts the section of a structure; the records added after it
+    // belong to that structure
+    void beginSection(const std::string &name);
+    void addRecord(Addr addr, int state, AccessPermission perm, bool dirty,
+                   const DataBlock *data, const CacheSnapshotFields &fields);
+
+    void write(const std::string &filename) const;
+
+  private:
+    struct Section
+    {
+        std::string name;
+        uint64_t numRecords;
+        std::vector<uint8_t> records;
+    };
+
+    const uint32_t m_block_size;
+    std::vector<Section> m_sections;
+};
+
+} // namespace ruby
+} // namespace gem5
+
+#endif // __MEM_RUBY_SYSTEM_CACHESNAPSHOT_HH__
@@ -53,6 +53,7 @@
 #include "debug/RubySystem.hh"
 #include "mem/ruby/common/Address.hh"
 #include "mem/ruby/network/Network.hh"
+#include "mem/ruby/system/CacheSnapshot.hh"
 #include "mem/ruby/system/DMASequencer.hh"
 #include "mem/ruby/system/Sequencer.hh"
 #include "mem/simple_mem.hh"
@@ -78,7 +79,7 @@ bool RubySystem::m_cooldown_enabled = false;
 
 RubySystem::RubySystem(const Params &p)
     : ClockedObject(p), m_access_backing_store(p.access_backing_store),
-      m_cache_recorder(NULL)
+      m_cache_snapshot(p.cache_snapshot), m_cache_recorder(NULL)
 {
     m_randomization = p.randomization;
 
@@ -455,11 +456,68 @@ RubySystem::startup()
         // Restore curTick and Ruby System's clock
         setCurTick(curtick_original);
         resetClock();
+    } else if (!m_cache_snapshot.empty()) {
+        loadCacheSnapshot(m_cache_snapshot);
     }
 
     resetStats();
 }
 
+void
+RubySystem::saveCacheSnapshot(const std::string &filename)
+{
+    DPRINTF(RubyCacheTrace, "Saving cache snapshot %s\n", filename);
+    CacheSnapshotWriter snap(getBlockSizeBytes());
+    for (auto &cntrl : m_abs_cntrl_vec) {
+        cntrl->saveCacheSnapshot(snap);
+    }
+    snap.write(filename);
+
+    // Check the snapshot as it will be loaded
+    CacheSnapshot(filename, getBlockSizeBytes()).validate(
+        [this](Addr line, uint8_t *data) {
+            return readMemoryLine(line, data);
+        });
+}
+
+void
+RubySystem::loadCacheSnapshot(const std::string &filename)
+{
+    // The blocks are put in the caches and directories in their recorded
+    // state, with no transactions simulated. The snapshot must be
+    // coherent and match the caches and directories of the system.
+    DPRINTF(RubyCacheTrace, "Loading cache snapshot %s\n", filename);
+    CacheSnapshot snap(filename, getBlockSizeBytes());
+    snap.validate([this](Addr line, uint8_t *data) {
+        return readMemoryLine(line, data);
+    });
+    for (auto &cntrl : m_abs_cntrl_vec) {
+        cntrl->loadCacheSnapshot(snap);
+    }
+    snap.checkAllLoaded();
+}
+
+bool
+RubySystem::readMemoryLine(Addr line, uint8_t *data)
+{
+    RequestPtr req = std::make_shared<Request>(
+        line, getBlockSizeBytes(), 0, Request::funcRequestorId);
+    Packet pkt(req, MemCmd::ReadReq);
+    pkt.dataStatic(data);
+
+    if (m_access_backing_store) {
+        m_phys_mem->functionalAccess(&pkt);
+        return true;
+    }
+    for (auto &cntrl : m_abs_cntrl_vec) {
+        if (cntrl->hasMemoryFor(line)) {
+            cntrl->functionalMemoryRead(&pkt);
+            return true;
+        }
+    }
+    return false;
+}
+
 void
 RubySystem::processRubyEvent()
 {
@@ -94,6 +94,10 @@ class RubySystem : public ClockedObject
     void resetStats() override;
 
     void memWriteback() override;
+
+    // Writes the contents of the caches and directories to a cache
+    // snapshot, which the cache_snapshot parameter loads at startup
+    void saveCacheSnapshot(const std::string &filename);
     void serialize(CheckpointOut &cp) const override;
     void unserialize(CheckpointIn &cp) override;
     void drainResume() override;
@@ -132,6 +136,10 @@ class RubySystem : public ClockedObject
                                      uint64_t uncompressed_trace_size);
 
     void processRubyEvent();
+    void loadCacheSnapshot(const std::string &filename);
+    // Reads a line from the backing memory, to check the clean blocks of
+    // a cache snapshot
+    bool readMemoryLine(Addr line, uint8_t *data);
   private:
     // configuration parameters
     static bool m_randomization;
@@ -144,6 +152,7 @@ class RubySystem : public ClockedObject
     static bool m_cooldown_enabled;
     memory::SimpleMemory *m_phys_mem;
     const bool m_access_backing_store;
+    const std::string m_cache_snapshot;
 
     //std::vector<Network *> m_networks;
     std::vector<std::unique_ptr<Network>> m_networks;
@@ -26,6 +26,7 @@
 
 from m5.params import *
 from m5.proxy import *
+from m5.SimObject import PyBindMethod
 from m5.objects.ClockedObject import ClockedObject
 from m5.objects.SimpleMemory import *
 
@@ -57,8 +58,34 @@ class RubySystem(ClockedObject):
         store and only use ruby for timing.",
     )
 
+    cache_snapshot = Param.String(
+        "",
+        "cache snapshot (see saveCacheSnapshot) loaded into the caches "
+        "and directories at startup, instead of warming them up",
+    )
+
+    cxx_exports = [
+        PyBindMethod("saveCacheSnapshot"),
+    ]
+
     # Profiler related configuration variables
     hot_lines = Param.Bool(False, "")
     all_instructions = Param.Bool(False, "")
+    hot_lines_sketch = Param.Bool(
+        False,
+        "profile hot_lines with heavy-hitter sketches of bounded size, "
+        "instead of a record per address, along with the network traffic "
+        "of the lines",
+    )
+    hot_lines_tracked = Param.Unsigned(
+        256, "lines, PCs and network lines tracked (top-K) by the sketches"
+    )
+    hot_lines_sample_period = Param.Unsigned(
+        1, "sketches profile one in this many accesses and network messages"
+    )
+    hot_lines_file = Param.String(
+        "ruby_hot_lines.txt",
+        "hot_lines profile, written at every stats dump, in the output dir",
+    )
     num_of_sequencers = Param.Int("")
     number_of_virtual_networks = Param.Unsigned("")
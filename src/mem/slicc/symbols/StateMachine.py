@@ -68,6 +68,10 @@ python_class_map = {
 
 
 class StateMachine(Symbol):
+    # Actions of at most this many lines of generated code are marked
+    # inline in the transition switch
+    inline_action_lines = 12
+
     def __init__(self, symtab, ident, location, pairs, config_parameters):
         super().__init__(symtab, ident, location, pairs)
         self.table = None
@@ -120,6 +124,8 @@ class StateMachine(Symbol):
         self.objects = []
         self.TBEType = None
         self.EntryType = None
+        # The other AbstractCacheEntry types, e.g. of the directory entries
+        self.DirEntryTypes = []
         # Python's sets are not sorted so we have to be careful when using
         # this to generate deterministic output.
         self.debug_flags = set()
@@ -190,7 +196,8 @@ class StateMachine(Symbol):
 
         elif "interface" in type and "AbstractCacheEntry" == type["interface"]:
             if "main" in type and "false" == type["main"].lower():
-                pass  # this isn't the EntryType
+                # this isn't the EntryType
+                self.DirEntryTypes.append(type)
             else:
                 if self.EntryType != None:
                     self.error(
@@ -248,7 +255,7 @@ class StateMachine(Symbol):
         self.printControllerPython(path)
         self.printControllerHH(path)
         self.printControllerCC(path, includes)
-        self.printCSwitch(path)
+        self.printCSwitch(path, includes)
         self.printCWakeup(path, includes)
 
     def printControllerPython(self, path):
@@ -357,6 +364,8 @@ class $c_ident : public AbstractController
     void collateStats();
 
     void recordCacheTrace(int cntrl, CacheRecorder* tr);
+    void saveCacheSnapshot(CacheSnapshotWriter &snap);
+    void loadCacheSnapshot(CacheSnapshot &snap);
     Sequencer* getCPUSequencer() const;
     DMASequencer* getDMASequencer() const;
     GPUCoalescer* getGPUCoalescer() const;
@@ -457,8 +466,17 @@ static int m_num_controllers;
                 """
 
 // Set and Reset for cache_entry variable
-void set_cache_entry(${{self.EntryType.c_ident}}*& m_cache_entry_ptr, AbstractCacheEntry* m_new_cache_entry);
-void unset_cache_entry(${{self.EntryType.c_ident}}*& m_cache_entry_ptr);
+void
+set_cache_entry(${{self.EntryType.c_ident}}*& m_cache_entry_ptr, AbstractCacheEntry* m_new_cache_entry)
+{
+  m_cache_entry_ptr = (${{self.EntryType.c_ident}}*)m_new_cache_entry;
+}
+
+void
+unset_cache_entry(${{self.EntryType.c_ident}}*& m_cache_entry_ptr)
+{
+  m_cache_entry_ptr = 0;
+}
 """
             )
 
@@ -467,8 +485,17 @@ void unset_cache_entry(${{self.EntryType.c_ident}}*& m_cache_entry_ptr);
                 """
 
 // Set and Reset for tbe variable
-void set_tbe(${{self.TBEType.c_ident}}*& m_tbe_ptr, ${ident}_TBE* m_new_tbe);
-void unset_tbe(${{self.TBEType.c_ident}}*& m_tbe_ptr);
+void
+set_tbe(${{self.TBEType.c_ident}}*& m_tbe_ptr, ${{self.TBEType.c_ident}}* m_new_tbe)
+{
+  m_tbe_ptr = m_new_tbe;
+}
+
+void
+unset_tbe(${{self.TBEType.c_ident}}*& m_tbe_ptr)
+{
+  m_tbe_ptr = NULL;
+}
 """
             )
 
@@ -591,6 +618,7 @@ void unset_tbe(${{self.TBEType.c_ident}}*& m_tbe_ptr);
 #include "mem/ruby/protocol/${ident}_Event.hh"
 #include "mem/ruby/protocol/${ident}_State.hh"
 #include "mem/ruby/protocol/Types.hh"
+#include "mem/ruby/system/CacheSnapshot.hh"
 #include "mem/ruby/system/RubySystem.hh"
 
 """
@@ -760,12 +788,26 @@ $c_ident::init()
                     code("$expr($args);")
                     code("assert($vid != NULL);")
 
+                    if "tbe" in vtype:
+                        code('$vid->initStats(this, "${{var.ident}}");')
+
                     if "default" in var:
                         code('*$vid = ${{var["default"]}}; // Object default')
                     elif "default" in vtype:
                         comment = "Type %s default" % vtype.ident
                         code('*$vid = ${{vtype["default"]}}; // $comment')
 
+        # Index the messages of the buffers for functional accesses
+        code()
+        for var in self.objects:
+            if var.type.isBuffer:
+                code("m_${{var.ident}}_ptr->setMessageIndex(&m_buffered_msgs);")
+        for param in self.config_parameters:
+            if param.type_ast.type.isBuffer:
+                code(
+                    "m_${{param.ident}}_ptr->setMessageIndex(&m_buffered_msgs);"
+                )
+
         # Set the prefetchers
         code()
         for prefetcher in self.prefetchers:
@@ -1124,44 +1166,6 @@ void $c_ident::resetStats()
 """
         )
 
-        if self.EntryType != None:
-            code(
-                """
-
-// Set and Reset for cache_entry variable
-void
-$c_ident::set_cache_entry(${{self.EntryType.c_ident}}*& m_cache_entry_ptr, AbstractCacheEntry* m_new_cache_entry)
-{
-  m_cache_entry_ptr = (${{self.EntryType.c_ident}}*)m_new_cache_entry;
-}
-
-void
-$c_ident::unset_cache_entry(${{self.EntryType.c_ident}}*& m_cache_entry_ptr)
-{
-  m_cache_entry_ptr = 0;
-}
-"""
-            )
-
-        if self.TBEType != None:
-            code(
-                """
-
-// Set and Reset for tbe variable
-void
-$c_ident::set_tbe(${{self.TBEType.c_ident}}*& m_tbe_ptr, ${{self.TBEType.c_ident}}* m_new_tbe)
-{
-  m_tbe_ptr = m_new_tbe;
-}
-
-void
-$c_ident::unset_tbe(${{self.TBEType.c_ident}}*& m_tbe_ptr)
-{
-  m_tbe_ptr = NULL;
-}
-"""
-            )
-
         code(
             """
 
@@ -1183,170 +1187,354 @@ $c_ident::recordCacheTrace(int cntrl, CacheRecorder* tr)
         code(
             """
 }
-
-// Actions
 """
         )
-        if self.TBEType != None and self.EntryType != None:
-            for action in self.actions.values():
-                if "c_code" not in action:
-                    continue
 
-                code(
-                    """
-/** \\brief ${{action.desc}} */
-void
-$c_ident::${{action.ident}}(${{self.TBEType.c_ident}}*& m_tbe_ptr, ${{self.EntryType.c_ident}}*& m_cache_entry_ptr, Addr addr)
+        self.printCacheSnapshot(code)
+
+        for func in self.functions:
+            code(func.generateCode())
+
+        # Functional accesses to messages buffered in the controller, found
+        # through the index of its buffers
+        code(
+            """
+int
+$c_ident::functionalWriteBuffers(PacketPtr& pkt)
 {
-    DPRINTF(RubyGenerated, "executing ${{action.ident}}\\n");
-    try {
-       ${{action["c_code"]}}
-    } catch (const RejectException & e) {
-       fatal("Error in action ${{ident}}:${{action.ident}}: "
-             "executed a peek statement with the wrong message "
-             "type specified. ");
-    }
+    return m_buffered_msgs.functionalWrite(pkt);
 }
 
-"""
-                )
-        elif self.TBEType != None:
-            for action in self.actions.values():
-                if "c_code" not in action:
-                    continue
+bool
+$c_ident::functionalReadBuffers(PacketPtr& pkt)
+{
+    return m_buffered_msgs.functionalRead(pkt);
+}
 
-                code(
-                    """
-/** \\brief ${{action.desc}} */
-void
-$c_ident::${{action.ident}}(${{self.TBEType.c_ident}}*& m_tbe_ptr, Addr addr)
+bool
+$c_ident::functionalReadBuffers(PacketPtr& pkt, WriteMask &mask)
 {
-    DPRINTF(RubyGenerated, "executing ${{action.ident}}\\n");
-    ${{action["c_code"]}}
+    return m_buffered_msgs.functionalRead(pkt, mask);
 }
 
+} // namespace ruby
+} // namespace gem5
 """
-                )
-        elif self.EntryType != None:
-            for action in self.actions.values():
-                if "c_code" not in action:
-                    continue
+        )
+
+        code.write(path, "%s.cc" % c_ident)
+
+    # The types of entry fields a cache snapshot holds (see
+    # CacheSnapshotFields), besides the enumerations
+    snapshot_field_types = (
+        "int",
+        "bool",
+        "uint32_t",
+        "uint64_t",
+        "Addr",
+        "Cycles",
+        "Tick",
+        "MachineID",
+        "NetDest",
+        "Set",
+        "DataBlock",
+    )
+
+    def snapshotFields(self, entry_type, skip_data):
+        """The fields of an entry saved in a cache snapshot besides its
+        state and permission, which are all its data members but the data
+        block the record holds, and the first one a snapshot cannot hold
+        if any"""
+        fields = []
+        unsupported = None
+        for ident, member in entry_type.data_members.items():
+            if skip_data and ident == "DataBlk":
+                continue
+            if (
+                member.type.isEnumeration
+                or member.type.c_ident in self.snapshot_field_types
+            ):
+                fields.append(member.code)
+            elif unsupported is None:
+                unsupported = ident
+        return fields, unsupported
+
+    def printCacheSnapshot(self, code):
+        """Save/load the contents of the caches and directories of the
+        controller to/from a cache snapshot. The states are read and set
+        through the getState/setState functions of the state machine, and
+        the other fields of the entries are saved and restored as they
+        are. Entries with fields a snapshot cannot hold are refused."""
+        ident = self.ident
+        c_ident = "%s_Controller" % self.ident
+
+        # Arguments of getState/setState/setAccessPermission before the
+        # address: there is no TBE for a block of a snapshot, and no cache
+        # entry for a block of a directory
+        tbe_arg = "nullptr, " if self.TBEType != None else ""
+        entry_arg = "nullptr, " if self.EntryType != None else ""
+
+        caches = []
+        directories = []
+        for param in self.config_parameters:
+            if param.type_ast.type.ident == "CacheMemory":
+                assert param.pointer
+                # The state of a cache block is in its entry
+                if self.EntryType != None:
+                    caches.append(param.ident)
+            elif param.type_ast.type.ident == "DirectoryMemory":
+                assert param.pointer
+                directories.append(param.ident)
+
+        if self.EntryType != None:
+            entry_type = self.EntryType.c_ident
+            members = self.EntryType.data_members
+            has_data = "DataBlk" in members
+            entry_fields, entry_unsupported = self.snapshotFields(
+                self.EntryType, True
+            )
+            if (
+                "Dirty" in members
+                and members["Dirty"].type.c_ident == "bool"
+            ):
+                dirty_arg = "entry->m_Dirty"
+            else:
+                dirty_arg = "true"
+        else:
+            entry_type = None
+            has_data = False
+        data_arg = "&entry->getDataBlk()" if has_data else "nullptr"
+
+        # The entries of a PerfectCacheMemory (e.g. the local directory of
+        # an L2) cannot be enumerated
+        perfect = None
+        for obj in self.objects:
+            if obj.type.ident == "PerfectCacheMemory":
+                perfect = obj.ident
+                break
+
+        # The directory entries are of the other AbstractCacheEntry type of
+        # the machine, if it has one. Their data block, if any, is saved
+        # with their other fields.
+        dir_entry_type = None
+        dir_fields = []
+        dir_unsupported = None
+        if len(self.DirEntryTypes) == 1:
+            dir_entry_type = self.DirEntryTypes[0].c_ident
+            dir_fields, dir_unsupported = self.snapshotFields(
+                self.DirEntryTypes[0], False
+            )
+        else:
+            # Without exactly one candidate, the type of the directory
+            # entries (allocated on load) is unknown
+            dir_unsupported = "type"
 
+        def refuse(code, struct, unsupported):
+            if unsupported == "type":
                 code(
                     """
-/** \\brief ${{action.desc}} */
-void
-$c_ident::${{action.ident}}(${{self.EntryType.c_ident}}*& m_cache_entry_ptr, Addr addr)
-{
-    DPRINTF(RubyGenerated, "executing ${{action.ident}}\\n");
-    ${{action["c_code"]}}
-}
-
+fatal("%s: the type of the directory entries is unknown, the cache "
+      "snapshot cannot hold them", m_${struct}_ptr->name());
 """
                 )
-        else:
-            for action in self.actions.values():
-                if "c_code" not in action:
-                    continue
-
+            else:
                 code(
                     """
-/** \\brief ${{action.desc}} */
-void
-$c_ident::${{action.ident}}(Addr addr)
-{
-    DPRINTF(RubyGenerated, "executing ${{action.ident}}\\n");
-    ${{action["c_code"]}}
-}
-
+fatal("%s: the cache snapshot cannot hold the ${unsupported} field of the "
+      "entries", m_${struct}_ptr->name());
 """
                 )
-        for func in self.functions:
-            code(func.generateCode())
 
-        # Function for functional writes to messages buffered in the controller
         code(
             """
-int
-$c_ident::functionalWriteBuffers(PacketPtr& pkt)
+
+void
+$c_ident::saveCacheSnapshot(CacheSnapshotWriter &snap)
 {
-    int num_functional_writes = 0;
 """
         )
-        for var in self.objects:
-            vtype = var.type
-            if vtype.isBuffer:
-                vid = "m_%s_ptr" % var.ident
-                code("num_functional_writes += $vid->functionalWrite(pkt);")
-
-        for var in self.config_parameters:
-            vtype = var.type_ast.type
-            if vtype.isBuffer:
-                vid = "m_%s_ptr" % var.ident
-                code("num_functional_writes += $vid->functionalWrite(pkt);")
-
+        code.indent()
+        if perfect:
+            code(
+                """
+fatal("%s: the cache snapshot cannot hold the entries of ${perfect}",
+      name());
+"""
+            )
+            caches = []
+            directories = []
+        for cache in caches:
+            if entry_unsupported:
+                refuse(code, cache, entry_unsupported)
+                continue
+            code(
+                """
+snap.beginSection(m_${cache}_ptr->name());
+m_${cache}_ptr->forEachEntry([&](AbstractCacheEntry *abs_entry) {
+    $entry_type *entry = static_cast<$entry_type *>(abs_entry);
+    CacheSnapshotFields fields(RubySystem::getBlockSizeBytes());
+"""
+            )
+            for field in entry_fields:
+                code("    fields.put(entry->${field});")
+            code(
+                """
+    snap.addRecord(entry->m_Address,
+                   getState(${tbe_arg}entry, entry->m_Address),
+                   entry->m_Permission, $dirty_arg, $data_arg,
+                   fields);
+});
+"""
+            )
+        for directory in directories:
+            if dir_unsupported:
+                refuse(code, directory, dir_unsupported)
+                continue
+            code(
+                """
+snap.beginSection(m_${directory}_ptr->name());
+m_${directory}_ptr->forEachEntry([&](AbstractCacheEntry *abs_entry) {
+    CacheSnapshotFields fields(RubySystem::getBlockSizeBytes());
+"""
+            )
+            if dir_fields:
+                code(
+                    """
+    $dir_entry_type *entry = static_cast<$dir_entry_type *>(abs_entry);
+"""
+                )
+            for field in dir_fields:
+                code("    fields.put(entry->${field});")
+            code(
+                """
+    snap.addRecord(abs_entry->m_Address,
+                   getState(${tbe_arg}${entry_arg}abs_entry->m_Address),
+                   abs_entry->m_Permission, false, nullptr, fields);
+});
+"""
+            )
+        code.dedent()
         code(
             """
-    return num_functional_writes;
 }
-"""
-        )
 
-        # Function for functional reads to messages buffered in the controller
-        code(
-            """
-bool
-$c_ident::functionalReadBuffers(PacketPtr& pkt)
+void
+$c_ident::loadCacheSnapshot(CacheSnapshot &snap)
 {
 """
         )
-        for var in self.objects:
-            vtype = var.type
-            if vtype.isBuffer:
-                vid = "m_%s_ptr" % var.ident
-                code("if ($vid->functionalRead(pkt)) return true;")
-
-        for var in self.config_parameters:
-            vtype = var.type_ast.type
-            if vtype.isBuffer:
-                vid = "m_%s_ptr" % var.ident
-                code("if ($vid->functionalRead(pkt)) return true;")
-
-        code(
-            """
-    return false;
+        code.indent()
+        if perfect:
+            code(
+                """
+fatal("%s: the cache snapshot cannot hold the entries of ${perfect}",
+      name());
+"""
+            )
+        for cache in caches:
+            if entry_unsupported:
+                refuse(code, cache, entry_unsupported)
+                continue
+            code(
+                """
+{
+    const CacheSnapshot::Section &section =
+        snap.section(m_${cache}_ptr->name());
+    for (uint64_t i = 0; i < section.size(); i++) {
+        CacheSnapshot::Record rec = section.record(i);
+        fatal_if(rec.state >= ${ident}_State_NUM,
+                 "%s: bad state for %#x in the cache snapshot",
+                 m_${cache}_ptr->name(), rec.addr);
+        fatal_if(!m_${cache}_ptr->cacheAvail(rec.addr),
+                 "%s: no room for %#x from the cache snapshot",
+                 m_${cache}_ptr->name(), rec.addr);
+
+        $entry_type *entry = static_cast<$entry_type *>(
+            m_${cache}_ptr->allocate(rec.addr, new $entry_type));
+"""
+            )
+            if has_data:
+                code(
+                    """
+        if (rec.hasData) {
+            entry->getDataBlk().setData(section.data(i), 0,
+                                        RubySystem::getBlockSizeBytes());
+        }
+"""
+                )
+            code(
+                """
+        CacheSnapshot::FieldReader fields = section.fields(i);
+"""
+            )
+            for field in entry_fields:
+                code("        fields.get(entry->${field});")
+            code(
+                """
+        fields.done();
+
+        ${ident}_State state = (${ident}_State)rec.state;
+        setState(${tbe_arg}entry, rec.addr, state);
+        setAccessPermission(entry, rec.addr, state);
+        fatal_if(entry->m_Permission != rec.perm,
+                 "%s: state %s of %#x does not match the cache snapshot",
+                 m_${cache}_ptr->name(), ${ident}_State_to_string(state),
+                 rec.addr);
+    }
 }
-
-bool
-$c_ident::functionalReadBuffers(PacketPtr& pkt, WriteMask &mask)
+"""
+            )
+        for directory in directories:
+            if dir_unsupported:
+                refuse(code, directory, dir_unsupported)
+                continue
+            code(
+                """
 {
-    bool read = false;
+    const CacheSnapshot::Section &section =
+        snap.section(m_${directory}_ptr->name());
+    for (uint64_t i = 0; i < section.size(); i++) {
+        CacheSnapshot::Record rec = section.record(i);
+        fatal_if(rec.state >= ${ident}_State_NUM ||
+                 !m_${directory}_ptr->isPresent(rec.addr),
+                 "%s: bad record for %#x in the cache snapshot",
+                 m_${directory}_ptr->name(), rec.addr);
+
+        // The entry holds its fields before setState checks them
+        AbstractCacheEntry *abs_entry = m_${directory}_ptr->lookup(rec.addr);
+        if (abs_entry == nullptr) {
+            abs_entry = new $dir_entry_type;
+            m_${directory}_ptr->allocate(rec.addr, abs_entry);
+        }
+        $dir_entry_type *entry = static_cast<$dir_entry_type *>(abs_entry);
+        CacheSnapshot::FieldReader fields = section.fields(i);
 """
-        )
-        for var in self.objects:
-            vtype = var.type
-            if vtype.isBuffer:
-                vid = "m_%s_ptr" % var.ident
-                code("if ($vid->functionalRead(pkt, mask)) read = true;")
-
-        for var in self.config_parameters:
-            vtype = var.type_ast.type
-            if vtype.isBuffer:
-                vid = "m_%s_ptr" % var.ident
-                code("if ($vid->functionalRead(pkt, mask)) read = true;")
-
+            )
+            for field in dir_fields:
+                code("        fields.get(entry->${field});")
+            code(
+                """
+        fields.done();
+
+        ${ident}_State state = (${ident}_State)rec.state;
+        setState(${tbe_arg}${entry_arg}rec.addr, state);
+        setAccessPermission(${entry_arg}rec.addr, state);
+        fatal_if(abs_entry->m_Permission != rec.perm,
+                 "%s: state %s of %#x does not match the cache snapshot",
+                 m_${directory}_ptr->name(),
+                 ${ident}_State_to_string(state), rec.addr);
+    }
+}
+"""
+            )
+        code.dedent()
         code(
             """
-    return read;
 }
 
-} // namespace ruby
-} // namespace gem5
 """
         )
 
-        code.write(path, "%s.cc" % c_ident)
-
     def printCWakeup(self, path, includes):
         """Output the wakeup loop for the events"""
 
@@ -1498,39 +1686,146 @@ ${ident}_Controller::wakeup()
 
         code.write(path, "%s_Wakeup.cc" % self.ident)
 
-    def printCSwitch(self, path):
+    def printActions(self, code):
+        """Output the actions, ahead of the transition switch that is their
+        only caller so that the compiler can inline them into it"""
+
+        ident = self.ident
+        c_ident = "%s_Controller" % self.ident
+
+        params = []
+        if self.TBEType != None:
+            params.append("%s*& m_tbe_ptr" % self.TBEType.c_ident)
+        if self.EntryType != None:
+            params.append("%s*& m_cache_entry_ptr" % self.EntryType.c_ident)
+        params.append("Addr addr")
+        params = ", ".join(params)
+
+        code(
+            """
+// Actions
+"""
+        )
+        for action in self.actions.values():
+            if "c_code" not in action:
+                continue
+
+            # Small actions are hinted inline; the larger ones are left to
+            # the compiler, which sees all of them from the switch anyway
+            c_code = action["c_code"]
+            lines = len([l for l in c_code.splitlines() if l.strip()])
+            qualifier = "inline " if lines <= self.inline_action_lines else ""
+
+            code(
+                """
+/** \\brief ${{action.desc}} */
+${qualifier}void
+$c_ident::${{action.ident}}($params)
+{
+    DPRINTF(RubyGenerated, "executing ${{action.ident}}\\n");
+"""
+            )
+            # Peeks of the wrong message type are only caught in machines
+            # with both a TBE and a cache entry, as they always were
+            if self.TBEType != None and self.EntryType != None:
+                code(
+                    """
+    try {
+       ${c_code}
+    } catch (const RejectException & e) {
+       fatal("Error in action ${{ident}}:${{action.ident}}: "
+             "executed a peek statement with the wrong message "
+             "type specified. ");
+    }
+"""
+                )
+            else:
+                code("    ${c_code}")
+            code(
+                """
+}
+
+"""
+            )
+
+    def printCSwitch(self, path, includes):
         """Output switch statement for transition table"""
 
         code = self.symtab.codeFormatter()
         ident = self.ident
 
+        # The actions are defined here as well, so this needs what the
+        # controller needs to compile them (see printControllerCC for the
+        # order of the BoolVec and cprintf includes)
         code(
             """
 // ${ident}: ${{self.short}}
 
+#include <sys/types.h>
+#include <unistd.h>
+
 #include <cassert>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <typeinfo>
+
+#include "mem/ruby/common/BoolVec.hh"
 
+#include "base/compiler.hh"
+#include "base/cprintf.hh"
 #include "base/logging.hh"
 #include "base/trace.hh"
-#include "debug/ProtocolTrace.hh"
-#include "debug/RubyGenerated.hh"
+
+"""
+        )
+        for f in sorted(self.debug_flags | {"ProtocolTrace", "RubyGenerated"}):
+            code('#include "debug/${{f}}.hh"')
+        code(
+            """
+#include "mem/ruby/network/Network.hh"
 #include "mem/ruby/protocol/${ident}_Controller.hh"
 #include "mem/ruby/protocol/${ident}_Event.hh"
 #include "mem/ruby/protocol/${ident}_State.hh"
 #include "mem/ruby/protocol/Types.hh"
 #include "mem/ruby/system/RubySystem.hh"
 
-#define HASH_FUN(state, event)  ((int(state)*${ident}_Event_NUM)+int(event))
+"""
+        )
+        for include_path in includes:
+            code('#include "${{include_path}}"')
+
+        seen_types = set()
+        for var in self.objects:
+            if var.type.ident not in seen_types and not var.type.isPrimitive:
+                code('#include "mem/ruby/protocol/${{var.type.c_ident}}.hh"')
+            seen_types.add(var.type.ident)
+
+        code(
+            """
 
 #define GET_TRANSITION_COMMENT() (${ident}_transitionComment.str())
 #define CLEAR_TRANSITION_COMMENT() (${ident}_transitionComment.str(""))
 
+#ifndef NDEBUG
+#define APPEND_TRANSITION_COMMENT(str) (${ident}_transitionComment << str)
+#else
+#define APPEND_TRANSITION_COMMENT(str) do {} while (0)
+#endif
+
 namespace gem5
 {
 
 namespace ruby
 {
 
+"""
+        )
+
+        self.printActions(code)
+
+        code(
+            """
 TransitionResult
 ${ident}_Controller::doTransition(${ident}_Event event,
 """
@@ -1677,12 +1972,12 @@ ${ident}_Controller::doTransitionWorker(${ident}_Event event,
 {
     m_curTransitionEvent = event;
     m_curTransitionNextState = next_state;
-    switch(HASH_FUN(state, event)) {
 """
         )
 
         # This map will allow suppress generating duplicate code
         cases = OrderedDict()
+        case_of = {}
 
         for trans in self.transitions:
             case_string = "%s_State_%s, %s_Event_%s" % (
@@ -1786,14 +2081,51 @@ if (!checkResourceAvailable(%s_RequestType_%s, addr)) {
                 cases[case] = []
 
             cases[case].append(case_string)
+            case_of[(trans.state, trans.event)] = case
+
+        # Number the unique code blocks from 1, 0 marking the invalid
+        # transitions, and look the block of a transition up in a dense
+        # table indexed by state and event. The switch on the number
+        # compiles to a single indirect jump to the block.
+        case_nums = {}
+        for case in cases:
+            case_nums[case] = len(case_nums) + 1
+        num_type = "uint8_t" if len(cases) < 256 else "uint16_t"
+
+        code(
+            """
+
+    static const $num_type transition_case[${ident}_State_NUM][${ident}_Event_NUM] = {
+"""
+        )
+        code.indent(2)
+        for state in self.states.values():
+            row = []
+            for event in self.events.values():
+                case = case_of.get((state, event), None)
+                row.append(str(case_nums[case]) if case else "0")
+            code("// ${ident}_State_${{state.ident}}")
+            code("{")
+            for i in range(0, len(row), 16):
+                code("    ${{', '.join(row[i:i + 16])}},")
+            code("},")
+        code.dedent(2)
+
+        code(
+            """
+    };
+
+    switch (transition_case[state][event]) {
+"""
+        )
 
         # Walk through all of the unique code blocks and spit out the
         # corresponding case statement elements
         for case, transitions in cases.items():
-            # Iterative over all the multiple transitions that share
-            # the same code
+            # Name the multiple transitions that share the same code
             for trans in transitions:
-                code("  case HASH_FUN($trans):")
+                code("  // $trans")
+            code("  case ${{case_nums[case]}}:")
             code("    $case\n")
 
         code(
@@ -326,7 +326,20 @@ $klass ${{self.c_ident}}$parent
 MsgPtr
 clone() const
 {
-     return std::shared_ptr<Message>(new ${{self.c_ident}}(*this));
+     return MsgPtr(new ${{self.c_ident}}(*this));
+}
+
+// allocated from a pool of ${{self.c_ident}} objects
+static void *
+operator new(size_t size)
+{
+    return ObjectPool<${{self.c_ident}}>::allocate(size);
+}
+
+static void
+operator delete(void *p, size_t size)
+{
+    ObjectPool<${{self.c_ident}}>::release(p, size);
 }
 """
             )
@@ -341,6 +354,58 @@ clone() const
 """
             )
 
+        # cache and directory entries: one per block, so keep them packed
+        if self.get("interface") == "AbstractCacheEntry":
+            code(
+                """
+// allocated from a pool of ${{self.c_ident}} objects
+static void *
+operator new(size_t size)
+{
+    return ObjectPool<${{self.c_ident}}>::allocate(size);
+}
+
+static void
+operator delete(void *p, size_t size)
+{
+    ObjectPool<${{self.c_ident}}>::release(p, size);
+}
+"""
+            )
+
+        # expose the data block of a message (the first one, if several)
+        if self.isMessage:
+            for dm in self.data_members.values():
+                if dm.type.c_ident == "DataBlock":
+                    code(
+                        """
+const DataBlock*
+getDataBlock() const
+{
+    return &m_${{dm.ident}};
+}
+"""
+                    )
+                    break
+
+        # the line functional accesses can match, which the protocols
+        # test against the addr (or LineAddress) field
+        if self.isMessage:
+            for ident in ("addr", "LineAddress"):
+                dm = self.data_members.get(ident)
+                if dm is not None and dm.type.c_ident == "Addr":
+                    code(
+                        """
+bool
+getFunctionalLine(Addr &line) const
+{
+    line = makeLineAddress(m_${{dm.ident}});
+    return true;
+}
+"""
+                    )
+                    break
+
         if not self.isGlobal:
             # const Get methods for each field
             code("// Const accessors methods for each field")